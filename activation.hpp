@@ -0,0 +1,251 @@
+#ifndef ACTIVATION_HPP_
+#define ACTIVATION_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <cstddef>
+#include <cmath>
+
+#include "simd_kernels.hpp"
+
+/********************************************************************************
+* activation: Aktiveringsfunktioner för dense-lagren. Varje lager väljer sin
+*             funktion via enumerationen type, medan beräkningarna sker i
+*             policyklasser (tanh_policy, relu_policy, sigmoid_policy och
+*             linear_policy) som väljs en gång per lager, så att looparna
+*             över noderna saknar villkorliga hopp för själva funktionsvalet.
+*
+*             Tanh kan beräknas exakt via std::tanh eller approximativt via en
+*             rationell funktion, som enbart består av multiplikationer,
+*             additioner och en division. Approximationen av en hel rad
+*             beräknas med vektorinstruktioner via simd::tanh. Sigmoid
+*             beräknas i det approximativa läget via samma funktion, eftersom
+*             sigmoid(x) = 0.5 * tanh(x / 2) + 0.5.
+*
+*             Derivatan beräknas alltid utifrån nodens lagrade utsignal y,
+*             exempelvis tanh'(x) = 1 - tanh(x)^2 = 1 - y^2, vilket gör att
+*             ingen transcendental funktion behövs vid backpropagering.
+********************************************************************************/
+namespace activation
+{
+	/********************************************************************************
+	* tanh_mode: Anger hur tanh beräknas.
+	*
+	*            - exact: Via std::tanh.
+	*            - fast : Via rationell approximation, största absoluta fel
+	*                     ca 4e-7 för både float och double.
+	********************************************************************************/
+	enum class tanh_mode { exact, fast };
+
+	/********************************************************************************
+	* type: Anger lagrets aktiveringsfunktion. Värdena motsvarar fältet
+	*       activation i modellfilens lagerposter och får därför inte ändras.
+	*
+	*       - tanh   : y = tanh(x), utsignal i intervallet (-1, 1).
+	*       - relu   : y = max(x, 0).
+	*       - sigmoid: y = 1 / (1 + e^-x), utsignal i intervallet (0, 1).
+	*       - linear : y = x, exempelvis för regression i utgångslagret.
+	********************************************************************************/
+	enum class type { tanh = 0, relu = 1, sigmoid = 2, linear = 3 };
+
+	/********************************************************************************
+	* tanh_fast: Approximerar tanh(x) med en rationell funktion av grad 13/6
+	*            (täljare/nämnare), se simd::detail::tanh_rational.
+	*
+	*            - x: Summan som ska aktiveras.
+	********************************************************************************/
+	template <typename T>
+	static inline T tanh_fast(const T x)
+	{
+		return simd::detail::tanh_rational(x);
+	}
+
+	/********************************************************************************
+	* tanh: Beräknar tanh(x) enligt angivet läge.
+	*
+	*       - x   : Summan som ska aktiveras.
+	*       - mode: Exakt eller approximativ beräkning.
+	********************************************************************************/
+	template <typename T>
+	static inline T tanh(const T x, const tanh_mode mode)
+	{
+		return mode == tanh_mode::fast ? tanh_fast(x) : std::tanh(x);
+	}
+
+	/********************************************************************************
+	* apply_tanh: Ersätter samtliga element i angiven buffert med tanh av
+	*             elementet. Läget kontrolleras en gång per buffert.
+	*
+	*             - data: Pekare till bufferten.
+	*             - n   : Antalet element.
+	*             - mode: Exakt eller approximativ beräkning.
+	********************************************************************************/
+	template <typename T>
+	static inline void apply_tanh(T* data, const std::size_t n, const tanh_mode mode)
+	{
+		if (mode == tanh_mode::fast)
+		{
+			simd::tanh(data, n);
+		}
+		else
+		{
+			for (std::size_t i = 0; i < n; ++i) data[i] = std::tanh(data[i]);
+		}
+
+		return;
+	}
+
+	/********************************************************************************
+	* delta_tanh: Returnerar derivatan av tanh uttryckt i utsignalen, dvs.
+	*             1 - y^2, där y = tanh(x) är nodens lagrade utsignal.
+	*
+	*             - output: Nodens utsignal.
+	********************************************************************************/
+	template <typename T>
+	static inline T delta_tanh(const T output)
+	{
+		return 1 - output * output;
+	}
+
+	/********************************************************************************
+	* tanh_policy: Tanh, exakt eller approximativ beroende på angivet läge.
+	********************************************************************************/
+	struct tanh_policy
+	{
+		template <typename T>
+		static inline void apply(T* data, const std::size_t n, const tanh_mode mode)
+		{
+			apply_tanh(data, n, mode);
+			return;
+		}
+
+		template <typename T>
+		static inline T derivative(const T output)
+		{
+			return delta_tanh(output);
+		}
+	};
+
+	/********************************************************************************
+	* relu_policy: ReLU, där noden är aktiverad (y = x) om summan överstiger 0,
+	*              annars inaktiverad (y = 0). Derivatan är 1 för aktiverade
+	*              noder och 0 för inaktiverade.
+	********************************************************************************/
+	struct relu_policy
+	{
+		template <typename T>
+		static inline void apply(T* data, const std::size_t n, const tanh_mode)
+		{
+			for (std::size_t i = 0; i < n; ++i) data[i] = data[i] > T(0) ? data[i] : T(0);
+			return;
+		}
+
+		template <typename T>
+		static inline T derivative(const T output)
+		{
+			return output > T(0) ? T(1) : T(0);
+		}
+	};
+
+	/********************************************************************************
+	* sigmoid_policy: Sigmoid, med derivatan y * (1 - y).
+	********************************************************************************/
+	struct sigmoid_policy
+	{
+		template <typename T>
+		static inline void apply(T* data, const std::size_t n, const tanh_mode mode)
+		{
+			if (mode == tanh_mode::fast)
+			{
+				for (std::size_t i = 0; i < n; ++i) data[i] *= T(0.5);
+				simd::tanh(data, n);
+				for (std::size_t i = 0; i < n; ++i) data[i] = T(0.5) * data[i] + T(0.5);
+			}
+			else
+			{
+				for (std::size_t i = 0; i < n; ++i) data[i] = T(1) / (T(1) + std::exp(-data[i]));
+			}
+
+			return;
+		}
+
+		template <typename T>
+		static inline T derivative(const T output)
+		{
+			return output * (T(1) - output);
+		}
+	};
+
+	/********************************************************************************
+	* linear_policy: Identitetsfunktionen, med derivatan 1.
+	********************************************************************************/
+	struct linear_policy
+	{
+		template <typename T>
+		static inline void apply(T*, const std::size_t, const tanh_mode)
+		{
+			return;
+		}
+
+		template <typename T>
+		static inline T derivative(const T)
+		{
+			return T(1);
+		}
+	};
+
+	/********************************************************************************
+	* dispatch: Anropar angivet funktionsobjekt med policyklassen för angiven
+	*           aktiveringsfunktion, dvs. function(tanh_policy()) och så vidare.
+	*           Används för att välja policy en gång per lager i stället för en
+	*           gång per nod.
+	*
+	*           - function_type: Aktiveringsfunktionen.
+	*           - function     : Funktionsobjekt med en mall för operator().
+	********************************************************************************/
+	template <typename Function>
+	static inline void dispatch(const type function_type, Function&& function)
+	{
+		switch (function_type)
+		{
+		case type::relu: function(relu_policy()); break;
+		case type::sigmoid: function(sigmoid_policy()); break;
+		case type::linear: function(linear_policy()); break;
+		default: function(tanh_policy()); break;
+		}
+
+		return;
+	}
+
+	/********************************************************************************
+	* multiply_derivative: Multiplicerar varje fel med aktiveringsfunktionens
+	*                      derivata, beräknad utifrån motsvarande utsignal,
+	*                      dvs. error[i] *= f'(output[i]).
+	*
+	*                      - function_type: Aktiveringsfunktionen.
+	*                      - output       : Pekare till lagrets utsignaler.
+	*                      - error        : Pekare till lagrets fel.
+	*                      - n            : Antalet element.
+	********************************************************************************/
+	template <typename Policy, typename T>
+	static inline void multiply_derivative(const T* output, T* error, const std::size_t n)
+	{
+		for (std::size_t i = 0; i < n; ++i) error[i] *= Policy::derivative(output[i]);
+		return;
+	}
+
+	template <typename T>
+	static inline void multiply_derivative(const type function_type, const T* output, T* error, const std::size_t n)
+	{
+		switch (function_type)
+		{
+		case type::relu: multiply_derivative<relu_policy>(output, error, n); break;
+		case type::sigmoid: multiply_derivative<sigmoid_policy>(output, error, n); break;
+		case type::linear: break;
+		default: multiply_derivative<tanh_policy>(output, error, n); break;
+		}
+
+		return;
+	}
+}
+
+#endif /* ACTIVATION_HPP_ */
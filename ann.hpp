@@ -1,268 +1,2072 @@
-#pragma once 
-
-#include "dense_layer.hpp"
-
-using namespace std;
-
-/********************************************************************************
-* ann: Denna klassen fr implimitering av nerualt ntver anvnds fr ett 
-*      ingngslager, dolt lager samt ett utgnglager med slumpmssig antal noder. 
-*      Trningsdata kan g frbi vi vektorer. Nr trningen har genomfrsts s 
-*      kan prediktion med utskrift genomfras med godtycklig indata eller med 
-*      indata frn frekommande trningsuppsttningar. 
-********************************************************************************/
-
-class ann {
-
-private:
-	vector<dense_layer> hidden_layers;
-	dense_layer output_layer;
-	vector<vector<double>> button_in;
-	vector<vector<double>> diod_out;
-	vector<size_t> train_order;
-
-	/********************************************************************************
-   * feedforward: Anvnds fr att berkna nya utsignaler fr samtliga noder i det 
-   *              neurala ntverk via angiven indata. 
-   *             
-   *
-   *              - input: anvnds till referns till vekttor innehllande ny indata
-   ********************************************************************************/
-
-	void feedforward(const vector<double>& input) {
-		this->hidden_layers[0].feedforward(input);
-
-		for (std::size_t i = 1; i < hidden_layers.size(); ++i)
-		{
-			this->hidden_layers[i].feedforward(this->hidden_layers[i - 1].output);
-		}
-		this->output_layer.feedforward(this->last_hidden_layer().output);
-		return;
-	}
-
-	/********************************************************************************
-   * backpropagate: Anvnds fr att berkna antal fel fr samtliga noder i angiven
-   *                neuralt ntverk via jmfrelse med referensdata innehllande 
-   *                korrekta utsignaler, som sedan jmfrs med det predikterade 
-   *                 utsignalen.                
-   *
-   *                - reference: : Referens till vektor innehllande korrekta vrden.
-   ********************************************************************************/
-
-	void backpropagate(const vector<double>& reference) {
-		this->output_layer.backpropagate(reference);
-		last_hidden_layer().backpropagate(this->output_layer);
-
-		for (std::size_t i = hidden_layers.size() - 1; i > 0; --i)
-		{
-			this->hidden_layers[i - 1].backpropagate(this->hidden_layers[i]);
-		}
-	}
-
-	/********************************************************************************
-   * optimize:
-   *           
-   *           
-   *
-   *           
-   *           - learning_rate:
-   *                            
-   ********************************************************************************/
-
-	void optimize(const vector<double>& input, const double learning_rate) {
-		first_hidden_layer().optimize(input, learning_rate);
-
-		for (size_t i = 1; i < this->hidden_layers.size(); i++) {
-			this->hidden_layers[i].optimize(this->hidden_layers[i - 1].output, learning_rate);
-		}
-
-		output_layer.optimize(last_hidden_layer().output, learning_rate);
-	}
-
-	dense_layer& first_hidden_layer(void) {
-		return this->hidden_layers[0];
-	}
-
-	dense_layer& last_hidden_layer(void) {
-		return this->hidden_layers[this->hidden_layers.size() - 1];
-	}
-
-	void shuffel(void) {
-		
-		for (size_t i = 0; i < this->train_order.size(); i++)
-		{
-			auto r = rand() % this->train_order.size();
-			auto copy = train_order[i];
-			train_order[i] = train_order[r];
-			train_order[r] = copy;
-
-		}
-		return;
-	}
-
-public:
-
-	ann(void) { cout << " Multi is created"; }
-
-
-	ann(const size_t num_inputs,
-		const size_t num_hidden_layers,
-		const size_t num_hidden_nodes,
-		const size_t num_outputs) {
-		this->init(num_inputs, num_hidden_layers, num_hidden_nodes, num_outputs);
-	}
-
-
-
-	~ann(void) {
-		this->clear();
-		return;
-	}
-
-	const vector<dense_layer>& get_hidden_layers(void) const {
-		return this->hidden_layers;
-	}
-
-	const dense_layer& get_output_layer(void) const {
-		return this->output_layer;
-	}
-
-	const vector<vector<double>>& get_button_in(void) const {
-		return this->button_in;
-	}
-
-	const vector<vector<double>>& get_diod_out(void) const {
-		return this->diod_out;
-	}
-
-
-
-	void init(const size_t num_inputs,
-		const size_t num_hidden_layers,
-		const size_t num_hidden_nodes,
-		const size_t num_outputs) {
-
-		dense_layer first_hidden(num_hidden_nodes, num_inputs);
-		hidden_layers.push_back(first_hidden);
-
-		this->output_layer.resize(num_outputs, num_hidden_nodes);
-
-		for (size_t i = 1; i < this->hidden_layers.size(); i++) {
-			dense_layer hidden_layer(num_hidden_nodes, num_hidden_nodes);
-			hidden_layers.push_back(hidden_layer);
-		}
-	}
-
-	void clear(void) {
-
-		this->hidden_layers.clear();
-		this->output_layer.clear();
-		this->button_in.clear();
-		this->diod_out.clear();
-		this->train_order.clear();
-		return;
-	}
-
-	void set_training_data(const vector<vector<double>>& button_in,
-		const vector<vector<double>>& diod_out) {
-		this->button_in = button_in;
-		this->diod_out = diod_out;
-
-		if (button_in.size() != diod_out.size()) {
-			size_t num_sets = 0;
-
-			if (button_in.size() < diod_out.size()) {
-				num_sets = button_in.size();
-			}
-			else {
-				num_sets = diod_out.size();
-			}
-
-			this->button_in.resize(num_sets);
-			this->diod_out.resize(num_sets);
-		}
-
-		this->train_order.resize(this->button_in.size());
-
-		for (size_t i = 0; i < this->train_order.size(); i++)
-		{
-			this->train_order[i] = i;
-		}
-
-		return;
-	}
-
-	void train(const size_t num_epochs,
-		const double learning_rate) {
-		for (size_t i = 0; i < num_epochs; i++) {
-			this->shuffel();
-
-			for (size_t j = 0; j < this->train_order.size(); j++) {
-				const auto index = this->train_order[j];
-				const auto& input = this->button_in[index];
-				const auto& reference = this->diod_out[index];
-
-				this->feedforward(input);
-				this->backpropagate(reference);
-				this->optimize(input, learning_rate);
-			}
-		}
-
-		return;
-	}
-
-	const vector<double>& predict(const vector<double>& input) {
-		this->feedforward(input);
-		return this->output_layer.output;
-	}
-
-	void print(const vector<vector<double>>& input,
-		const size_t num_decimals = 1,
-		ostream& ostream = cout,
-		const double threshold = 0.001) {
-
-		const auto& end = input[input.size() - 1];
-		if (input.size() == 0) return;
-
-		ostream << "-----------------------------------------------------------------\n";
-
-		for (auto& i : input) {
-			ostream << " Input: ";
-			dense_layer::print(i, ostream, num_decimals, threshold);
-
-
-			ostream << "Output: ";
-			dense_layer::print(this->predict(i), ostream, num_decimals, threshold);
-
-			if (&i < &end) ostream << "\n";
-		}
-
-		ostream << "-----------------------------------------------------------------\n\n";
-	}
-
-
-
-
-public:
-
-	/********************************************************************************
-	* print: Genomfr prediktion med samtliga befintliga trningsuppsttningars
-	*        indata och skriver ut predikterad utdata via angiven utstrm, dr
-	*        standardutenheten std::cout anvnds som default fr utskrift i
-	*        terminalen. Som default sker utskrift med en decimal. Vrden mellan
-	*        -0.001 samt 0.001 avrundas till noll vid utskrift.
-	*
-	*        - num_decimals: Antalet decimaler vid utskrift (default = 1).
-	*        - ostream     : Referens till godtycklig utstrm (default = std::cout).
-	*        - threshold   : Trskelvrde som anvnds fr att avrunda tal nra
-	*                        noll (default = 0.001).
-	********************************************************************************/
-	void print(const size_t num_decimals = 1,
-		ostream& ostream = std::cout,
-		const double threshold = 0.001)
-	{
-		this->print(this->button_in, num_decimals, ostream, threshold);
-		return;
-	}
-
-};
\ No newline at end of file
+#pragma once 
+
+#include "dense_layer.hpp"
+#include "thread_pool.hpp"
+#include "model_file.hpp"
+#include "training_monitor.hpp"
+#include "training_data.hpp"
+#include "profiling.hpp"
+
+#include <memory>
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <type_traits>
+#include <cctype>
+
+using namespace std;
+
+/********************************************************************************
+* ann: Denna klassen för implimitering av nerualt nätver används för ett 
+*      ingångslager, dolt lager samt ett utgånglager med slumpmässig antal noder. 
+*      Träningsdata kan gå föörbi vi vektorer. När träningen har genomförsts så 
+*      kan prediktion med utskrift genomföras med godtycklig indata eller med 
+*      indata från förekommande träningsuppsättningar. 
+********************************************************************************/
+
+/********************************************************************************
+* basic_training_context: Tillstånd och buffertar som behövs vid träning,
+*                         hållna åtskilda från nätverkets parametrar. Varje
+*                         tråd som tränar eller predikterar parallellt
+*                         använder en egen instans.
+********************************************************************************/
+template <typename T>
+struct basic_training_context {
+	vector<basic_layer_state<T>> layers;
+	vector<basic_layer_batch<T>> batches;
+	basic_matrix<T> batch_input;
+	basic_matrix<T> batch_reference;
+	basic_arena<T> scratch;
+	size_t num_gradients = 0;
+	double squared_error = 0.0;
+	size_t num_errors = 0;
+
+	/********************************************************************************
+	* zero_gradients: Nollställer samtliga lagers gradienter, som ligger
+	*                 sammanhängande först i arenan scratch.
+	********************************************************************************/
+	void zero_gradients(void) {
+		fill(this->scratch.data(), this->scratch.data() + this->num_gradients, T(0));
+	}
+
+	/********************************************************************************
+	* add_gradients: Adderar element first ... last - 1 av en annan tråds
+	*                gradienter till detta tillstånds gradienter. Eftersom
+	*                samtliga lagers gradienter ligger i ett sammanhängande
+	*                block räcker en enda axpy, oavsett antalet lager.
+	********************************************************************************/
+	void add_gradients(const basic_training_context& other, const size_t first, const size_t last) {
+		simd::axpy(T(1), other.scratch.data() + first, this->scratch.data() + first, last - first);
+	}
+
+	basic_layer_state<T>& output_state(void) {
+		return this->layers[this->layers.size() - 1];
+	}
+
+	const basic_layer_state<T>& output_state(void) const {
+		return this->layers[this->layers.size() - 1];
+	}
+};
+
+/********************************************************************************
+* basic_inference_context: Buffertar för prediktion med ett tränat nätverk.
+*                          Lagrens utsignaler skrivs växelvis till två
+*                          buffertar, medan utgångslagrets utsignaler skrivs
+*                          till output. Varje tråd som predikterar använder en
+*                          egen instans, medan själva nätverket kan delas
+*                          mellan trådarna.
+********************************************************************************/
+template <typename T>
+struct basic_inference_context {
+	vector<T> buffers[2];
+	vector<T> output;
+};
+
+/********************************************************************************
+* network_builder: Beskriver nätverkets topologi, dvs. antalet insignaler samt
+*                  antalet noder och aktiveringsfunktion för varje dolt lager
+*                  och för utgångslagret. Lagren kan ha olika bredd, exempelvis
+*                  ett djupt och smalt nätverk. Används av basic_ann::init:
+*
+*                  ann network(network_builder(4).hidden(16, activation::type::relu)
+*                      .hidden(8, activation::type::relu).output(1));
+********************************************************************************/
+struct network_builder {
+	struct layer {
+		size_t num_nodes;
+		activation::type activation;
+	};
+
+	size_t num_inputs = 0;
+	vector<layer> hidden_layers;
+	layer output_layer = { 0, activation::type::tanh };
+
+	explicit network_builder(const size_t num_inputs)
+		: num_inputs(num_inputs) { }
+
+	/********************************************************************************
+	* hidden: Lägger till ett dolt lager efter tidigare tillagda dolda lager.
+	*
+	*         - num_nodes : Antalet noder i lagret.
+	*         - activation: Lagrets aktiveringsfunktion (default tanh).
+	********************************************************************************/
+	network_builder& hidden(const size_t num_nodes,
+		const activation::type activation = activation::type::tanh) {
+		this->hidden_layers.push_back(layer{ num_nodes, activation });
+		return *this;
+	}
+
+	/********************************************************************************
+	* hidden: Lägger till ett dolt lager per angiven bredd, samtliga med samma
+	*         aktiveringsfunktion.
+	*
+	*         - widths    : Antalet noder i respektive lager.
+	*         - activation: Lagrens aktiveringsfunktion (default tanh).
+	********************************************************************************/
+	network_builder& hidden(const vector<size_t>& widths,
+		const activation::type activation = activation::type::tanh) {
+		for (const auto num_nodes : widths) {
+			this->hidden(num_nodes, activation);
+		}
+		return *this;
+	}
+
+	network_builder& output(const size_t num_outputs,
+		const activation::type activation = activation::type::tanh) {
+		this->output_layer = layer{ num_outputs, activation };
+		return *this;
+	}
+
+	/********************************************************************************
+	* valid: Returnerar true om topologin har insignaler, minst ett dolt lager
+	*        och inget lager utan noder.
+	********************************************************************************/
+	bool valid(void) const {
+		if (this->num_inputs == 0 || this->output_layer.num_nodes == 0 || this->hidden_layers.empty()) return false;
+
+		for (const auto& layer : this->hidden_layers) {
+			if (layer.num_nodes == 0) return false;
+		}
+
+		return true;
+	}
+};
+
+/********************************************************************************
+* basic_ann: Nätverket med parametrar, tränings- och prediktionsdata av typen
+*            T (double eller float). Typnamnen nedan gör att klassens kod är
+*            densamma oavsett elementtyp. Klassen ann motsvarar basic_ann<double>.
+********************************************************************************/
+template <typename T>
+class basic_ann {
+
+public:
+	typedef T value_type;
+	typedef basic_dense_layer<T> dense_layer;
+	typedef basic_training_context<T> training_context;
+	typedef basic_inference_context<T> inference_context;
+	typedef basic_matrix<T> matrix;
+	typedef basic_matrix_view<T> matrix_view;
+	typedef basic_const_matrix_view<T> const_matrix_view;
+	typedef optimizer::basic_state<T> optimizer_state;
+	typedef optimizer::basic_step<T> optimizer_step;
+	typedef basic_sample_view<T> sample_view;
+	typedef basic_sample_stream<T> sample_stream;
+
+private:
+	static constexpr size_t batch_block_rows = 64;
+	static constexpr size_t parallel_min_rows = 4 * batch_block_rows;
+
+	vector<dense_layer> hidden_layers;
+	dense_layer output_layer;
+	matrix sample_inputs;
+	matrix sample_references;
+	sample_view button_in;
+	sample_view diod_out;
+	vector<size_t> train_order;
+	training_context context;
+	vector<training_context> worker_contexts;
+	shared_ptr<mapped_file> storage;
+	basic_arena<T> parameters;
+	vector<uint64_t> truth_table;
+	size_t truth_table_bits = 0;
+	activation::tanh_mode activation_mode = activation::tanh_mode::exact;
+	activation::type hidden_activation = activation::type::tanh;
+	activation::type output_activation = activation::type::tanh;
+	optimizer::settings optimizer_settings;
+	optimizer::schedule rate_schedule;
+	vector<optimizer_state> optimizer_states;
+	size_t optimizer_updates = 0;
+	training::stopping stop_criteria;
+	training::callback progress_callback;
+	prng::generator generator;
+	prng::init_scheme weight_init = prng::init_scheme::automatic;
+
+	/********************************************************************************
+   * feedforward: Används för att berkna nya utsignaler för samtliga noder i det 
+   *              neurala nätverk via angiven indata. 
+   *             
+   *
+   *              - input  : används till referns till vekttor innehållande ny indata
+   *              - context: Tillstånd som tilldelas lagrens utsignaler.
+   ********************************************************************************/
+
+	void feedforward(const vector<T>& input, training_context& context) const {
+		this->feedforward(input.data(), input.size(), context);
+	}
+
+	void feedforward(const T* input, const size_t num_inputs, training_context& context) const {
+		{
+			const profiling::layer_scope scope(profiling::phase::forward, 0);
+			this->hidden_layers[0].feedforward(input, num_inputs, context.layers[0].output.data());
+		}
+
+		for (std::size_t i = 1; i < hidden_layers.size(); ++i)
+		{
+			const profiling::layer_scope scope(profiling::phase::forward, i);
+			this->hidden_layers[i].feedforward(context.layers[i - 1].output, context.layers[i]);
+		}
+
+		const profiling::layer_scope scope(profiling::phase::forward, hidden_layers.size());
+		this->output_layer.feedforward(context.layers[hidden_layers.size() - 1].output, context.output_state());
+		return;
+	}
+
+	/********************************************************************************
+   * backpropagate: Används för att beräkna antal fel för samtliga noder i angiven
+   *                neuralt nätverk via jämförelse med referensdata innehållande 
+   *                korrekta utsignaler, som sedan jämförs med det predikterade 
+   *                 utsignalen.                
+   *
+   *                - reference: : Referens till vektor innehållande korrekta värden.
+   *                - context    : Tillstånd som tilldelas lagrens fel.
+   ********************************************************************************/
+
+	void backpropagate(const vector<T>& reference, training_context& context) const {
+		this->backpropagate(reference.data(), reference.size(), context);
+	}
+
+	void backpropagate(const T* reference, const size_t num_references, training_context& context) const {
+		const auto num_hidden = this->hidden_layers.size();
+
+		{
+			const profiling::layer_scope scope(profiling::phase::backprop, num_hidden);
+			this->output_layer.backpropagate(reference, num_references, context.output_state());
+			this->add_squared_error(reference, context.output_state().output.data(),
+				min(num_references, this->output_layer.num_nodes()), context);
+		}
+
+		{
+			const profiling::layer_scope scope(profiling::phase::backprop, num_hidden - 1);
+			this->hidden_layers[num_hidden - 1].backpropagate(this->output_layer, context.output_state(), context.layers[num_hidden - 1]);
+		}
+
+		for (std::size_t i = num_hidden - 1; i > 0; --i)
+		{
+			const profiling::layer_scope scope(profiling::phase::backprop, i - 1);
+			this->hidden_layers[i - 1].backpropagate(this->hidden_layers[i], context.layers[i], context.layers[i - 1]);
+		}
+	}
+
+	/********************************************************************************
+   * optimize: Justerar vikter och bias i samtliga lager utifrån felen som
+   *           beräknats vid föregående backpropagering, med vald metod.
+   *           optimize_sgd använder alltid den ursprungliga metoden.
+   *
+   *           - input        : Indata som användes vid feedforward.
+   *           - context      : Tillstånd med lagrens utsignaler och fel.
+   *           - learning_rate: Lärhastigheten.
+   ********************************************************************************/
+
+	void optimize(const T* input, const size_t num_inputs, const training_context& context, const T learning_rate) {
+		if (this->optimizer_settings.method != optimizer::type::sgd) {
+			const auto step = this->next_optimizer_step(learning_rate);
+
+			{
+				const profiling::layer_scope scope(profiling::phase::optimize, 0);
+				first_hidden_layer().optimize(input, num_inputs, context.layers[0], step, this->optimizer_states[0]);
+			}
+
+			for (size_t i = 1; i < this->hidden_layers.size(); i++) {
+				const profiling::layer_scope scope(profiling::phase::optimize, i);
+				this->hidden_layers[i].optimize(context.layers[i - 1].output, context.layers[i], step, this->optimizer_states[i]);
+			}
+
+			const profiling::layer_scope scope(profiling::phase::optimize, this->hidden_layers.size());
+			output_layer.optimize(context.layers[this->hidden_layers.size() - 1].output, context.output_state(),
+				step, this->optimizer_states.back());
+			return;
+		}
+
+		this->optimize_sgd(input, num_inputs, context, learning_rate);
+	}
+
+	void optimize_sgd(const T* input, const size_t num_inputs, const training_context& context, const T learning_rate) {
+		{
+			const profiling::layer_scope scope(profiling::phase::optimize, 0);
+			first_hidden_layer().optimize(input, num_inputs, context.layers[0], learning_rate);
+		}
+
+		for (size_t i = 1; i < this->hidden_layers.size(); i++) {
+			const profiling::layer_scope scope(profiling::phase::optimize, i);
+			this->hidden_layers[i].optimize(context.layers[i - 1].output, context.layers[i], learning_rate);
+		}
+
+		const profiling::layer_scope scope(profiling::phase::optimize, this->hidden_layers.size());
+		output_layer.optimize(context.layers[this->hidden_layers.size() - 1].output, context.output_state(), learning_rate);
+	}
+
+	/********************************************************************************
+   * init_optimizer: Allokerar tillståndsbuffertar för vald metod, en per lager,
+   *                 om de saknas eller inte stämmer med lagrens storlek.
+   *                 Befintliga moment behålls annars mellan anropen av train.
+   ********************************************************************************/
+
+	void init_optimizer(void) {
+		const auto num_layers = this->hidden_layers.size() + 1;
+		bool matches = this->optimizer_states.size() == num_layers;
+
+		for (size_t i = 0; matches && i < num_layers; i++) {
+			const auto& layer = i < this->hidden_layers.size() ? this->hidden_layers[i] : this->output_layer;
+			matches = this->optimizer_states[i].matches(layer.num_nodes(), layer.num_weights());
+		}
+
+		if (this->optimizer_settings.method == optimizer::type::sgd || matches) return;
+
+		this->optimizer_states.resize(num_layers);
+		this->optimizer_updates = 0;
+
+		for (size_t i = 0; i < num_layers; i++) {
+			const auto& layer = i < this->hidden_layers.size() ? this->hidden_layers[i] : this->output_layer;
+			this->optimizer_states[i].resize(layer.num_nodes(), layer.num_weights());
+		}
+	}
+
+	optimizer_step next_optimizer_step(const T learning_rate) {
+		return optimizer_step::make(this->optimizer_settings, learning_rate, ++this->optimizer_updates);
+	}
+
+	/********************************************************************************
+   * epoch_rate: Returnerar lärhastigheten för angiven epok enligt valt schema.
+   ********************************************************************************/
+
+	T epoch_rate(const T learning_rate, const size_t epoch, const size_t num_epochs) const {
+		return static_cast<T>(this->rate_schedule.rate(learning_rate, epoch, num_epochs));
+	}
+
+	/********************************************************************************
+   * init_context: Allokerar tillstånd för samtliga lager samt, om batch_size
+   *               är större än noll, buffertar för minibatcher med angiven
+   *               storlek. Befintliga buffertar återanvänds om storleken redan
+   *               stämmer.
+   *
+   *               - context   : Tillståndet som ska allokeras.
+   *               - batch_size: Antalet träningsuppsättningar per batch.
+   ********************************************************************************/
+
+	void init_context(training_context& context, const size_t batch_size) const {
+		const auto num_layers = this->hidden_layers.size() + 1;
+
+		if (context.layers.size() != num_layers) {
+			context.layers.resize(num_layers);
+
+			for (size_t i = 0; i < this->hidden_layers.size(); i++) {
+				context.layers[i].resize(this->hidden_layers[i].num_nodes());
+			}
+
+			context.output_state().resize(this->output_layer.num_nodes());
+		}
+
+		if (batch_size == 0 || (context.batches.size() == num_layers && context.batch_input.rows() == batch_size)) return;
+
+		typedef basic_layer_batch<T> batch_type;
+		const auto num_inputs = this->hidden_layers[0].num_weights();
+		const auto num_outputs = this->output_layer.num_nodes();
+		size_t num_gradients = 0;
+		size_t num_buffers = basic_arena<T>::padded(batch_size * matrix::stride_for(num_inputs)) +
+			basic_arena<T>::padded(batch_size * matrix::stride_for(num_outputs));
+
+		for (size_t i = 0; i < num_layers; i++) {
+			const auto& layer = i < this->hidden_layers.size() ? this->hidden_layers[i] : this->output_layer;
+			num_gradients += batch_type::gradient_count(layer.num_nodes(), layer.num_weights());
+			num_buffers += batch_type::buffer_count(batch_size, layer.num_nodes());
+		}
+
+		/* Gradienterna placeras först och utan mellanrum i arenan, så att de
+		   kan nollställas och summeras mellan trådar som ett enda block: */
+		context.batches.resize(num_layers);
+		context.scratch.reserve(num_gradients + num_buffers);
+
+		for (size_t i = 0; i < num_layers; i++) {
+			const auto& layer = i < this->hidden_layers.size() ? this->hidden_layers[i] : this->output_layer;
+			context.batches[i].attach_gradients(context.scratch, layer.num_nodes(), layer.num_weights());
+		}
+
+		context.num_gradients = context.scratch.size();
+
+		for (size_t i = 0; i < num_layers; i++) {
+			const auto& layer = i < this->hidden_layers.size() ? this->hidden_layers[i] : this->output_layer;
+			context.batches[i].attach_buffers(context.scratch, batch_size, layer.num_nodes());
+		}
+
+		const auto input_stride = matrix::stride_for(num_inputs);
+		const auto reference_stride = matrix::stride_for(num_outputs);
+		context.batch_input.attach(context.scratch.allocate(batch_size * input_stride), batch_size, num_inputs, input_stride);
+		context.batch_reference.attach(context.scratch.allocate(batch_size * reference_stride), batch_size, num_outputs, reference_stride);
+	}
+
+	/********************************************************************************
+   * pack_batch: Kopierar träningsuppsättningarna med angivna index radvis till
+   *             batchens buffertar.
+   ********************************************************************************/
+
+	void pack_batch(const size_t* indices, const size_t count, training_context& context) const {
+		for (size_t r = 0; r < count; r++) {
+			const auto index = indices[r];
+			pack_row(this->button_in.row(index), this->button_in.cols, context.batch_input.row(r), context.batch_input.cols());
+			pack_row(this->diod_out.row(index), this->diod_out.cols, context.batch_reference.row(r), context.batch_reference.cols());
+		}
+	}
+
+	static uint64_t threshold_outputs(const vector<T>& output) {
+		uint64_t bits = 0;
+
+		for (size_t i = 0; i < output.size() && i < 64; i++) {
+			if (output[i] + 0.5 >= 1.0) bits |= static_cast<uint64_t>(1) << i;
+		}
+
+		return bits;
+	}
+
+	static void write_bytes(vector<unsigned char>& image, const uint64_t offset, const void* data, const size_t size) {
+		const auto source = static_cast<const unsigned char*>(data);
+		copy(source, source + size, image.begin() + static_cast<ptrdiff_t>(offset));
+	}
+
+	static void pack_row(const vector<T>& source, T* destination, const size_t cols) {
+		pack_row(source.data(), source.size(), destination, cols);
+	}
+
+	static void pack_row(const T* source, const size_t source_cols, T* destination, const size_t cols) {
+		for (size_t j = 0; j < cols; j++) {
+			destination[j] = j < source_cols ? source[j] : T(0);
+		}
+	}
+
+	/********************************************************************************
+   * write_literal: Skriver value som en flyttalslitteral med tillräckligt många
+   *                siffror för att värdet ska läsas in exakt, följt av suffix.
+   ********************************************************************************/
+
+	static void write_literal(ostream& ostream, const T value, const char* suffix) {
+		const auto flags = ostream.flags();
+		const auto precision = ostream.precision();
+
+		ostream << scientific << setprecision(numeric_limits<T>::max_digits10 - 1) << value
+			<< (is_same<T, float>::value ? "f" : "") << suffix;
+		ostream.flags(flags);
+		ostream.precision(precision);
+	}
+
+	static const char* source_activation(const activation::type function, const activation::tanh_mode mode) {
+		const auto fast = mode == activation::tanh_mode::fast;
+
+		switch (function) {
+		case activation::type::relu: return "relu";
+		case activation::type::sigmoid: return fast ? "sigmoid_fast" : "sigmoid";
+		case activation::type::linear: return "";
+		default: return fast ? "tanh_fast" : "std::tanh";
+		}
+	}
+
+	/********************************************************************************
+   * pack_samples: Kopierar angivna rader till en egen matris med lika många
+   *               kolumner som den längsta raden, där kortare rader fylls ut
+   *               med nollor, och returnerar en vy över kopian.
+   ********************************************************************************/
+
+	static sample_view pack_samples(const vector<vector<T>>& rows, const size_t num_rows, matrix& destination) {
+		size_t cols = 0;
+
+		for (size_t i = 0; i < num_rows; i++) {
+			cols = max(cols, rows[i].size());
+		}
+
+		destination.resize(num_rows, cols);
+
+		for (size_t i = 0; i < num_rows; i++) {
+			pack_row(rows[i], destination.row(i), cols);
+		}
+
+		return sample_view(destination.data(), num_rows, cols, destination.stride());
+	}
+
+	/********************************************************************************
+   * rebind_samples: Returnerar vyn view från ett annat nätverk, där vyer över
+   *                 det nätverkets egen kopia (source) pekas om till denna
+   *                 nätverks kopia (destination). Vyer över externa data delas.
+   ********************************************************************************/
+
+	static sample_view rebind_samples(const sample_view& view, const matrix& source, const matrix& destination) {
+		if (view.rows || view.data != source.data() || source.empty()) return view;
+		return sample_view(destination.data(), view.num_rows, view.cols, destination.stride());
+	}
+
+	/********************************************************************************
+   * compute_gradients: Genomför feedforward och backpropagering för count
+   *                    träningsuppsättningar med angivna index och summerar
+   *                    gradienterna i angivet tillstånd. Nätverkets parametrar
+   *                    lämnas orörda, vilket gör att flera trådar kan beräkna
+   *                    gradienter samtidigt med var sitt tillstånd.
+   ********************************************************************************/
+
+	void compute_gradients(const size_t* indices, const size_t count, training_context& context) const {
+		const auto num_hidden = this->hidden_layers.size();
+		auto& batches = context.batches;
+		auto& out = batches[num_hidden];
+
+		context.zero_gradients();
+		this->pack_batch(indices, count, context);
+		profiling::add_samples(count);
+
+		{
+			const profiling::layer_scope scope(profiling::phase::forward, 0);
+			this->hidden_layers[0].feedforward_batch(context.batch_input.view(count), batches[0].output.view(count));
+		}
+
+		for (size_t i = 1; i < num_hidden; i++) {
+			const profiling::layer_scope scope(profiling::phase::forward, i);
+			this->hidden_layers[i].feedforward_batch(batches[i - 1].output.view(count), batches[i].output.view(count));
+		}
+
+		{
+			const profiling::layer_scope scope(profiling::phase::forward, num_hidden);
+			this->output_layer.feedforward_batch(batches[num_hidden - 1].output.view(count), out.output.view(count));
+		}
+
+		{
+			const profiling::layer_scope scope(profiling::phase::backprop, num_hidden);
+
+			for (size_t r = 0; r < count; r++) {
+				this->add_squared_error(context.batch_reference.row(r), out.output.row(r), this->output_layer.num_nodes(), context);
+			}
+
+			this->output_layer.backpropagate_batch(context.batch_reference.view(count), out.output.view(count), out.error.view(count));
+		}
+
+		for (size_t i = num_hidden; i > 0; i--) {
+			const profiling::layer_scope scope(profiling::phase::backprop, i - 1);
+			const auto& next_layer = i == num_hidden ? this->output_layer : this->hidden_layers[i];
+			this->hidden_layers[i - 1].backpropagate_batch(next_layer, batches[i].error.view(count),
+				batches[i - 1].output.view(count), batches[i - 1].error.view(count));
+		}
+
+		/* Gradienterna räknas till backpropageringen för respektive lager: */
+		for (size_t i = 0; i <= num_hidden; i++) {
+			const profiling::layer_scope scope(profiling::phase::backprop, i);
+			const auto& layer = i < num_hidden ? this->hidden_layers[i] : this->output_layer;
+			auto& batch = batches[i];
+			const auto input = i == 0 ? context.batch_input.view(count) : batches[i - 1].output.view(count);
+			layer.accumulate_gradients(input, batch.error.view(count), batch.weight_gradient.view(), batch.bias_gradient.data());
+		}
+	}
+
+	/********************************************************************************
+   * apply_gradients: Uppdaterar samtliga lager med gradienterna i angivet
+   *                  tillstånd, summerade över count träningsuppsättningar.
+   ********************************************************************************/
+
+	void apply_gradients(const training_context& context, const T learning_rate, const size_t count) {
+		if (this->optimizer_settings.method != optimizer::type::sgd) {
+			const auto step = this->next_optimizer_step(learning_rate);
+			const auto scale = T(1) / count;
+
+			for (size_t i = 0; i <= this->hidden_layers.size(); i++) {
+				const profiling::layer_scope scope(profiling::phase::optimize, i);
+				auto& layer = i < this->hidden_layers.size() ? this->hidden_layers[i] : this->output_layer;
+				const auto& batch = context.batches[i];
+				layer.apply_gradients(batch.weight_gradient.view(), batch.bias_gradient.data(), scale, step, this->optimizer_states[i]);
+			}
+
+			return;
+		}
+
+		const auto scale = learning_rate / count;
+
+		for (size_t i = 0; i < this->hidden_layers.size(); i++) {
+			const profiling::layer_scope scope(profiling::phase::optimize, i);
+			const auto& batch = context.batches[i];
+			this->hidden_layers[i].apply_gradients(batch.weight_gradient.view(), batch.bias_gradient.data(), scale);
+		}
+
+		const profiling::layer_scope scope(profiling::phase::optimize, this->hidden_layers.size());
+		const auto& out = context.batches[this->hidden_layers.size()];
+		this->output_layer.apply_gradients(out.weight_gradient.view(), out.bias_gradient.data(), scale);
+	}
+
+	/********************************************************************************
+   * predict_blocks: Predikterar block first ... last - 1 om batch_block_rows
+   *                 rader vardera. Utgångslagret skriver direkt till outputs,
+   *                 medan dolda lager använder två lokala buffertar växelvis.
+   ********************************************************************************/
+
+	void predict_blocks(const const_matrix_view& inputs, const matrix_view& outputs,
+		const size_t first, const size_t last) const {
+		size_t width = 0;
+
+		for (const auto& layer : this->hidden_layers) {
+			if (layer.num_nodes() > width) width = layer.num_nodes();
+		}
+
+		matrix buffers[2] = { matrix(batch_block_rows, width), matrix(batch_block_rows, width) };
+
+		for (size_t block = first; block < last; block++) {
+			const auto r0 = block * batch_block_rows;
+			const auto count = r0 + batch_block_rows < inputs.rows ? batch_block_rows : inputs.rows - r0;
+			const_matrix_view x(inputs.row(r0), count, inputs.cols, inputs.stride);
+
+			for (size_t i = 0; i < this->hidden_layers.size(); i++) {
+				auto& buffer = buffers[i % 2];
+				const matrix_view y(buffer.data(), count, this->hidden_layers[i].num_nodes(), buffer.stride());
+				this->hidden_layers[i].feedforward_batch(x, y);
+				x = y;
+			}
+
+			this->output_layer.feedforward_batch(x, matrix_view(outputs.row(r0), count, outputs.cols, outputs.stride));
+		}
+	}
+
+	/********************************************************************************
+   * add_squared_error: Adderar kvadraten av avvikelsen mellan referens och
+   *                    utsignal för n utsignaler till angivet tillstånd, som
+   *                    underlag för medelkvadratfelet per epok.
+   ********************************************************************************/
+
+	static void add_squared_error(const T* reference, const T* output, const size_t n, training_context& context) {
+		for (size_t i = 0; i < n; i++) {
+			const double deviation = static_cast<double>(reference[i]) - static_cast<double>(output[i]);
+			context.squared_error += deviation * deviation;
+		}
+
+		context.num_errors += n;
+	}
+
+	/********************************************************************************
+   * take_loss: Returnerar medelkvadratfelet som summerats i angivna tillstånd
+   *            sedan föregående anrop och nollställer summorna.
+   ********************************************************************************/
+
+	static double take_loss(training_context* contexts, const size_t num_contexts) {
+		double squared_error = 0.0;
+		size_t num_errors = 0;
+
+		for (size_t i = 0; i < num_contexts; i++) {
+			squared_error += contexts[i].squared_error;
+			num_errors += contexts[i].num_errors;
+			contexts[i].squared_error = 0.0;
+			contexts[i].num_errors = 0;
+		}
+
+		return num_errors ? squared_error / num_errors : 0.0;
+	}
+
+	/********************************************************************************
+   * train_batch: Genomför feedforward, backpropagering och en gemensam
+   *              viktuppdatering för count träningsuppsättningar med start
+   *              på position first i train_order. Gradienterna medelvärdesbildas
+   *              över batchen.
+   ********************************************************************************/
+
+	void train_batch(const size_t first, const size_t count, const T learning_rate) {
+		this->compute_gradients(this->train_order.data() + first, count, this->context);
+		this->apply_gradients(this->context, learning_rate, count);
+	}
+
+	/********************************************************************************
+   * train_epoch: Blandar träningsordningen och tränar en gång på samtliga
+   *              aktuella träningsuppsättningar, uppsättning för uppsättning
+   *              om batch_size är 1 eller mindre och annars med minibatcher.
+   *              Tillståndet måste redan vara allokerat för batch_size.
+   ********************************************************************************/
+
+	void train_epoch(const T learning_rate, const size_t batch_size) {
+		this->shuffle();
+
+		if (batch_size <= 1) {
+			profiling::add_samples(this->train_order.size());
+
+			for (size_t j = 0; j < this->train_order.size(); j++) {
+				const auto index = this->train_order[j];
+				const auto input = this->button_in.row(index);
+
+				this->feedforward(input, this->button_in.cols, this->context);
+				this->backpropagate(this->diod_out.row(index), this->diod_out.cols, this->context);
+				this->optimize(input, this->button_in.cols, this->context, learning_rate);
+			}
+
+			return;
+		}
+
+		for (size_t j = 0; j < this->train_order.size(); j += batch_size) {
+			const auto count = j + batch_size < this->train_order.size() ? batch_size : this->train_order.size() - j;
+			this->train_batch(j, count, learning_rate);
+		}
+	}
+
+	void reset_train_order(const size_t num_sets) {
+		this->train_order.resize(num_sets);
+
+		for (size_t i = 0; i < num_sets; i++) {
+			this->train_order[i] = i;
+		}
+	}
+
+	/********************************************************************************
+   * reduce_gradients: Summerar gradienterna från samtliga trådars tillstånd till
+   *                   worker_contexts[0]. Gradienterna ligger sammanhängande i
+   *                   varje tillstånds arena, så blocket delas i lika stora
+   *                   delar (hela cache-rader), där varje tråd summerar sin del
+   *                   från samtliga tillstånd i ett enda parallellt steg.
+   ********************************************************************************/
+
+	void reduce_gradients(thread_pool& pool) {
+		const auto num_contexts = this->worker_contexts.size();
+		const auto num_gradients = this->worker_contexts[0].num_gradients;
+		const auto num_lines = num_gradients / basic_arena<T>::alignment;
+
+		pool.run([&](const size_t id) {
+			const auto first = num_lines * id / pool.size() * basic_arena<T>::alignment;
+			const auto last = num_lines * (id + 1) / pool.size() * basic_arena<T>::alignment;
+			auto& destination = this->worker_contexts[0];
+
+			for (size_t i = 1; i < num_contexts && first < last; i++) {
+				destination.add_gradients(this->worker_contexts[i], first, last);
+			}
+		});
+	}
+
+	/********************************************************************************
+	* max_hidden_width: Returnerar antalet noder i det bredaste dolda lagret,
+	*                   dvs. den storlek som prediktionens buffertar behöver.
+	********************************************************************************/
+	size_t max_hidden_width(void) const {
+		size_t width = 0;
+
+		for (const auto& layer : this->hidden_layers) {
+			if (layer.num_nodes() > width) width = layer.num_nodes();
+		}
+
+		return width;
+	}
+
+	/********************************************************************************
+	* context_fits: Indikerar ifall angivet tillstånd har allokerats för
+	*               nätverkets nuvarande topologi, dvs. om buffertarna rymmer
+	*               det bredaste dolda lagret och utsignalerna från utgångslagret.
+	*
+	*               - context: Tillståndet som ska kontrolleras.
+	********************************************************************************/
+	bool context_fits(const inference_context& context) const {
+		const auto width = this->max_hidden_width();
+		return context.output.size() == this->output_layer.num_nodes() &&
+			context.buffers[0].size() >= width && context.buffers[1].size() >= width;
+	}
+
+	dense_layer& first_hidden_layer(void) {
+		return this->hidden_layers[0];
+	}
+
+	dense_layer& last_hidden_layer(void) {
+		return this->hidden_layers[this->hidden_layers.size() - 1];
+	}
+
+	void shuffle(void) {
+		prng::shuffle(this->train_order.data(), this->train_order.size(), this->generator);
+		return;
+	}
+
+	/********************************************************************************
+	* initialize_weights: Drar nya startvärden för samtliga lager från
+	*                     nätverkets generator, i lagerordning. Metodens moment
+	*                     och eventuell sanningstabell nollställs, eftersom de
+	*                     hör till de tidigare vikterna.
+	********************************************************************************/
+	void initialize_weights(void) {
+		for (auto& layer : this->hidden_layers) {
+			layer.initialize(this->generator, this->weight_init);
+		}
+
+		this->output_layer.initialize(this->generator, this->weight_init);
+		this->reset_optimizer();
+		this->truth_table.clear();
+	}
+
+	/********************************************************************************
+	* pack_parameters: Flyttar samtliga lagers bias och vikter till en ny
+	*                  gemensam arena, lager för lager i nätverkets ordning.
+	*                  Parametrarnas värden behålls. Arenan ersätter en
+	*                  eventuell tidigare arena först när samtliga lager har
+	*                  kopierats, eftersom lagren kan peka in i den.
+	********************************************************************************/
+	void pack_parameters(void) {
+		basic_arena<T> arena;
+		arena.reserve(this->num_parameters());
+
+		for (auto& layer : this->hidden_layers) {
+			layer.attach_parameters(arena);
+		}
+
+		this->output_layer.attach_parameters(arena);
+		this->parameters = move(arena);
+	}
+
+public:
+
+	basic_ann(void) { cout << " Multi is created"; }
+
+
+	basic_ann(const size_t num_inputs,
+		const size_t num_hidden_layers,
+		const size_t num_hidden_nodes,
+		const size_t num_outputs) {
+		this->init(num_inputs, num_hidden_layers, num_hidden_nodes, num_outputs);
+	}
+
+	basic_ann(const network_builder& topology) {
+		this->init(topology);
+	}
+
+	basic_ann(const basic_ann& other) {
+		*this = other;
+	}
+
+	basic_ann(basic_ann&& other) = default;
+	basic_ann& operator=(basic_ann&& other) = default;
+
+	/********************************************************************************
+	* operator=: Kopierar topologi, parametrar, träningsdata och inställningar.
+	*            Lagren i kopian pekar in i den andra nätverkets arena eller
+	*            modellfil, varför parametrarna därefter kopieras till en egen
+	*            arena. Nätverken kan sedan tränas oberoende av varandra.
+	*            Träningstillstånden kopieras inte utan allokeras om.
+	*            OBS! Nya medlemmar måste även läggas till här.
+	*
+	*            - other: Nätverket som ska kopieras.
+	********************************************************************************/
+	basic_ann& operator=(const basic_ann& other) {
+		if (this == &other) return *this;
+
+		this->hidden_layers = other.hidden_layers;
+		this->output_layer = other.output_layer;
+		this->sample_inputs = other.sample_inputs;
+		this->sample_references = other.sample_references;
+		this->button_in = rebind_samples(other.button_in, other.sample_inputs, this->sample_inputs);
+		this->diod_out = rebind_samples(other.diod_out, other.sample_references, this->sample_references);
+		this->train_order = other.train_order;
+		this->truth_table = other.truth_table;
+		this->truth_table_bits = other.truth_table_bits;
+		this->activation_mode = other.activation_mode;
+		this->hidden_activation = other.hidden_activation;
+		this->output_activation = other.output_activation;
+		this->optimizer_settings = other.optimizer_settings;
+		this->rate_schedule = other.rate_schedule;
+		this->optimizer_states = other.optimizer_states;
+		this->optimizer_updates = other.optimizer_updates;
+		this->stop_criteria = other.stop_criteria;
+		this->progress_callback = other.progress_callback;
+		this->generator = other.generator;
+		this->weight_init = other.weight_init;
+
+		this->pack_parameters();
+		this->storage.reset();
+		this->context = training_context();
+		this->worker_contexts.clear();
+		this->init_context(this->context, 0);
+		return *this;
+	}
+
+
+
+	~basic_ann(void) {
+		this->clear();
+		return;
+	}
+
+	const vector<dense_layer>& get_hidden_layers(void) const {
+		return this->hidden_layers;
+	}
+
+	const dense_layer& get_output_layer(void) const {
+		return this->output_layer;
+	}
+
+	const sample_view& get_button_in(void) const {
+		return this->button_in;
+	}
+
+	const sample_view& get_diod_out(void) const {
+		return this->diod_out;
+	}
+
+
+
+	/********************************************************************************
+	* init: Skapar ett nätverk med num_hidden_layers dolda lager med
+	*       num_hidden_nodes noder vardera, där samtliga dolda lager använder
+	*       aktiveringsfunktionen angiven via set_activation. Minst ett dolt
+	*       lager skapas.
+	*
+	*       - num_inputs       : Antalet insignaler.
+	*       - num_hidden_layers: Antalet dolda lager.
+	*       - num_hidden_nodes : Antalet noder per dolt lager.
+	*       - num_outputs      : Antalet utsignaler.
+	********************************************************************************/
+	void init(const size_t num_inputs,
+		const size_t num_hidden_layers,
+		const size_t num_hidden_nodes,
+		const size_t num_outputs) {
+		network_builder topology(num_inputs);
+
+		for (size_t i = 0; i < max<size_t>(num_hidden_layers, 1); i++) {
+			topology.hidden(num_hidden_nodes, this->hidden_activation);
+		}
+
+		topology.output(num_outputs, this->output_activation);
+		this->init(topology);
+	}
+
+	/********************************************************************************
+	* init: Skapar ett nätverk med angiven topologi och drar startvärden från
+	*       nätverkets generator, lager för lager. Lagren konstrueras direkt i
+	*       sin slutliga position, utan kopiering, och samtliga bias och vikter
+	*       placeras i en gemensam arena som allokeras en gång. Tidigare lager, moment och
+	*       eventuell inläst modellfil släpps. Returnerar false, utan att
+	*       ändra nätverket, om topologin saknar insignaler, dolda lager eller
+	*       noder i något lager.
+	*
+	*       - topology: Nätverkets topologi, se network_builder.
+	********************************************************************************/
+	bool init(const network_builder& topology) {
+		if (!topology.valid()) return false;
+
+		basic_arena<T> arena;
+		auto num_weights = topology.num_inputs;
+		size_t num_parameters = 0;
+
+		for (const auto& spec : topology.hidden_layers) {
+			num_parameters += dense_layer::parameter_count(spec.num_nodes, num_weights);
+			num_weights = spec.num_nodes;
+		}
+
+		num_parameters += dense_layer::parameter_count(topology.output_layer.num_nodes, num_weights);
+		arena.reserve(num_parameters);
+		num_weights = topology.num_inputs;
+		this->hidden_layers.clear();
+		this->hidden_layers.reserve(topology.hidden_layers.size());
+
+		for (const auto& spec : topology.hidden_layers) {
+			this->hidden_layers.emplace_back();
+			auto& layer = this->hidden_layers.back();
+			layer.activation_type = spec.activation;
+			layer.attach_parameters(arena, spec.num_nodes, num_weights);
+			layer.initialize(this->generator, this->weight_init);
+			num_weights = spec.num_nodes;
+		}
+
+		this->output_layer.clear();
+		this->output_layer.activation_type = topology.output_layer.activation;
+		this->output_layer.attach_parameters(arena, topology.output_layer.num_nodes, num_weights);
+		this->output_layer.initialize(this->generator, this->weight_init);
+
+		this->parameters = move(arena);
+		this->hidden_activation = topology.hidden_layers[0].activation;
+		this->output_activation = topology.output_layer.activation;
+		this->storage.reset();
+		this->set_tanh_mode(this->activation_mode);
+		this->context = training_context();
+		this->worker_contexts.clear();
+		this->init_context(this->context, 0);
+		this->reset_optimizer();
+		this->truth_table.clear();
+		return true;
+	}
+
+	/********************************************************************************
+	* set_tanh_mode: Anger om tanh ska beräknas exakt eller approximativt i
+	*                samtliga lager, vid både träning och prediktion. Läget
+	*                behålls när nätverket initieras om eller läses in från fil.
+	*                Eventuell sanningstabell töms, eftersom utsignalerna kan
+	*                ändras något.
+	*
+	*                - mode: Exakt (default) eller approximativ beräkning.
+	********************************************************************************/
+	void set_tanh_mode(const activation::tanh_mode mode) {
+		this->activation_mode = mode;
+
+		for (auto& layer : this->hidden_layers) {
+			layer.activation_mode = mode;
+		}
+
+		this->output_layer.activation_mode = mode;
+		this->truth_table.clear();
+	}
+
+	activation::tanh_mode get_tanh_mode(void) const {
+		return this->activation_mode;
+	}
+
+	/********************************************************************************
+	* set_activation: Anger aktiveringsfunktion för de dolda lagren respektive
+	*                 utgångslagret, exempelvis ReLU i dolda lager och sigmoid
+	*                 eller tanh i utgångslagret. Valet behålls när nätverket
+	*                 initieras om och lagras per lager i modellfilen.
+	*                 Eventuell sanningstabell töms.
+	*
+	*                 - hidden: Aktiveringsfunktion för samtliga dolda lager.
+	*                 - output: Aktiveringsfunktion för utgångslagret.
+	********************************************************************************/
+	void set_activation(const activation::type hidden, const activation::type output) {
+		this->hidden_activation = hidden;
+		this->output_activation = output;
+
+		for (auto& layer : this->hidden_layers) {
+			layer.activation_type = hidden;
+		}
+
+		this->output_layer.activation_type = output;
+		this->truth_table.clear();
+	}
+
+	activation::type get_hidden_activation(void) const {
+		return this->hidden_activation;
+	}
+
+	activation::type get_output_activation(void) const {
+		return this->output_activation;
+	}
+
+	/********************************************************************************
+	* set_optimizer: Anger metod för uppdatering av vikter och bias vid träning,
+	*                se optimizer.hpp. Metodens tillstånd (moment) nollställs.
+	*                Standard är sgd, dvs. den ursprungliga metoden.
+	*
+	*                - options: Metod och tillhörande parametrar.
+	********************************************************************************/
+	void set_optimizer(const optimizer::settings& options) {
+		this->optimizer_settings = options;
+		this->reset_optimizer();
+	}
+
+	void set_optimizer(const optimizer::type method) {
+		optimizer::settings options;
+		options.method = method;
+		this->set_optimizer(options);
+	}
+
+	const optimizer::settings& get_optimizer(void) const {
+		return this->optimizer_settings;
+	}
+
+	/********************************************************************************
+	* reset_optimizer: Nollställer metodens moment och antalet uppdateringar, så
+	*                  att nästa träning startar som med ett nytt nätverk.
+	********************************************************************************/
+	void reset_optimizer(void) {
+		this->optimizer_states.clear();
+		this->optimizer_updates = 0;
+	}
+
+	/********************************************************************************
+	* set_schedule: Anger schema för lärhastigheten vid träning, se
+	*               optimizer::schedule. Schemat räknas om från början vid
+	*               varje anrop av train. Standard är konstant lärhastighet.
+	*
+	*               - schedule: Schema för lärhastigheten.
+	********************************************************************************/
+	void set_schedule(const optimizer::schedule& schedule) {
+		this->rate_schedule = schedule;
+	}
+
+	const optimizer::schedule& get_schedule(void) const {
+		return this->rate_schedule;
+	}
+
+	/********************************************************************************
+	* set_stopping: Anger villkor för att avbryta träningen i förtid, exempelvis
+	*               när medelkvadratfelet understiger ett målvärde eller inte
+	*               längre minskar, se training::stopping. Standard är att
+	*               samtliga epoker genomförs.
+	*
+	*               - criteria: Villkoren för att avbryta träningen.
+	********************************************************************************/
+	void set_stopping(const training::stopping& criteria) {
+		this->stop_criteria = criteria;
+	}
+
+	const training::stopping& get_stopping(void) const {
+		return this->stop_criteria;
+	}
+
+	/********************************************************************************
+	* set_progress_callback: Anger funktion som anropas med medelkvadratfelet
+	*                        var interval:e epok under träningen, exempelvis för
+	*                        utskrift eller loggning. Funktionen returnerar
+	*                        false för att avbryta träningen. En tom funktion
+	*                        tar bort tidigare angiven callback.
+	*
+	*                        - function: Funktionen som ska anropas.
+	********************************************************************************/
+	void set_progress_callback(const training::callback& function) {
+		this->progress_callback = function;
+	}
+
+	/********************************************************************************
+	* seed: Sätter fröet för nätverkets slumptalsgenerator och drar nya
+	*       startvärden för samtliga lager. Samma frö, topologi och
+	*       träningsdata ger därefter samma vikter och samma träningsordning
+	*       vid varje körning, oberoende av andra nätverk och trådar.
+	*
+	*       - value: Fröet.
+	********************************************************************************/
+	void seed(const uint64_t value) {
+		this->generator.seed(value);
+		this->initialize_weights();
+	}
+
+	/********************************************************************************
+	* set_initialization: Anger fördelning för startvärdena, se
+	*                     prng::init_scheme, och drar nya startvärden för
+	*                     samtliga lager. Valet behålls när nätverket initieras
+	*                     om. Standard är automatic, dvs. He-initiering för lager
+	*                     med ReLU och Xavier-initiering för övriga lager. Anropa
+	*                     efter set_activation, eftersom valet sker per lager
+	*                     utifrån dess aktiveringsfunktion.
+	*
+	*                     - scheme: Fördelning för startvärdena.
+	********************************************************************************/
+	void set_initialization(const prng::init_scheme scheme) {
+		this->weight_init = scheme;
+		this->initialize_weights();
+	}
+
+	prng::init_scheme get_initialization(void) const {
+		return this->weight_init;
+	}
+
+	void clear(void) {
+
+		this->hidden_layers.clear();
+		this->output_layer.clear();
+		this->sample_inputs.clear();
+		this->sample_references.clear();
+		this->button_in = sample_view();
+		this->diod_out = sample_view();
+		this->train_order.clear();
+		this->context = training_context();
+		this->worker_contexts.clear();
+		this->storage.reset();
+		this->parameters.clear();
+		this->reset_optimizer();
+		this->truth_table.clear();
+		return;
+	}
+
+	/********************************************************************************
+	* num_parameters: Returnerar antalet element i en ögonblicksbild av
+	*                 nätverkets parametrar, se snapshot. Bias och vikter för
+	*                 varje lager ligger i samma layout som i arenan, inklusive
+	*                 utfyllnad till hela cache-rader.
+	********************************************************************************/
+	size_t num_parameters(void) const {
+		size_t count = this->output_layer.parameter_count();
+
+		for (const auto& layer : this->hidden_layers) {
+			count += layer.parameter_count();
+		}
+
+		return count;
+	}
+
+	/********************************************************************************
+	* snapshot: Kopierar samtliga lagers bias och vikter till angiven vektor,
+	*           som storleksändras vid behov. När parametrarna ligger i
+	*           nätverkets arena sker kopieringen med en enda memcpy, annars
+	*           (efter load) lager för lager. Används exempelvis för att spara
+	*           det bästa nätverket under träningen.
+	*
+	*           - destination: Vektorn som tilldelas parametrarna.
+	********************************************************************************/
+	void snapshot(vector<T>& destination) const {
+		destination.resize(this->num_parameters());
+
+		if (!this->parameters.empty()) {
+			memcpy(destination.data(), this->parameters.data(), destination.size() * sizeof(T));
+			return;
+		}
+
+		auto position = destination.data();
+
+		for (const auto& layer : this->hidden_layers) {
+			layer.write_parameters(position);
+			position += layer.parameter_count();
+		}
+
+		this->output_layer.write_parameters(position);
+	}
+
+	/********************************************************************************
+	* restore: Återställer bias och vikter från en ögonblicksbild tagen med
+	*          snapshot för ett nätverk med samma topologi. Returnerar false,
+	*          utan att ändra nätverket, om storleken inte stämmer. Metodens
+	*          moment behålls, medan eventuell sanningstabell töms.
+	*
+	*          - source: Ögonblicksbilden som ska återställas.
+	********************************************************************************/
+	bool restore(const vector<T>& source) {
+		if (source.size() != this->num_parameters()) return false;
+
+		if (!this->parameters.empty()) {
+			memcpy(this->parameters.data(), source.data(), source.size() * sizeof(T));
+
+			for (auto& layer : this->hidden_layers) {
+				if (layer.use_transposed) layer.enable_transposed();
+			}
+
+			if (this->output_layer.use_transposed) this->output_layer.enable_transposed();
+		}
+		else {
+			auto position = source.data();
+
+			for (auto& layer : this->hidden_layers) {
+				layer.read_parameters(position);
+				position += layer.parameter_count();
+			}
+
+			this->output_layer.read_parameters(position);
+		}
+
+		this->truth_table.clear();
+		return true;
+	}
+
+	/********************************************************************************
+	* export_source: Skriver nätverket som en fristående C++-header med bias och
+	*                vikter i constexpr-arrayer samt en funktion predict, där
+	*                samtliga noder beräknas rad för rad utan loopar. Headern
+	*                kräver enbart <cmath> och kan kompileras direkt in i en
+	*                firmware, utan träning, filinläsning eller dynamisk
+	*                minnesallokering vid uppstart. Aktiveringsfunktioner och
+	*                tanh-läge följer respektive lager. Returnerar true om filen
+	*                kunde skrivas.
+	*
+	*                - path: Sökväg till headern som ska skrivas.
+	*                - name: Namnrymd för den genererade koden, som måste vara
+	*                        en giltig C++-identifierare (default = neu_network_model).
+	********************************************************************************/
+	bool export_source(const string& path, const string& name = "neu_network_model") const {
+		ofstream file(path);
+		if (!file) return false;
+
+		this->export_source(file, name);
+		file.close();
+		return !file.fail();
+	}
+
+	void export_source(ostream& ostream, const string& name = "neu_network_model") const {
+		const auto num_layers = this->hidden_layers.size() + 1;
+		const string type = is_same<T, float>::value ? "float" : "double";
+		string guard = name + "_HPP_";
+		transform(guard.begin(), guard.end(), guard.begin(), [](const char c) { return static_cast<char>(toupper(c)); });
+		const auto precision = ostream.precision(numeric_limits<double>::max_digits10);
+
+		ostream << "/* Genererad av basic_ann::export_source. Ska inte redigeras manuellt. */\n"
+			<< "#ifndef " << guard << "\n#define " << guard << "\n\n"
+			<< "#include <cstddef>\n#include <cmath>\n\n"
+			<< "namespace " << name << "\n{\n"
+			<< "\ttypedef " << type << " value_type;\n\n"
+			<< "\tconstexpr std::size_t num_inputs = " << this->hidden_layers[0].num_weights() << ";\n"
+			<< "\tconstexpr std::size_t num_outputs = " << this->output_layer.num_nodes() << ";\n\n";
+
+		for (size_t l = 0; l < num_layers; l++) {
+			const auto& layer = l < this->hidden_layers.size() ? this->hidden_layers[l] : this->output_layer;
+			ostream << "\tconstexpr value_type bias_" << l << "[" << layer.num_nodes() << "] = { ";
+
+			for (size_t i = 0; i < layer.num_nodes(); i++) {
+				write_literal(ostream, layer.bias[i], i + 1 < layer.num_nodes() ? ", " : " };\n");
+			}
+
+			ostream << "\tconstexpr value_type weights_" << l << "[" << layer.num_nodes() << "][" << layer.num_weights() << "] =\n\t{\n";
+
+			for (size_t i = 0; i < layer.num_nodes(); i++) {
+				ostream << "\t\t{ ";
+
+				for (size_t j = 0; j < layer.num_weights(); j++) {
+					write_literal(ostream, layer.weights.row(i)[j], j + 1 < layer.num_weights() ? ", " : " }");
+				}
+
+				ostream << (i + 1 < layer.num_nodes() ? ",\n" : "\n\t};\n\n");
+			}
+		}
+
+		ostream << "\tinline value_type relu(const value_type x) { return x > 0 ? x : value_type(0); }\n"
+			<< "\tinline value_type sigmoid(const value_type x) { return value_type(1) / (value_type(1) + std::exp(-x)); }\n\n"
+			<< "\t/* Rationell approximation av tanh, samma som tanh_mode::fast: */\n"
+			<< "\tinline value_type tanh_fast(const value_type x)\n\t{\n"
+			<< "\t\tconst value_type limit = value_type(" << simd::detail::tanh_limit << ");\n"
+			<< "\t\tconst value_type c = x < -limit ? -limit : (x > limit ? limit : x);\n"
+			<< "\t\tconst value_type c2 = c * c;\n"
+			<< "\t\tvalue_type p = value_type(" << simd::detail::tanh_numerator[0] << ");\n"
+			<< "\t\tvalue_type q = value_type(" << simd::detail::tanh_denominator[0] << ");\n";
+
+		for (size_t k = 1; k < 7; k++) ostream << "\t\tp = p * c2 + value_type(" << simd::detail::tanh_numerator[k] << ");\n";
+		for (size_t k = 1; k < 4; k++) ostream << "\t\tq = q * c2 + value_type(" << simd::detail::tanh_denominator[k] << ");\n";
+
+		ostream << "\t\treturn c * p / q;\n\t}\n\n"
+			<< "\tinline value_type sigmoid_fast(const value_type x) { return value_type(0.5) * tanh_fast(value_type(0.5) * x) + value_type(0.5); }\n\n"
+			<< "\t/* Prediktion, num_inputs insignaler till num_outputs utsignaler: */\n"
+			<< "\tinline void predict(const value_type* input, value_type* output)\n\t{\n";
+
+		for (size_t l = 0; l < num_layers; l++) {
+			const auto& layer = l < this->hidden_layers.size() ? this->hidden_layers[l] : this->output_layer;
+			const auto function = source_activation(layer.activation_type, layer.activation_mode);
+
+			for (size_t i = 0; i < layer.num_nodes(); i++) {
+				ostream << "\t\t";
+				if (l + 1 < num_layers) ostream << "const value_type h" << l << "_" << i;
+				else ostream << "output[" << i << "]";
+				ostream << " = " << function << "(bias_" << l << "[" << i << "] + (";
+
+				for (size_t j = 0; j < layer.num_weights(); j++) {
+					ostream << (j ? " + " : "") << "weights_" << l << "[" << i << "][" << j << "] * ";
+					if (l == 0) ostream << "input[" << j << "]";
+					else ostream << "h" << l - 1 << "_" << j;
+				}
+
+				ostream << "));\n";
+			}
+
+			if (l + 1 < num_layers) ostream << "\n";
+		}
+
+		ostream << "\t}\n}\n\n#endif /* " << guard << " */\n";
+		ostream.precision(precision);
+	}
+
+	/********************************************************************************
+	* save: Sparar nätverkets topologi, bias och vikter till angiven fil i det
+	*       binära modellformatet (se model_file.hpp). Returnerar true om
+	*       filen kunde skrivas.
+	*
+	*       - path: Sökväg till filen som ska skrivas.
+	********************************************************************************/
+	bool save(const string& path) const {
+		using namespace model_format;
+		const auto num_layers = this->hidden_layers.size() + 1;
+		vector<model_layer_record> records(num_layers);
+		auto offset = align_offset(sizeof(model_header) + num_layers * sizeof(model_layer_record));
+
+		for (size_t i = 0; i < num_layers; i++) {
+			const auto& layer = i < this->hidden_layers.size() ? this->hidden_layers[i] : this->output_layer;
+			auto& record = records[i];
+			record.num_nodes = static_cast<uint32_t>(layer.num_nodes());
+			record.num_weights = static_cast<uint32_t>(layer.num_weights());
+			record.activation = static_cast<uint32_t>(layer.activation_type);
+			record.stride = static_cast<uint32_t>(layer.weights.stride());
+			record.bias_offset = offset;
+			offset = align_offset(offset + record.num_nodes * sizeof(T));
+			record.weights_offset = offset;
+			offset = align_offset(offset + static_cast<uint64_t>(record.num_nodes) * record.stride * sizeof(T));
+		}
+
+		vector<unsigned char> image(static_cast<size_t>(offset), 0);
+		write_bytes(image, sizeof(model_header), records.data(), num_layers * sizeof(model_layer_record));
+
+		for (size_t i = 0; i < num_layers; i++) {
+			const auto& layer = i < this->hidden_layers.size() ? this->hidden_layers[i] : this->output_layer;
+			const auto& record = records[i];
+			write_bytes(image, record.bias_offset, layer.bias.data(), layer.num_nodes() * sizeof(T));
+
+			for (size_t j = 0; j < layer.num_nodes(); j++) {
+				write_bytes(image, record.weights_offset + j * record.stride * sizeof(T),
+					layer.weights.row(j), layer.num_weights() * sizeof(T));
+			}
+		}
+
+		model_header header = {};
+		memcpy(header.magic, magic, sizeof(header.magic));
+		header.version = version;
+		header.byte_order = byte_order;
+		header.header_size = sizeof(model_header);
+		header.num_layers = static_cast<uint32_t>(num_layers);
+		header.file_size = offset;
+		header.scalar_type = scalar_traits<T>::id;
+		header.checksum = checksum(image.data() + sizeof(model_header), image.size() - sizeof(model_header));
+		write_bytes(image, 0, &header, sizeof(header));
+
+		auto file = fopen(path.c_str(), "wb");
+		if (!file) return false;
+		const auto written = fwrite(image.data(), 1, image.size(), file);
+		return fclose(file) == 0 && written == image.size();
+	}
+
+	/********************************************************************************
+	* load: Läser in ett nätverk från angiven fil i det binära modellformatet.
+	*       Filen minnesmappas och vikterna läses därefter direkt från filens
+	*       sidor utan kopiering; mappningen hålls öppen så länge nätverket
+	*       använder den. Befintliga lager ersätts, medan träningsdata behålls.
+	*       Returnerar false, utan att ändra nätverket, om filen saknas, är
+	*       trasig, har fel version eller har en annan elementtyp än nätverket.
+	*
+	*       - path           : Sökväg till filen som ska läsas.
+	*       - verify_checksum: Indikerar ifall kontrollsumman ska verifieras
+	*                          (default = true).
+	********************************************************************************/
+	bool load(const string& path, const bool verify_checksum = true) {
+		using namespace model_format;
+		auto file = make_shared<mapped_file>();
+		if (!file->open(path) || file->size() < sizeof(model_header)) return false;
+
+		model_header header;
+		memcpy(&header, file->data(), sizeof(header));
+
+		if (memcmp(header.magic, magic, sizeof(header.magic)) != 0 || header.version != version ||
+			header.byte_order != byte_order || header.header_size != sizeof(model_header) ||
+			header.file_size != file->size() || header.num_layers < 2 || header.scalar_type != scalar_traits<T>::id) {
+			return false;
+		}
+
+		const auto records_end = sizeof(model_header) + static_cast<uint64_t>(header.num_layers) * sizeof(model_layer_record);
+		if (records_end > header.file_size) return false;
+
+		vector<model_layer_record> records(header.num_layers);
+		memcpy(records.data(), file->data() + sizeof(model_header), header.num_layers * sizeof(model_layer_record));
+
+		/* Kontrollerar att num_elements element ryms mellan offset och filens
+		   slut. Jämförelsen görs mot antalet element i stället för mot
+		   offset + storlek, så att stora offset i en trasig fil inte kan ge
+		   overflow. Antalet noder och radlängden är 32 bitar, varför deras
+		   produkt alltid ryms i 64 bitar: */
+		const auto fits = [&header](const uint64_t offset, const uint64_t num_elements) {
+			return offset <= header.file_size && num_elements <= (header.file_size - offset) / sizeof(T);
+		};
+
+		for (size_t i = 0; i < records.size(); i++) {
+			const auto& record = records[i];
+
+			if (record.num_nodes == 0 || record.stride < record.num_weights || record.activation >= activation_count ||
+				record.bias_offset % sizeof(T) != 0 || record.weights_offset % alignment != 0 ||
+				!fits(record.bias_offset, record.num_nodes) ||
+				!fits(record.weights_offset, static_cast<uint64_t>(record.num_nodes) * record.stride) ||
+				(i > 0 && record.num_weights != records[i - 1].num_nodes)) {
+				return false;
+			}
+		}
+
+		if (verify_checksum &&
+			checksum(file->data() + sizeof(model_header), file->size() - sizeof(model_header)) != header.checksum) {
+			return false;
+		}
+
+		vector<dense_layer> layers(header.num_layers);
+
+		for (size_t i = 0; i < layers.size(); i++) {
+			const auto& record = records[i];
+			const auto bias = reinterpret_cast<T*>(file->data() + record.bias_offset);
+			const auto weights = reinterpret_cast<T*>(file->data() + record.weights_offset);
+			layers[i].bias.attach(bias, record.num_nodes);
+			layers[i].weights.attach(weights, record.num_nodes, record.num_weights, record.stride);
+			layers[i].activation_type = static_cast<activation::type>(record.activation);
+		}
+
+		this->output_layer = layers.back();
+		layers.pop_back();
+		this->hidden_layers = layers;
+		this->storage = file;
+		this->parameters.clear();
+		this->hidden_activation = this->hidden_layers.empty() ? this->output_layer.activation_type : this->hidden_layers[0].activation_type;
+		this->output_activation = this->output_layer.activation_type;
+		this->set_tanh_mode(this->activation_mode);
+		this->context = training_context();
+		this->worker_contexts.clear();
+		this->init_context(this->context, 0);
+		this->reset_optimizer();
+		this->truth_table.clear();
+		return true;
+	}
+
+	/********************************************************************************
+	* set_training_data: Kopierar angivna träningsuppsättningar till två
+	*                    sammanhängande matriser, en rad per uppsättning. Om
+	*                    antalet uppsättningar skiljer sig används det minsta
+	*                    antalet. Kortare rader fylls ut med nollor.
+	*
+	*                    - button_in: Indata, en vektor per uppsättning.
+	*                    - diod_out : Referensdata, en vektor per uppsättning.
+	********************************************************************************/
+	void set_training_data(const vector<vector<T>>& button_in,
+		const vector<vector<T>>& diod_out) {
+		const auto num_sets = min(button_in.size(), diod_out.size());
+		this->button_in = pack_samples(button_in, num_sets, this->sample_inputs);
+		this->diod_out = pack_samples(diod_out, num_sets, this->sample_references);
+		this->reset_train_order(num_sets);
+		return;
+	}
+
+	/********************************************************************************
+	* set_training_data: Tränar direkt på angivna data utan att kopiera dem,
+	*                    antingen en radvis buffert med stride eller en tabell
+	*                    med radpekare, se basic_sample_view. Data måste finnas
+	*                    kvar och vara oförändrade så länge nätverket tränas på
+	*                    dem, eller tills nya träningsdata anges. Om antalet
+	*                    uppsättningar skiljer sig används det minsta antalet.
+	*
+	*                    - inputs    : Vy över indata, en rad per uppsättning.
+	*                    - references: Vy över referensdata, en rad per uppsättning.
+	********************************************************************************/
+	void set_training_data(const sample_view& inputs,
+		const sample_view& references) {
+		const auto num_sets = min(inputs.size(), references.size());
+		this->sample_inputs.clear();
+		this->sample_references.clear();
+		this->button_in = inputs;
+		this->diod_out = references;
+		this->button_in.num_rows = num_sets;
+		this->diod_out.num_rows = num_sets;
+		this->reset_train_order(num_sets);
+		return;
+	}
+
+	/********************************************************************************
+	* train: Tränar nätverket uppsättning för uppsättning under högst angivet
+	*        antal epoker. Medelkvadratfelet följs upp per epok och träningen
+	*        avbryts i förtid enligt villkoren i set_stopping eller om angiven
+	*        callback (se set_progress_callback) returnerar false. Returnerar
+	*        antalet genomförda epoker, senaste felet och anledningen till att
+	*        träningen avslutades.
+	*
+	*        - num_epochs   : Högsta antalet epoker som träningen ska pågå.
+	*        - learning_rate: Lärhastigheten.
+	********************************************************************************/
+	training::result train(const size_t num_epochs,
+		const T learning_rate) {
+		training::monitor monitor(this->stop_criteria, this->progress_callback, num_epochs);
+		this->init_context(this->context, 0);
+		this->init_optimizer();
+		this->truth_table.clear();
+		take_loss(&this->context, 1);
+
+		for (size_t i = 0; i < num_epochs; i++) {
+			const auto rate = this->epoch_rate(learning_rate, i, num_epochs);
+			this->train_epoch(rate, 0);
+			if (!monitor.update(i, take_loss(&this->context, 1), rate)) break;
+		}
+
+		return monitor.get_result();
+	}
+
+	/********************************************************************************
+	* train: Tränar nätverket med minibatcher. Varje batch packas till en matris
+	*        och körs genom blockade matrismultiplikationer, varefter vikterna
+	*        uppdateras en gång med batchens medelgradient. En batchstorlek på
+	*        1 eller mindre ger vanlig träning uppsättning för uppsättning.
+	*        Felet följs upp och träningen avbryts i förtid som ovan.
+	*
+	*        - num_epochs   : Högsta antalet epoker som träningen ska pågå.
+	*        - learning_rate: Lärhastigheten.
+	*        - batch_size   : Antalet träningsuppsättningar per viktuppdatering.
+	********************************************************************************/
+	training::result train(const size_t num_epochs,
+		const T learning_rate,
+		const size_t batch_size) {
+		if (batch_size <= 1) {
+			return this->train(num_epochs, learning_rate);
+		}
+
+		training::monitor monitor(this->stop_criteria, this->progress_callback, num_epochs);
+		this->init_context(this->context, batch_size);
+		this->init_optimizer();
+		this->truth_table.clear();
+		take_loss(&this->context, 1);
+
+		for (size_t i = 0; i < num_epochs; i++) {
+			const auto rate = this->epoch_rate(learning_rate, i, num_epochs);
+			this->train_epoch(rate, batch_size);
+			if (!monitor.update(i, take_loss(&this->context, 1), rate)) break;
+		}
+
+		return monitor.get_result();
+	}
+
+	/********************************************************************************
+	* train: Tränar nätverket på uppsättningar som läses från fil via angiven
+	*        ström, block för block, så att data som inte ryms i minnet kan
+	*        användas. Varje epok motsvarar en genomgång av filen, där blocken
+	*        används i filens ordning och uppsättningarna blandas inom varje
+	*        block. Strömmen läser nästa block i bakgrunden medan föregående
+	*        block tränas. Blocken används direkt utan att kopieras, och
+	*        tidigare angivna träningsdata återställs efter träningen. Felet
+	*        följs upp och träningen avbryts i förtid som ovan.
+	*
+	*        - stream       : Öppnad ström med samma antal in- och utsignaler
+	*                         som nätverket.
+	*        - num_epochs   : Högsta antalet epoker som träningen ska pågå.
+	*        - learning_rate: Lärhastigheten.
+	*        - batch_size   : Antalet träningsuppsättningar per viktuppdatering
+	*                         (default = 1, dvs. uppsättning för uppsättning).
+	********************************************************************************/
+	training::result train(sample_stream& stream,
+		const size_t num_epochs,
+		const T learning_rate,
+		const size_t batch_size = 1) {
+		training::monitor monitor(this->stop_criteria, this->progress_callback, num_epochs);
+		if (!stream.is_open()) return monitor.get_result();
+
+		const auto inputs = this->button_in;
+		const auto references = this->diod_out;
+		vector<size_t> order;
+		order.swap(this->train_order);
+
+		this->init_context(this->context, batch_size > 1 ? batch_size : 0);
+		this->init_optimizer();
+		this->truth_table.clear();
+		take_loss(&this->context, 1);
+		stream.rewind();
+
+		for (size_t i = 0; i < num_epochs; i++) {
+			const auto rate = this->epoch_rate(learning_rate, i, num_epochs);
+
+			while (const auto chunk = stream.next()) {
+				this->button_in = chunk->input_view();
+				this->diod_out = chunk->reference_view();
+				this->reset_train_order(chunk->rows);
+				this->train_epoch(rate, batch_size);
+			}
+
+			if (!monitor.update(i, take_loss(&this->context, 1), rate)) break;
+		}
+
+		this->button_in = inputs;
+		this->diod_out = references;
+		this->train_order.swap(order);
+		return monitor.get_result();
+	}
+
+	/********************************************************************************
+	* train_parallel: Synkron dataparallell träning med minibatcher. Varje batch
+	*                 delas upp mellan trådarna i angiven trådpool, som beräknar
+	*                 gradienter för sin del med egna tillstånd. Gradienterna
+	*                 summeras därefter till den första trådens tillstånd i ett
+	*                 enda parallellt steg, där varje tråd linjärt summerar sin
+	*                 del av gradientblocket från samtliga tillstånd, se
+	*                 reduce_gradients. Vikterna uppdateras en gång per batch.
+	*                 Resultatet motsvarar train(num_epochs, learning_rate,
+	*                 batch_size), bortsett från avrundningsskillnader till
+	*                 följd av summeringsordningen.
+	*                 Felet följs upp och träningen avbryts i förtid som i train.
+	*
+	*                 - pool         : Trådpoolen som ska användas.
+	*                 - num_epochs   : Högsta antalet epoker som träningen ska pågå.
+	*                 - learning_rate: Lärhastigheten.
+	*                 - batch_size   : Antalet träningsuppsättningar per viktuppdatering,
+	*                                  där 0 behandlas som 1.
+	********************************************************************************/
+	training::result train_parallel(thread_pool& pool,
+		const size_t num_epochs,
+		const T learning_rate,
+		size_t batch_size) {
+		if (batch_size == 0) batch_size = 1;
+		const auto num_threads = pool.size();
+		const auto shard_size = (batch_size + num_threads - 1) / num_threads;
+		training::monitor monitor(this->stop_criteria, this->progress_callback, num_epochs);
+
+		this->worker_contexts.resize(num_threads);
+		this->truth_table.clear();
+
+		for (auto& context : this->worker_contexts) {
+			this->init_context(context, shard_size);
+		}
+
+		take_loss(this->worker_contexts.data(), num_threads);
+
+		this->init_optimizer();
+
+		for (size_t i = 0; i < num_epochs; i++) {
+			const auto rate = this->epoch_rate(learning_rate, i, num_epochs);
+			this->shuffle();
+
+			for (size_t j = 0; j < this->train_order.size(); j += batch_size) {
+				const auto count = j + batch_size < this->train_order.size() ? batch_size : this->train_order.size() - j;
+
+				pool.run([&](const size_t id) {
+					const auto first = count * id / num_threads;
+					const auto last = count * (id + 1) / num_threads;
+					this->compute_gradients(this->train_order.data() + j + first, last - first, this->worker_contexts[id]);
+				});
+
+				this->reduce_gradients(pool);
+				this->apply_gradients(this->worker_contexts[0], rate, count);
+			}
+
+			if (!monitor.update(i, take_loss(this->worker_contexts.data(), num_threads), rate)) break;
+		}
+
+		return monitor.get_result();
+	}
+
+	/********************************************************************************
+	* train_hogwild: Asynkron dataparallell träning enligt Hogwild!-principen.
+	*                Träningsordningen delas upp mellan trådarna, som var för
+	*                sig tränar uppsättning för uppsättning och skriver direkt
+	*                till de gemensamma vikterna utan lås. Enstaka uppdateringar
+	*                kan därmed skrivas över av andra trådar, vilket i praktiken
+	*                har liten inverkan på glesa eller små gradienter. Resultatet
+	*                är inte deterministiskt. Vikterna uppdateras alltid med sgd,
+	*                eftersom tillståndet för övriga metoder annars skulle delas
+	*                mellan trådarna, medan valt schema för lärhastigheten följs.
+	*                Felet följs upp och träningen avbryts i förtid som i train.
+	*
+	*                - pool         : Trådpoolen som ska användas.
+	*                - num_epochs   : Högsta antalet epoker som träningen ska pågå.
+	*                - learning_rate: Lärhastigheten.
+	********************************************************************************/
+	training::result train_hogwild(thread_pool& pool,
+		const size_t num_epochs,
+		const T learning_rate) {
+		const auto num_threads = pool.size();
+		training::monitor monitor(this->stop_criteria, this->progress_callback, num_epochs);
+		this->worker_contexts.resize(num_threads);
+		this->truth_table.clear();
+
+		for (auto& context : this->worker_contexts) {
+			this->init_context(context, 0);
+		}
+
+		take_loss(this->worker_contexts.data(), num_threads);
+
+		for (size_t i = 0; i < num_epochs; i++) {
+			const auto rate = this->epoch_rate(learning_rate, i, num_epochs);
+			this->shuffle();
+
+			pool.run([&](const size_t id) {
+				const auto first = this->train_order.size() * id / num_threads;
+				const auto last = this->train_order.size() * (id + 1) / num_threads;
+				auto& context = this->worker_contexts[id];
+				profiling::add_samples(last - first);
+
+				for (size_t j = first; j < last; j++) {
+					const auto index = this->train_order[j];
+					const auto input = this->button_in.row(index);
+
+					this->feedforward(input, this->button_in.cols, context);
+					this->backpropagate(this->diod_out.row(index), this->diod_out.cols, context);
+					this->optimize_sgd(input, this->button_in.cols, context, rate);
+				}
+			});
+
+			if (!monitor.update(i, take_loss(this->worker_contexts.data(), num_threads), rate)) break;
+		}
+
+		return monitor.get_result();
+	}
+
+	const vector<T>& predict(const vector<T>& input) {
+		this->feedforward(input, this->context);
+		return this->context.output_state().output;
+	}
+
+	/********************************************************************************
+	* init_context: Allokerar buffertar för prediktion. Därefter kan angivet
+	*               tillstånd användas för valfritt antal prediktioner utan
+	*               några ytterligare minnesallokeringar.
+	*
+	*               - context: Tillståndet som ska allokeras.
+	********************************************************************************/
+	void init_context(inference_context& context) const {
+		const auto width = this->max_hidden_width();
+		context.buffers[0].assign(width, T(0));
+		context.buffers[1].assign(width, T(0));
+		context.output.assign(this->output_layer.num_nodes(), T(0));
+	}
+
+	/********************************************************************************
+	* predict: Genomför prediktion utan att ändra nätverket, vilket gör att flera
+	*          trådar kan prediktera samtidigt med samma nätverk så länge varje
+	*          tråd har ett eget tillstånd. Om tillståndet inte är allokerat för
+	*          nätverkets topologi, exempelvis efter att ha använts med ett annat
+	*          nätverk, sker det vid anropet, därefter sker inga minnesallokeringar.
+	*
+	*          - input     : Pekare till indata.
+	*          - num_inputs: Antalet element i indata.
+	*          - output    : Pekare till buffert för nätverkets utsignaler.
+	*          - context   : Tillstånd för lagrens utsignaler.
+	********************************************************************************/
+	void predict(const T* input,
+		const size_t num_inputs,
+		T* output,
+		inference_context& context) const {
+		if (!this->context_fits(context)) {
+			this->init_context(context);
+		}
+
+		const T* x = input;
+		size_t n = num_inputs;
+
+		for (size_t i = 0; i < this->hidden_layers.size(); i++) {
+			const profiling::layer_scope scope(profiling::phase::forward, i);
+			auto y = context.buffers[i % 2].data();
+			this->hidden_layers[i].feedforward(x, n, y);
+			x = y;
+			n = this->hidden_layers[i].num_nodes();
+		}
+
+		const profiling::layer_scope scope(profiling::phase::forward, this->hidden_layers.size());
+		this->output_layer.feedforward(x, n, output);
+	}
+
+	/********************************************************************************
+	* predict: Genomför prediktion enligt ovan och returnerar en referens till
+	*          utsignalerna, som lagras i angivet tillstånd.
+	*
+	*          - input  : Referens till vektor innehållande indata.
+	*          - context: Tillstånd för lagrens utsignaler.
+	********************************************************************************/
+	const vector<T>& predict(const vector<T>& input,
+		inference_context& context) const {
+		if (!this->context_fits(context)) {
+			this->init_context(context);
+		}
+
+		this->predict(input.data(), input.size(), context.output.data(), context);
+		return context.output;
+	}
+
+	/********************************************************************************
+	* predict_batch: Genomför prediktion för flera uppsättningar indata på en
+	*                gång. Raderna behandlas i block om batch_block_rows rader
+	*                via blockade matrismultiplikationer, och om en trådpool
+	*                anges och antalet rader är stort delas blocken upp mellan
+	*                trådarna. Utsignalerna skrivs direkt till angiven matris.
+	*                Om vyernas dimensioner inte stämmer med nätverket görs
+	*                ingen prediktion och outputs lämnas oförändrad.
+	*
+	*                - inputs : Vy över indata, en rad per uppsättning och lika
+	*                           många kolumner som nätverket har ingångar.
+	*                - outputs: Vy över utdata, lika många rader som inputs och
+	*                           lika många kolumner som utgångslagret har noder.
+	*                - pool   : Pekare till trådpool för parallell prediktion
+	*                           (default = nullptr, dvs. enbart anropande tråd).
+	********************************************************************************/
+	void predict_batch(const const_matrix_view& inputs,
+		const matrix_view& outputs,
+		thread_pool* pool = nullptr) const {
+		if (inputs.cols != this->hidden_layers[0].num_weights() ||
+			outputs.cols != this->output_layer.num_nodes() || inputs.rows != outputs.rows) return;
+
+		const auto num_blocks = (inputs.rows + batch_block_rows - 1) / batch_block_rows;
+
+		if (pool && pool->size() > 1 && inputs.rows >= parallel_min_rows) {
+			pool->parallel_for(num_blocks, [&](const size_t first, const size_t last) {
+				this->predict_blocks(inputs, outputs, first, last);
+			});
+		}
+		else {
+			this->predict_blocks(inputs, outputs, 0, num_blocks);
+		}
+	}
+
+	/********************************************************************************
+	* predict_batch: Genomför prediktion för n uppsättningar indata som lagras
+	*                tätt packade radvis, med lika många element per rad som
+	*                nätverket har ingångar. Utsignalerna skrivs tätt packade
+	*                till outputs, med lika många element per rad som
+	*                nätverket har utgångar.
+	*
+	*                - inputs : Pekare till indata (n * antal ingångar element).
+	*                - n      : Antalet uppsättningar indata.
+	*                - outputs: Pekare till utdata (n * antal utgångar element).
+	*                - pool   : Pekare till trådpool för parallell prediktion.
+	********************************************************************************/
+	void predict_batch(const T* inputs,
+		const size_t n,
+		T* outputs,
+		thread_pool* pool = nullptr) const {
+		const auto num_inputs = this->hidden_layers[0].num_weights();
+		const auto num_outputs = this->output_layer.num_nodes();
+		this->predict_batch(const_matrix_view(inputs, n, num_inputs, num_inputs),
+			matrix_view(outputs, n, num_outputs, num_outputs), pool);
+	}
+
+	/********************************************************************************
+	* compile_truth_table: Förberäknar tröskelvärdade utsignaler för samtliga
+	*                      kombinationer av binära insignaler, så att prediktion
+	*                      med binär indata blir en enda tabelluppslagning.
+	*                      Tabellen skapas enbart om nätverket har högst max_bits
+	*                      ingångar och högst 64 utgångar, samt om samtliga
+	*                      träningsuppsättningars indata är binär (0 eller 1).
+	*                      Tabellen måste kompileras om efter fortsatt träning,
+	*                      vilket indikeras av att den töms vid varje träning.
+	*                      Returnerar true om tabellen skapades.
+	*
+	*                      - max_bits: Högsta tillåtna antal ingångar (default = 8).
+	********************************************************************************/
+	bool compile_truth_table(const size_t max_bits = 8) {
+		const auto num_inputs = this->hidden_layers[0].num_weights();
+		const auto num_outputs = this->output_layer.num_nodes();
+
+		this->truth_table.clear();
+		this->truth_table_bits = 0;
+		if (num_inputs > max_bits || num_inputs >= 32 || num_outputs > 64) return false;
+
+		for (size_t i = 0; i < this->button_in.size(); i++) {
+			const auto row = this->button_in.row(i);
+
+			for (size_t j = 0; j < this->button_in.cols; j++) {
+				if (row[j] != 0.0 && row[j] != 1.0) return false;
+			}
+		}
+
+		const auto num_entries = static_cast<size_t>(1) << num_inputs;
+		vector<T> input(num_inputs, T(0));
+		vector<uint64_t> table(num_entries, 0);
+		inference_context context;
+
+		for (size_t index = 0; index < num_entries; index++) {
+			for (size_t j = 0; j < num_inputs; j++) {
+				input[j] = static_cast<T>((index >> j) & 1);
+			}
+
+			table[index] = threshold_outputs(this->predict(input, context));
+		}
+
+		this->truth_table = table;
+		this->truth_table_bits = num_inputs;
+		return true;
+	}
+
+	bool has_truth_table(void) const {
+		return !this->truth_table.empty();
+	}
+
+	/********************************************************************************
+	* predict_thresholded: Genomför prediktion och returnerar utsignalerna
+	*                      tröskelvärdade till bitar, där bit i är satt om
+	*                      utgång i avrundas till 1, dvs. om output + 0.5 >= 1
+	*                      (samma avrundning som static_cast<int>(output + 0.5)
+	*                      ger för utsignaler i intervallet [-1, 1]). Om en
+	*                      sanningstabell finns och samtliga insignaler är 0
+	*                      eller 1 sker prediktionen via tabelluppslagning,
+	*                      annars via predict. Resultatet är detsamma i båda
+	*                      fallen.
+	*
+	*                      - input  : Referens till vektor innehållande indata.
+	*                      - context: Tillstånd som används om tabellen inte kan användas.
+	********************************************************************************/
+	uint64_t predict_thresholded(const vector<T>& input,
+		inference_context& context) const {
+		if (!this->truth_table.empty() && input.size() == this->truth_table_bits) {
+			size_t index = 0;
+			size_t j = 0;
+
+			for (; j < input.size(); j++) {
+				if (input[j] == 1.0) index |= static_cast<size_t>(1) << j;
+				else if (input[j] != 0.0) break;
+			}
+
+			if (j == input.size()) return this->truth_table[index];
+		}
+
+		return threshold_outputs(this->predict(input, context));
+	}
+
+	void print(const vector<vector<T>>& input,
+		const size_t num_decimals = 1,
+		ostream& ostream = cout,
+		const double threshold = 0.001) const {
+		if (input.size() == 0) return;
+
+		matrix inputs(input.size(), this->hidden_layers[0].num_weights());
+		matrix outputs(input.size(), this->output_layer.num_nodes());
+
+		for (size_t i = 0; i < input.size(); i++) {
+			pack_row(input[i], inputs.row(i), inputs.cols());
+		}
+
+		this->predict_batch(inputs.view(), outputs.view());
+
+		const auto& end = input[input.size() - 1];
+
+		ostream << "-----------------------------------------------------------------\n";
+
+		for (auto& i : input) {
+			ostream << " Input: ";
+			dense_layer::print(i, ostream, num_decimals, threshold);
+
+
+			ostream << "Output: ";
+			dense_layer::print(outputs.row(static_cast<size_t>(&i - &input[0])), outputs.cols(), ostream, num_decimals, threshold);
+
+			if (&i < &end) ostream << "\n";
+		}
+
+		ostream << "-----------------------------------------------------------------\n\n";
+	}
+
+	void print(const sample_view& input,
+		const size_t num_decimals = 1,
+		ostream& ostream = cout,
+		const double threshold = 0.001) const {
+		if (input.size() == 0) return;
+
+		matrix inputs(input.size(), this->hidden_layers[0].num_weights());
+		matrix outputs(input.size(), this->output_layer.num_nodes());
+
+		for (size_t i = 0; i < input.size(); i++) {
+			pack_row(input.row(i), input.cols, inputs.row(i), inputs.cols());
+		}
+
+		this->predict_batch(inputs.view(), outputs.view());
+		ostream << "-----------------------------------------------------------------\n";
+
+		for (size_t i = 0; i < input.size(); i++) {
+			ostream << " Input: ";
+			dense_layer::print(input.row(i), input.cols, ostream, num_decimals, threshold);
+
+			ostream << "Output: ";
+			dense_layer::print(outputs.row(i), outputs.cols(), ostream, num_decimals, threshold);
+
+			if (i + 1 < input.size()) ostream << "\n";
+		}
+
+		ostream << "-----------------------------------------------------------------\n\n";
+	}
+
+
+
+
+public:
+
+	/********************************************************************************
+	* print: Genomför prediktion med samtliga befintliga träningsuppsättningars
+	*        indata och skriver ut predikterad utdata via angiven utström, där
+	*        standardutenheten std::cout används som default för utskrift i
+	*        terminalen. Som default sker utskrift med en decimal. Värden mellan
+	*        -0.001 samt 0.001 avrundas till noll vid utskrift.
+	*
+	*        - num_decimals: Antalet decimaler vid utskrift (default = 1).
+	*        - ostream     : Referens till godtycklig utström (default = std::cout).
+	*        - threshold   : Tröskelvärde som används för att avrunda tal nära
+	*                        noll (default = 0.001).
+	********************************************************************************/
+	void print(const size_t num_decimals = 1,
+		ostream& ostream = std::cout,
+		const double threshold = 0.001) const
+	{
+		this->print(this->button_in, num_decimals, ostream, threshold);
+		return;
+	}
+
+};
+
+typedef basic_training_context<double> training_context;
+typedef basic_inference_context<double> inference_context;
+typedef basic_ann<double> ann;
@@ -0,0 +1,85 @@
+#ifndef ARENA_HPP_
+#define ARENA_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <cstddef>
+#include <vector>
+
+#include "matrix.hpp"
+
+/********************************************************************************
+* basic_arena: Sammanhängande och justerad buffert som delas ut i block via
+*              allocate (så kallad bump-allokering). Samtliga block börjar på
+*              en hel cache-rad, så att matriser och vektorer som kopplas till
+*              arenan via attach har samma justering som egna buffertar.
+*
+*              Storleken anges en gång via reserve, varefter blocken delas ut
+*              utan ytterligare minnesallokeringar. Blocken frigörs tillsammans
+*              när arenan töms, storleksändras eller förstörs. Vid flytt av
+*              arenan behålls bufferten och därmed samtliga utdelade pekare,
+*              medan en kopia får en egen buffert som ingen pekar in i.
+********************************************************************************/
+template <typename T>
+class basic_arena
+{
+public:
+	static constexpr std::size_t alignment = 64 / sizeof(T);
+
+	/********************************************************************************
+	* padded: Returnerar antalet element som ett block med n element upptar,
+	*         dvs. n avrundat uppåt till en hel cache-rad.
+	********************************************************************************/
+	static constexpr std::size_t padded(const std::size_t n)
+	{
+		return (n + alignment - 1) / alignment * alignment;
+	}
+
+	inline std::size_t size(void) const { return this->used; }
+	inline std::size_t capacity(void) const { return this->buffer.size(); }
+	inline bool empty(void) const { return this->buffer.empty(); }
+
+	inline T* data(void) { return this->buffer.data(); }
+	inline const T* data(void) const { return this->buffer.data(); }
+
+	/********************************************************************************
+	* reserve: Allokerar plats för angivet antal element, samtliga noll.
+	*          Tidigare utdelade block blir ogiltiga.
+	*
+	*          - capacity: Antalet element, inklusive utfyllnad av varje block.
+	********************************************************************************/
+	void reserve(const std::size_t capacity)
+	{
+		this->buffer.assign(padded(capacity), T(0));
+		this->used = 0;
+		return;
+	}
+
+	/********************************************************************************
+	* allocate: Returnerar ett block med plats för n element, eller nullptr om
+	*           arenan inte har plats för det.
+	*
+	*           - n: Antalet element.
+	********************************************************************************/
+	T* allocate(const std::size_t n)
+	{
+		const auto size = padded(n);
+		if (this->used + size > this->buffer.size()) return nullptr;
+
+		const auto block = this->buffer.data() + this->used;
+		this->used += size;
+		return block;
+	}
+
+	void clear(void)
+	{
+		this->buffer.clear();
+		this->used = 0;
+		return;
+	}
+
+private:
+	std::vector<T, aligned_allocator<T>> buffer;
+	std::size_t used = 0;
+};
+
+#endif /* ARENA_HPP_ */
@@ -0,0 +1,91 @@
+/********************************************************************************
+* allocation_counter.cpp: Ersätter global operator new och operator delete i
+*                         samtliga former (enstaka objekt, arrayer, nothrow
+*                         samt storleksangiven delete) med ett par som räknar
+*                         allokeringarna och hämtar respektive lämnar tillbaka
+*                         minnet via malloc och free. Varje form av new har
+*                         alltså en motsvarande delete som använder samma
+*                         allokator.
+*
+*                         Ersättningarna ligger i en egen översättningsenhet,
+*                         så att de inte kan inlinas i anropen. Kompilatorn ser
+*                         därmed enbart operator new och operator delete vid
+*                         anropen och aldrig free på ett minne från new.
+********************************************************************************/
+#include "allocation_counter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<std::size_t> count(0);
+
+	/***
+	* Funktionen allocate: Räknar allokeringen och hämtar minst en byte via
+	* malloc. Returnerar nullptr om minnet inte räcker.
+	**/
+	void* allocate(const std::size_t size) noexcept
+	{
+		count.fetch_add(1, std::memory_order_relaxed);
+		return std::malloc(size ? size : 1);
+	}
+}
+
+std::size_t allocation_count(void)
+{
+	return count.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size)
+{
+	if (void* data = allocate(size)) return data;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+	if (void* data = allocate(size)) return data;
+	throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void operator delete(void* data) noexcept
+{
+	std::free(data);
+}
+
+void operator delete[](void* data) noexcept
+{
+	std::free(data);
+}
+
+void operator delete(void* data, std::size_t) noexcept
+{
+	std::free(data);
+}
+
+void operator delete[](void* data, std::size_t) noexcept
+{
+	std::free(data);
+}
+
+void operator delete(void* data, const std::nothrow_t&) noexcept
+{
+	std::free(data);
+}
+
+void operator delete[](void* data, const std::nothrow_t&) noexcept
+{
+	std::free(data);
+}
@@ -0,0 +1,15 @@
+#ifndef ALLOCATION_COUNTER_HPP_
+#define ALLOCATION_COUNTER_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <cstddef>
+
+/********************************************************************************
+* allocation_count: Returnerar antalet dynamiska minnesallokeringar sedan
+*                   programmets start. Samtliga former av global operator new
+*                   ersätts i allocation_counter.cpp, så att även matrisernas
+*                   och standardbibliotekets allokeringar räknas.
+********************************************************************************/
+std::size_t allocation_count(void);
+
+#endif /* ALLOCATION_COUNTER_HPP_ */
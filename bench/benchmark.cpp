@@ -0,0 +1,800 @@
+/********************************************************************************
+* benchmark.cpp: Prestandamätning av dense-lager och nätverk för olika bredd,
+*                djup och batchstorlek. För nätverket i main.cpp jämförs även
+*                träning med float och double, med exakt och approximativ
+*                tanh och med olika optimeringsmetoder, static_ann och
+*                quantized_ann mot ann, dataparallell träning för olika
+*                antal trådar samt hyperparametersökningen.
+*                Resultatet skrivs ut som en tabell och sparas som JSON, så
+*                att mätningar från olika versioner kan jämföras.
+*
+*                Användning: neu_network_bench [--quick] [--output fil.json]
+*
+*                - --quick : Färre storlekar och kortare mättid per fall.
+*                - --output: Sökväg till JSON-filen (default bench_results.json).
+*
+*                Varje fall körs först en gång för uppvärmning, varefter
+*                antalet anrop per mätning väljs så att en mätning tar minst
+*                min_time_ms. Medianen av num_repeats mätningar redovisas.
+*                Startvärden för vikter och data är fasta, så att samma
+*                version ger samma arbete vid varje körning.
+********************************************************************************/
+#include "ann.hpp"
+#include "static_ann.hpp"
+#include "quantized_ann.hpp"
+#include "hyperparameter_search.hpp"
+#include "allocation_counter.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/********************************************************************************
+* measurement: Resultatet av ett mätfall.
+*
+*              - name                : Funktionen som mäts.
+*              - width               : Antalet noder per dolt lager.
+*              - depth               : Antalet dolda lager.
+*              - batch_size          : Antalet uppsättningar per anrop eller
+*                                      viktuppdatering.
+*              - ns_per_sample       : Tid per uppsättning indata.
+*              - gflops              : Flyttalsoperationer per sekund / 1e9.
+*              - allocations_per_call: Minnesallokeringar per anrop.
+********************************************************************************/
+struct measurement
+{
+	std::string name;
+	std::size_t width;
+	std::size_t depth;
+	std::size_t batch_size;
+	double ns_per_sample;
+	double gflops;
+	double allocations_per_call;
+};
+
+/********************************************************************************
+* settings: Inställningar för samtliga mätfall.
+********************************************************************************/
+struct settings
+{
+	bool quick = false;
+	std::string output_path = "bench_results.json";
+	double min_time_ms = 20.0;
+	std::size_t num_repeats = 5;
+};
+
+/***
+* Funktionen measure: Mäter angiven funktion, där varje anrop behandlar
+* samples_per_call uppsättningar och utför flops_per_call flyttalsoperationer.
+**/
+template <typename Function>
+static measurement measure(const settings& options, const char* name,
+	const std::size_t width, const std::size_t depth, const std::size_t batch_size,
+	const std::size_t samples_per_call, const double flops_per_call, Function&& function)
+{
+	typedef std::chrono::steady_clock clock;
+	function();
+
+	std::size_t num_calls = 1;
+
+	for (;;)
+	{
+		const auto start = clock::now();
+		for (std::size_t i = 0; i < num_calls; ++i) function();
+		const auto elapsed_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+		if (elapsed_ms >= options.min_time_ms || num_calls >= (std::size_t(1) << 30)) break;
+		num_calls *= elapsed_ms > 0.0 && options.min_time_ms / elapsed_ms < 16.0 ? 2 : 16;
+	}
+
+	std::vector<double> ns_per_call;
+	std::size_t num_allocations = 0;
+
+	for (std::size_t r = 0; r < options.num_repeats; ++r)
+	{
+		const auto allocations = allocation_count();
+		const auto start = clock::now();
+		for (std::size_t i = 0; i < num_calls; ++i) function();
+		ns_per_call.push_back(std::chrono::duration<double, std::nano>(clock::now() - start).count() / num_calls);
+		num_allocations += allocation_count() - allocations;
+	}
+
+	std::sort(ns_per_call.begin(), ns_per_call.end());
+	const auto median_ns = ns_per_call[ns_per_call.size() / 2];
+
+	measurement result;
+	result.name = name;
+	result.width = width;
+	result.depth = depth;
+	result.batch_size = batch_size;
+	result.ns_per_sample = median_ns / samples_per_call;
+	result.gflops = flops_per_call / median_ns;
+	result.allocations_per_call = static_cast<double>(num_allocations) / (num_calls * options.num_repeats);
+
+	std::printf("%-28s width %5zu  depth %zu  batch %3zu  %12.1f ns/sample  %7.2f GFLOP/s  %6.2f allocs/call\n",
+		name, width, depth, batch_size, result.ns_per_sample, result.gflops, result.allocations_per_call);
+	std::fflush(stdout);
+	return result;
+}
+
+/***
+* Funktionen random_rows: Returnerar num_rows rader med num_cols slumpmässiga
+* värden i intervallet [0, 1).
+**/
+static std::vector<std::vector<double>> random_rows(const std::size_t num_rows, const std::size_t num_cols,
+	prng::generator& generator)
+{
+	std::vector<std::vector<double>> rows(num_rows, std::vector<double>(num_cols));
+
+	for (auto& row : rows)
+	{
+		for (auto& value : row) value = generator.uniform();
+	}
+
+	return rows;
+}
+
+/***
+* Funktionen benchmark_layer: Mäter feedforward, backpropagate och optimize
+* för ett enskilt dolt lager med width noder och width insignaler, där nästa
+* lager också har width noder.
+**/
+static void benchmark_layer(const settings& options, const std::size_t width, std::vector<measurement>& results)
+{
+	prng::generator generator(1);
+	dense_layer layer(width, width, generator);
+	dense_layer next_layer(width, width, generator);
+	dense_layer::state_type state, next_state;
+	const auto input = random_rows(1, width, generator)[0];
+	const auto flops = 2.0 * width * width;
+
+	state.resize(width);
+	next_state.resize(width);
+	for (std::size_t i = 0; i < width; ++i) next_state.error[i] = 0.01 * (static_cast<double>(i % 7) - 3.0);
+
+	results.push_back(measure(options, "dense_layer::feedforward", width, 1, 1, 1, flops, [&]()
+	{
+		layer.feedforward(input, state);
+	}));
+
+	results.push_back(measure(options, "dense_layer::backpropagate", width, 1, 1, 1, flops, [&]()
+	{
+		layer.backpropagate(next_layer, next_state, state);
+	}));
+
+	/* Med felen från backpropageringen ovan och en liten lärhastighet ändras
+	   vikterna knappt under mätningen: */
+	results.push_back(measure(options, "dense_layer::optimize", width, 1, 1, 1, flops, [&]()
+	{
+		layer.optimize(input, state, 1e-9);
+	}));
+
+	return;
+}
+
+/***
+* Funktionen parameter_count: Returnerar antalet vikter i nätverket.
+**/
+template <typename T>
+static double parameter_count(const basic_ann<T>& network)
+{
+	double count = 0.0;
+
+	for (const auto& layer : network.get_hidden_layers())
+	{
+		count += static_cast<double>(layer.num_nodes()) * layer.num_weights();
+	}
+
+	return count + static_cast<double>(network.get_output_layer().num_nodes()) * network.get_output_layer().num_weights();
+}
+
+/***
+* Funktionen benchmark_network: Mäter ann::train med olika batchstorlek samt
+* ann::predict och ann::predict_batch för ett nätverk med 16 ingångar, depth
+* dolda lager med width noder vardera och 4 utgångar. Djupet som redovisas
+* är det antal dolda lager som nätverket faktiskt har.
+**/
+static void benchmark_network(const settings& options, const std::size_t width, const std::size_t depth,
+	std::vector<measurement>& results)
+{
+	const std::size_t num_inputs = 16;
+	const std::size_t num_outputs = 4;
+	const std::size_t num_samples = 64;
+	const std::size_t batch_sizes[] = { 1, 16, 64 };
+
+	prng::generator generator(1);
+	ann network(num_inputs, depth, width, num_outputs);
+	const auto actual_depth = network.get_hidden_layers().size();
+	const auto inputs = random_rows(num_samples, num_inputs, generator);
+	const auto references = random_rows(num_samples, num_outputs, generator);
+	const auto params = parameter_count(network);
+
+	network.set_training_data(inputs, references);
+
+	/* Per uppsättning: feedforward (2 flops per vikt), backpropagering och
+	   viktuppdatering (ca 4 flops per vikt): */
+	for (const auto batch_size : batch_sizes)
+	{
+		results.push_back(measure(options, "ann::train", width, actual_depth, batch_size, num_samples, 6.0 * params * num_samples, [&]()
+		{
+			network.train(1, 1e-9, batch_size);
+		}));
+	}
+
+	inference_context context;
+	network.init_context(context);
+
+	results.push_back(measure(options, "ann::predict", width, actual_depth, 1, 1, 2.0 * params, [&]()
+	{
+		network.predict(inputs[0], context);
+	}));
+
+	std::vector<double> packed_inputs(num_samples * num_inputs);
+	std::vector<double> packed_outputs(num_samples * num_outputs);
+
+	for (std::size_t i = 0; i < num_samples; ++i)
+	{
+		std::copy(inputs[i].begin(), inputs[i].end(), packed_inputs.begin() + i * num_inputs);
+	}
+
+	results.push_back(measure(options, "ann::predict_batch", width, actual_depth, num_samples, num_samples, 2.0 * params * num_samples, [&]()
+	{
+		network.predict_batch(packed_inputs.data(), num_samples, packed_outputs.data());
+	}));
+
+	return;
+}
+
+/***
+* Funktionen benchmark_parallel: Mäter en epok med ann::train_parallel och
+* ann::train_hogwild för ett till samtliga kärnors antal trådar, med samma
+* nätverk som benchmark_network med ett dolt lager, och skriver ut uppmätt
+* speedup jämfört med en tråd. Antalet trådar redovisas i namnet.
+**/
+static void benchmark_parallel(const settings& options, const std::size_t width, std::vector<measurement>& results)
+{
+	const std::size_t num_inputs = 16;
+	const std::size_t num_outputs = 4;
+	const std::size_t num_samples = 256;
+	const std::size_t batch_size = 64;
+	const std::size_t max_threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+
+	prng::generator generator(1);
+	ann network(num_inputs, 1, width, num_outputs);
+	const auto inputs = random_rows(num_samples, num_inputs, generator);
+	const auto references = random_rows(num_samples, num_outputs, generator);
+	const auto flops = 6.0 * parameter_count(network) * num_samples;
+	double parallel_baseline = 0.0, hogwild_baseline = 0.0;
+
+	network.set_training_data(inputs, references);
+
+	for (std::size_t num_threads = 1; num_threads <= max_threads; ++num_threads)
+	{
+		thread_pool pool(num_threads);
+		const auto parallel_name = "ann::train_parallel (" + std::to_string(num_threads) + "t)";
+		const auto hogwild_name = "ann::train_hogwild (" + std::to_string(num_threads) + "t)";
+
+		results.push_back(measure(options, parallel_name.c_str(), width, 1, batch_size, num_samples, flops, [&]()
+		{
+			network.train_parallel(pool, 1, 1e-9, batch_size);
+		}));
+		const auto parallel_ns = results.back().ns_per_sample;
+
+		results.push_back(measure(options, hogwild_name.c_str(), width, 1, 1, num_samples, flops, [&]()
+		{
+			network.train_hogwild(pool, 1, 1e-9);
+		}));
+		const auto hogwild_ns = results.back().ns_per_sample;
+
+		if (num_threads == 1)
+		{
+			parallel_baseline = parallel_ns;
+			hogwild_baseline = hogwild_ns;
+		}
+
+		std::printf("width %zu, %zu threads: train_parallel speedup %.2f, train_hogwild speedup %.2f\n",
+			width, num_threads, parallel_baseline / parallel_ns, hogwild_baseline / hogwild_ns);
+		std::fflush(stdout);
+	}
+
+	return;
+}
+
+/***
+* Funktionen truth_table: Returnerar träningsuppsättningarna i main.cpp, dvs.
+* pariteten av fyra knappar, där kombinationen 0110 saknas och 1000 finns två
+* gånger. Samma data används här, så att resultaten motsvarar nätverket som
+* styr lysdioden; med samtliga 16 kombinationer fastnar SGD med 4-4-1 vid
+* medelkvadratfelet 0.25.
+**/
+static void truth_table(std::vector<std::vector<double>>& inputs, std::vector<std::vector<double>>& outputs)
+{
+	inputs = {
+		{ 0, 0, 0, 0 }, { 0, 0, 0, 1 }, { 0, 0, 1, 0 }, { 0, 0, 1, 1 },
+		{ 0, 1, 0, 0 }, { 0, 1, 0, 1 }, { 0, 1, 1, 1 }, { 1, 0, 0, 0 },
+		{ 1, 0, 0, 0 }, { 1, 0, 0, 1 }, { 1, 0, 1, 0 }, { 1, 0, 1, 1 },
+		{ 1, 1, 0, 0 }, { 1, 1, 0, 1 }, { 1, 1, 1, 0 }, { 1, 1, 1, 1 } };
+
+	outputs = {
+		{ 0 }, { 1 }, { 1 }, { 0 },
+		{ 1 }, { 0 }, { 1 }, { 1 },
+		{ 1 }, { 0 }, { 0 }, { 1 },
+		{ 0 }, { 1 }, { 1 }, { 0 } };
+
+	return;
+}
+
+/***
+* Funktionen benchmark_static: Tränar ett nätverk med samma topologi som i
+* main.cpp, läser in det i static_ann<4, 4, 1> och mäter ann::predict mot
+* static_ann::predict. Största skillnaden mellan utsignalerna skrivs ut.
+**/
+static void benchmark_static(const settings& options, std::vector<measurement>& results)
+{
+	std::vector<std::vector<double>> inputs, outputs;
+	truth_table(inputs, outputs);
+
+	ann network(4, 1, 4, 1);
+	network.set_training_data(inputs, outputs);
+	network.set_optimizer(optimizer::type::nesterov);
+	network.train(2000, 0.03);
+
+	static static_ann<4, 4, 1> fixed;
+	if (!fixed.load(network)) return;
+
+	inference_context context;
+	std::vector<std::array<double, 4>> arrays;
+	double max_error = 0.0;
+
+	for (const auto& input : inputs)
+	{
+		std::array<double, 4> x;
+		std::copy(input.begin(), input.end(), x.begin());
+		arrays.push_back(x);
+
+		const auto error = std::fabs(network.predict(input, context)[0] - fixed.predict(x)[0]);
+		if (error > max_error) max_error = error;
+	}
+
+	std::printf("static_ann<4, 4, 1> max error vs ann::predict: %.3g\n", max_error);
+
+	const auto flops = 2.0 * parameter_count(network);
+	std::size_t index = 0;
+	volatile double sink = 0.0;
+
+	results.push_back(measure(options, "ann::predict (4-4-1)", 4, 1, 1, 1, flops, [&]()
+	{
+		sink = sink + network.predict(inputs[index++ % inputs.size()], context)[0];
+	}));
+
+	results.push_back(measure(options, "static_ann::predict (4-4-1)", 4, 1, 1, 1, flops, [&]()
+	{
+		sink = sink + fixed.predict(arrays[index++ % arrays.size()])[0];
+	}));
+
+	return;
+}
+
+/***
+* Funktionen benchmark_training: Mäter en epok ann::train med elementtypen T
+* och angivet tanh-läge på sanningstabellen. Därefter tränas ett nytt nätverk
+* med samma startvärden ett fast antal epoker, varefter medelkvadratfelet och
+* antalet korrekt avrundade utsignaler skrivs ut. Samtliga nätverk initieras
+* med samma slumptalsfrö, så att enbart elementtypen och tanh-läget skiljer.
+**/
+template <typename T>
+static void benchmark_training(const settings& options, const char* name, const std::size_t width,
+	const std::size_t batch_size, const activation::tanh_mode mode, std::vector<measurement>& results)
+{
+	std::vector<std::vector<double>> button_in, diod_out;
+	std::vector<std::vector<T>> inputs, references;
+	truth_table(button_in, diod_out);
+
+	for (std::size_t i = 0; i < button_in.size(); ++i)
+	{
+		inputs.push_back(std::vector<T>(button_in[i].begin(), button_in[i].end()));
+		references.push_back(std::vector<T>(diod_out[i].begin(), diod_out[i].end()));
+	}
+
+	const auto learning_rate = static_cast<T>(0.03);
+	const std::size_t num_epochs = 80000 / width + 2000;
+	basic_ann<T> network(4, 1, width, 1);
+	basic_ann<T> trained(4, 1, width, 1);
+
+	for (auto* target : { &network, &trained })
+	{
+		target->set_tanh_mode(mode);
+		target->set_training_data(inputs, references);
+	}
+
+	/* Per uppsättning: feedforward (2 flops per vikt), backpropagering och
+	   viktuppdatering (ca 4 flops per vikt): */
+	const auto flops = 6.0 * parameter_count(network) * inputs.size();
+
+	results.push_back(measure(options, name, width, 1, batch_size, inputs.size(), flops, [&]()
+	{
+		network.train(1, learning_rate, batch_size);
+	}));
+
+	trained.train(num_epochs, learning_rate, batch_size);
+
+	typename basic_ann<T>::inference_context context;
+	double squared_error = 0.0;
+	std::size_t num_correct = 0;
+
+	for (std::size_t i = 0; i < inputs.size(); ++i)
+	{
+		const double output = trained.predict(inputs[i], context)[0];
+		const double reference = references[i][0];
+		squared_error += (reference - output) * (reference - output);
+		if ((output + 0.5 >= 1.0) == (reference >= 0.5)) num_correct++;
+	}
+
+	std::printf("%s, hidden nodes %zu, batch %zu: %zu epochs, MSE %.3g, accuracy %zu/%zu\n",
+		name, width, batch_size, num_epochs, squared_error / inputs.size(), num_correct, inputs.size());
+	return;
+}
+
+/***
+* Funktionen benchmark_scalar_types: Jämför träningshastighet och noggrannhet
+* med float respektive double för olika bredd på det dolda lagret, både vid
+* träning uppsättning för uppsättning och med minibatcher.
+**/
+static void benchmark_scalar_types(const settings& options, std::vector<measurement>& results)
+{
+	const std::size_t widths[] = { 4, 64, 256 };
+	const std::size_t batch_sizes[] = { 1, 16 };
+
+	for (const auto width : widths)
+	{
+		for (const auto batch_size : batch_sizes)
+		{
+			benchmark_training<double>(options, "ann<double>::train", width, batch_size, activation::tanh_mode::exact, results);
+			benchmark_training<float>(options, "ann<float>::train", width, batch_size, activation::tanh_mode::exact, results);
+		}
+	}
+
+	return;
+}
+
+/***
+* Funktionen benchmark_activation: Jämför träningshastighet och noggrannhet
+* med exakt tanh (std::tanh) respektive den vektoriserade approximationen för
+* olika bredd på det dolda lagret.
+**/
+static void benchmark_activation(const settings& options, std::vector<measurement>& results)
+{
+	const std::size_t widths[] = { 4, 64, 256 };
+
+	for (const auto width : widths)
+	{
+		benchmark_training<double>(options, "ann::train (exact tanh)", width, 1, activation::tanh_mode::exact, results);
+		benchmark_training<double>(options, "ann::train (fast tanh)", width, 1, activation::tanh_mode::fast, results);
+	}
+
+	return;
+}
+
+/***
+* Funktionen benchmark_optimizers: Tränar 4-4-1-nätverket med olika
+* optimeringsmetoder och scheman för lärhastigheten tills medelkvadratfelet
+* understiger target_mse, dock högst max_epochs epoker. Antalet epoker och
+* tiden för träningen redovisas som median över fem startvärden, tillsammans
+* med antalet startvärden som inte nådde målet.
+**/
+static void benchmark_optimizers(void)
+{
+	struct configuration
+	{
+		const char* name;
+		optimizer::type method;
+		double learning_rate;
+		optimizer::schedule::type schedule;
+	};
+
+	const configuration configurations[] =
+	{
+		{ "sgd", optimizer::type::sgd, 0.03, optimizer::schedule::type::constant },
+		{ "momentum", optimizer::type::momentum, 0.03, optimizer::schedule::type::constant },
+		{ "nesterov", optimizer::type::nesterov, 0.03, optimizer::schedule::type::constant },
+		{ "nesterov, step", optimizer::type::nesterov, 0.03, optimizer::schedule::type::step },
+		{ "rmsprop", optimizer::type::rmsprop, 0.003, optimizer::schedule::type::constant },
+		{ "adam", optimizer::type::adam, 0.01, optimizer::schedule::type::constant },
+		{ "adam, cosine", optimizer::type::adam, 0.01, optimizer::schedule::type::cosine },
+	};
+
+	const double target_mse = 1e-3;
+	const std::size_t max_epochs = 20000;
+	const std::size_t num_seeds = 5;
+	std::vector<std::vector<double>> inputs, outputs;
+	truth_table(inputs, outputs);
+
+	for (const auto& config : configurations)
+	{
+		std::vector<std::size_t> epochs;
+		std::vector<double> elapsed_ms;
+		std::size_t num_failures = 0;
+
+		for (std::uint64_t seed = 1; seed <= num_seeds; ++seed)
+		{
+			ann network(4, 1, 4, 1);
+			optimizer::schedule schedule;
+			training::stopping stopping;
+
+			schedule.method = config.schedule;
+			schedule.step_size = 1000;
+			schedule.min_rate = 0.1;
+			stopping.target_loss = target_mse;
+			network.seed(seed);
+			network.set_training_data(inputs, outputs);
+			network.set_optimizer(config.method);
+			network.set_schedule(schedule);
+			network.set_stopping(stopping);
+
+			const auto start = std::chrono::steady_clock::now();
+			const auto result = network.train(max_epochs, config.learning_rate);
+
+			elapsed_ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+			epochs.push_back(result.epochs);
+			if (result.reason != training::stop_reason::target_reached) num_failures++;
+		}
+
+		std::sort(epochs.begin(), epochs.end());
+		std::sort(elapsed_ms.begin(), elapsed_ms.end());
+
+		std::printf("optimizer %-14s learning rate %.3g: epochs to MSE < %g %zu, time %.1f ms, not reached %zu/%zu\n",
+			config.name, config.learning_rate, target_mse, epochs[num_seeds / 2], elapsed_ms[num_seeds / 2],
+			num_failures, num_seeds);
+	}
+
+	return;
+}
+
+/***
+* Funktionen benchmark_quantized: Tränar nätverk med fyra insignaler och olika
+* bredd på det dolda lagret, kvantiserar dem och jämför det kvantiserade
+* nätverkets utsignaler med ann::predict. Största absoluta avvikelse och
+* antalet avvikande avrundade utsignaler skrivs ut, varefter tiden per
+* prediktion mäts för respektive väg.
+**/
+static void benchmark_quantized(const settings& options, std::vector<measurement>& results)
+{
+	const std::size_t widths[] = { 4, 16, 64 };
+	std::vector<std::vector<double>> inputs, outputs;
+	truth_table(inputs, outputs);
+
+	for (const auto width : widths)
+	{
+		ann network(4, 1, width, 1);
+		network.set_training_data(inputs, outputs);
+		network.train(80000 / width + 2000, 0.03);
+
+		quantized_ann quantized;
+		if (!quantized.quantize(network)) continue;
+
+		inference_context context;
+		std::vector<std::vector<std::int8_t>> quantized_inputs;
+		double max_error = 0.0;
+		std::size_t num_mismatches = 0;
+
+		for (const auto& input : inputs)
+		{
+			std::vector<std::int8_t> q(input.size());
+			for (std::size_t j = 0; j < input.size(); ++j) q[j] = quantized_ann::quantize_value(input[j]);
+			quantized_inputs.push_back(q);
+
+			std::int8_t output = 0;
+			quantized.predict(q.data(), &output);
+			const auto reference = network.predict(input, context)[0];
+			const auto approximation = quantized_ann::dequantize_value(output);
+
+			if (std::fabs(reference - approximation) > max_error) max_error = std::fabs(reference - approximation);
+			if ((reference + 0.5 >= 1.0) != (approximation + 0.5 >= 1.0)) num_mismatches++;
+		}
+
+		std::printf("quantized_ann, hidden nodes %zu: max error %.3g, rounding mismatches %zu/%zu\n",
+			width, max_error, num_mismatches, inputs.size());
+
+		const auto flops = 2.0 * parameter_count(network);
+		std::size_t index = 0;
+		volatile double sink = 0.0;
+		volatile std::int32_t int_sink = 0;
+
+		results.push_back(measure(options, "ann::predict (4 inputs)", width, 1, 1, 1, flops, [&]()
+		{
+			sink = sink + network.predict(inputs[index++ % inputs.size()], context)[0];
+		}));
+
+		results.push_back(measure(options, "quantized_ann::predict", width, 1, 1, 1, flops, [&]()
+		{
+			std::int8_t output = 0;
+			quantized.predict(quantized_inputs[index++ % quantized_inputs.size()].data(), &output);
+			int_sink = int_sink + output;
+		}));
+	}
+
+	return;
+}
+
+/***
+* Funktionen benchmark_search: Söker antal dolda noder, lärhastighet och
+* antal epoker för sanningstabellen via rutnätssökning, först med en tråd
+* och sedan med samtliga kärnor, med och utan pruning, och skriver ut bästa
+* konfigurationen och uppmätt speedup. Utan pruning är antalet körningar
+* detsamma i båda fallen. Samtliga 16 kombinationer används vid träningen,
+* varför ingen kan hållas utanför, och nätverken utvärderas därför på
+* samtliga uppsättningar i stället för via korsvalidering.
+**/
+static void benchmark_search(const settings& options)
+{
+	std::vector<std::vector<double>> inputs, outputs;
+	truth_table(inputs, outputs);
+
+	search::grid_space space;
+	space.hidden_nodes = options.quick ? std::vector<std::size_t>{ 2, 4 } : std::vector<std::size_t>{ 2, 4, 8, 16 };
+	space.learning_rates = { 0.01, 0.03, 0.1 };
+	space.epochs = options.quick ? std::vector<std::size_t>{ 500 } : std::vector<std::size_t>{ 500, 2000 };
+
+	search::settings search_options;
+	search_options.num_folds = 1;
+	search_options.optimizer.method = optimizer::type::nesterov;
+
+	const auto configs = search::grid(space);
+	thread_pool sequential(1);
+	thread_pool parallel;
+
+	for (const std::size_t prune_interval : { 0, 100 })
+	{
+		search_options.prune_interval = prune_interval;
+		const auto baseline = search::run(sequential, inputs, outputs, configs, search_options);
+		const auto report = search::run(parallel, inputs, outputs, configs, search_options);
+
+		std::printf("search::run, %s pruning, %zu threads: sequential %.3f s, parallel %.3f s, measured speedup %.2f\n",
+			prune_interval ? "with" : "without", parallel.size(), baseline.wall_seconds, report.wall_seconds,
+			baseline.wall_seconds / report.wall_seconds);
+		std::fflush(stdout);
+		report.print(std::cout);
+	}
+
+	return;
+}
+
+/***
+* Funktionen isa_name: Returnerar namnet på instruktionsuppsättningen som
+* beräkningskärnorna använder.
+**/
+static const char* isa_name(void)
+{
+	switch (simd::kernels<double>().level)
+	{
+	case simd::isa::avx512: return "avx512";
+	case simd::isa::avx2: return "avx2";
+	case simd::isa::sse2: return "sse2";
+	default: return "scalar";
+	}
+}
+
+static std::string compiler_name(void)
+{
+	std::ostringstream name;
+#if defined(_MSC_VER)
+	name << "msvc " << _MSC_VER;
+#elif defined(__clang__)
+	name << "clang " << __clang_major__ << "." << __clang_minor__;
+#elif defined(__GNUC__)
+	name << "gcc " << __GNUC__ << "." << __GNUC_MINOR__;
+#else
+	name << "unknown";
+#endif
+	return name.str();
+}
+
+/***
+* Funktionen write_json: Sparar samtliga resultat till angiven fil.
+**/
+static bool write_json(const settings& options, const std::vector<measurement>& results)
+{
+	std::ofstream file(options.output_path);
+	if (!file) return false;
+
+	file << "{\n";
+	file << "  \"scalar\": \"double\",\n";
+	file << "  \"isa\": \"" << isa_name() << "\",\n";
+	file << "  \"compiler\": \"" << compiler_name() << "\",\n";
+	file << "  \"min_time_ms\": " << options.min_time_ms << ",\n";
+	file << "  \"repeats\": " << options.num_repeats << ",\n";
+	file << "  \"results\": [\n";
+
+	for (std::size_t i = 0; i < results.size(); ++i)
+	{
+		const auto& result = results[i];
+		file << "    { \"name\": \"" << result.name << "\""
+			<< ", \"width\": " << result.width
+			<< ", \"depth\": " << result.depth
+			<< ", \"batch_size\": " << result.batch_size
+			<< ", \"ns_per_sample\": " << result.ns_per_sample
+			<< ", \"gflops\": " << result.gflops
+			<< ", \"allocations_per_call\": " << result.allocations_per_call
+			<< " }" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+
+	file << "  ]\n}\n";
+	return static_cast<bool>(file);
+}
+
+int main(int argc, char** argv)
+{
+	settings options;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string argument = argv[i];
+
+		if (argument == "--quick")
+		{
+			options.quick = true;
+			options.min_time_ms = 5.0;
+			options.num_repeats = 3;
+		}
+		else if (argument == "--output" && i + 1 < argc)
+		{
+			options.output_path = argv[++i];
+		}
+		else
+		{
+			std::fprintf(stderr, "Usage: %s [--quick] [--output file.json]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	const std::vector<std::size_t> widths = options.quick ?
+		std::vector<std::size_t>{ 16, 256 } : std::vector<std::size_t>{ 4, 16, 64, 256, 1024, 4096 };
+	const std::vector<std::size_t> depths = options.quick ?
+		std::vector<std::size_t>{ 1 } : std::vector<std::size_t>{ 1, 2, 4 };
+	std::vector<measurement> results;
+
+	std::printf("Kernels: %s, compiler: %s\n", isa_name(), compiler_name().c_str());
+
+	for (const auto width : widths)
+	{
+		benchmark_layer(options, width, results);
+	}
+
+	for (const auto width : widths)
+	{
+		for (const auto depth : depths)
+		{
+			benchmark_network(options, width, depth, results);
+		}
+	}
+
+	for (const auto width : widths)
+	{
+		benchmark_parallel(options, width, results);
+	}
+
+	benchmark_scalar_types(options, results);
+	benchmark_activation(options, results);
+	benchmark_optimizers();
+	benchmark_static(options, results);
+	benchmark_quantized(options, results);
+	benchmark_search(options);
+
+	if (!write_json(options, results))
+	{
+		std::fprintf(stderr, "Could not write %s\n", options.output_path.c_str());
+		return 1;
+	}
+
+	std::printf("Results written to %s\n", options.output_path.c_str());
+
+	/* Byggt med NEU_NETWORK_PROFILING skrivs även tiden per lager ut: */
+	if (profiling::enabled) profiling::print(std::cout);
+	return 0;
+}
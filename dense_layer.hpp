@@ -1,252 +1,824 @@
-#ifndef DENSE_LAYER_HPP_
-#define DENSE_LAYER_HPP_
-
-/* Inkluderingsdirektiv: */
-#include <vector>
-#include <iostream>
-#include <iomanip>
-#include <cstdlib>
-#include <cmath>
-
-using namespace std;
-
-struct dense_layer
-{
-	std::vector<double> output;
-	std::vector<double> error;
-	std::vector<double> bias;
-	std::vector<std::vector<double>> weights;
-
-	dense_layer(void) { }
-
-	dense_layer(const std::size_t num_nodes,
-		const std::size_t num_weights)
-	{
-		this->resize(num_nodes, num_weights);
-		return;
-	}
-
-	~dense_layer(void)
-	{
-		this->clear();
-		return;
-	}
-
-	/********************************************************************************
-	* num_nodes: Returnerar antalet befintliga noder i angivet dense-lager.
-	********************************************************************************/
-	inline std::size_t num_nodes(void) const
-	{
-		return this->output.size();
-	}
-
-	/********************************************************************************
-	* num_weights: Returnerar antalet vikter per nod i angivet dense-lager.
-	********************************************************************************/
-	inline std::size_t num_weights(void) const
-	{
-		return this->weights.size() ? this->weights[0].size() : 0;
-	}
-
-	/********************************************************************************
-	* clear: Tmmer angiven vektor.
-	********************************************************************************/
-	void clear(void)
-	{
-		this->output.clear();
-		this->error.clear();
-		this->bias.clear();
-		this->weights.clear();
-		return;
-	}
-
-	void resize(const std::size_t num_nodes,
-		const std::size_t num_weights)
-	{
-		this->output.resize(num_nodes, 0.0);
-		this->error.resize(num_nodes, 0.0);
-		this->bias.resize(num_nodes, 0.0);
-		this->weights.resize(num_nodes, std::vector<double>(num_weights, 0.0));
-
-		for (std::size_t i = 0; i < num_nodes; ++i)
-		{
-			this->bias[i] = this->get_random();
-
-			for (std::size_t j = 0; j < num_weights; ++j)
-			{
-				this->weights[i][j] = this->get_random();
-			}
-		}
-
-		return;
-	}
-
-
-	static void print(const std::vector<double>& data,
-		std::ostream& ostream = std::cout,
-		const std::size_t num_decimals = 1,
-		const double threshold = 0.001)
-	{
-		ostream << std::fixed;
-
-		for (auto& i : data)
-		{
-			ostream << std::setprecision(num_decimals) << get_rounded(i, threshold) << " ";
-		}
-
-		ostream << "\n";
-		return;
-	}
-
-	void print(std::ostream& ostream = std::cout) const
-	{
-		ostream << "--------------------------------------------------------------------------------\n";
-		ostream << "Number of nodes: " << this->num_nodes() << "\n";
-		ostream << "Number of weights per node: " << this->num_weights() << "\n\n";
-
-		ostream << "Output: ";
-		this->print(this->output, ostream);
-
-		ostream << "Error: ";
-		this->print(this->error, ostream);
-
-		ostream << "Bias: ";
-		this->print(this->bias, ostream);
-
-		ostream << "\nWeights:\n";
-
-		for (std::size_t i = 0; i < this->num_nodes(); ++i)
-		{
-			ostream << "Node " << i + 1 << ": ";
-			this->print(this->weights[i], ostream);
-		}
-
-		ostream << "--------------------------------------------------------------------------------\n\n";
-		return;
-	}
-
-	void feedforward(const std::vector<double>& input)
-	{
-		for (std::size_t i = 0; i < this->num_nodes(); ++i)
-		{
-			auto sum = this->bias[i];
-
-			for (std::size_t j = 0; j < this->num_weights() && j < input.size(); ++j)
-			{
-				sum += input[j] * this->weights[i][j];
-			}
-
-			this->output[i] = this->tanh(sum);
-		}
-
-		return;
-	}
-
-	void backpropagate(const std::vector<double>& reference)
-	{
-		for (std::size_t i = 0; i < this->num_nodes() && i < reference.size(); ++i)
-		{
-			const auto dev = reference[i] - this->output[i];
-			this->error[i] = dev * delta_tanh(this->output[i]);
-		}
-
-		return;
-	}
-
-	/********************************************************************************
-	* backpropagate: Berknar fel/avvikelser i angivet dolt lager via parametrar
-	*                frn nsta/efterfljande lager. OBS! Denna medlemsfunktion
-	*                r avsedd enbart fr dolda lager, se den alternativa
-	*                medlemsfunktionen med samma namn fr utgngslager.
-	*
-	*                - next_layer: Referens till nsta/efterfljande dense-lager.
-	********************************************************************************/
-	void backpropagate(const dense_layer& next_layer)
-	{
-		for (std::size_t i = 0; i < this->num_nodes(); ++i)
-		{
-			auto dev = 0.0;
-
-			for (std::size_t j = 0; j < next_layer.num_nodes(); ++j)
-			{
-				dev += next_layer.error[j] * next_layer.weights[j][i];
-			}
-
-			this->error[i] = dev * this->delta_tanh(this->output[i]);
-		}
-
-		return;
-	}
-
-	void optimize(const std::vector<double>& input,
-		const double learning_rate)
-	{
-		for (std::size_t i = 0; i < this->num_nodes(); ++i)
-		{
-			this->bias[i] += this->error[i] * learning_rate;
-
-			for (std::size_t j = 0; j < this->num_weights() && j < input.size(); ++j)
-			{
-				this->weights[i][j] += this->error[i] * learning_rate * input[j];
-			}
-		}
-
-		return;
-	}
-
-private:
-	/********************************************************************************
-	* get_random: Returnerar ett randomiserat flyttal mellan 0.0 - 1.0.
-	********************************************************************************/
-	static inline double get_random(void)
-	{
-		return static_cast<double>(std::rand()) / RAND_MAX;
-	}
-
-	/********************************************************************************
-	* relu: Implementerar en ReLU-funktion, dr utsignalen y stts till angiven
-	*       summa sum om denna summa verstiger 0, annars stts utsignalen till 0.
-	*       Utsignalen y returneras efter berkning. Om summan verstiger 0 s r
-	*       aktuell nod aktiverad, annars r den inaktiverad:
-	*
-	*       sum > 0  => y = sum (noden aktiverad)
-	*       sum <= 0 => y = 0   (noden inaktiverad)
-	*
-	*       - sum: Summan av nodens bias samt  indata (insignaler * vikter).
-	********************************************************************************/
-	static inline double tanh(const double sum)
-	{
-		return std::tanh(sum);
-	}
-
-	static inline double delta_tanh(const double output)
-	{
-		return 1 - std::pow(std::tanh(output), 2);
-	}
-
-	/********************************************************************************
-	* get_rounded: Kontrollerar angivet flyttal och returnerar noll ifall detta
-	*              ligger inom angivet intervall [-threshold, threshold].
-	*              I praktiken gller drmed att flyttalet jmfrs med
-	*              absolutbeloppet av angivet trskelvrde. Annars om flyttalet
-	*              i frga inte ligger inom intervallet returneras detta tal.
-	*
-	*              - number   : Flyttalet som ska kontrolleras.
-	*              - threshold: Trskelvrdet som anvnds fr jmfrelse.
-	********************************************************************************/
-	static double get_rounded(const double number,
-		const double threshold = 0.001)
-	{
-		if (number > -threshold && number < threshold)
-		{
-			return 0;
-		}
-		else
-		{
-			return number;
-		}
-	}
-};
-
-
-#endif /* DENSE_LAYER_HPP_ */  #pragma once
+#ifndef DENSE_LAYER_HPP_
+#define DENSE_LAYER_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+#include "matrix.hpp"
+#include "arena.hpp"
+#include "simd_kernels.hpp"
+#include "activation.hpp"
+#include "optimizer.hpp"
+#include "prng.hpp"
+
+using namespace std;
+
+/********************************************************************************
+* basic_layer_state: Utsignaler och fel för ett dense-lager vid beräkning av
+*                    en enskild uppsättning indata. Tillståndet hålls åtskilt
+*                    från lagrets parametrar (vikter och bias), så att flera
+*                    trådar kan använda samma lager med var sitt tillstånd.
+********************************************************************************/
+template <typename T>
+struct basic_layer_state
+{
+	std::vector<T> output;
+	std::vector<T> error;
+
+	void resize(const std::size_t num_nodes)
+	{
+		this->output.assign(num_nodes, T(0));
+		this->error.assign(num_nodes, T(0));
+		return;
+	}
+};
+
+/********************************************************************************
+* basic_layer_batch: Buffertar för ett dense-lager vid träning med minibatcher.
+*                    Varje rad i output och error motsvarar en
+*                    träningsuppsättning i batchen. Gradienterna summeras över
+*                    hela batchen innan vikterna uppdateras en gång. Samtliga
+*                    buffertar ligger i en arena som ägs av träningstillståndet,
+*                    se basic_training_context.
+********************************************************************************/
+template <typename T>
+struct basic_layer_batch
+{
+	typedef basic_arena<T> arena_type;
+
+	basic_matrix<T> output;
+	basic_matrix<T> error;
+	basic_matrix<T> weight_gradient;
+	basic_array<T> bias_gradient;
+
+	/* Antalet element i arenan för lagrets gradienter respektive för
+	   utsignaler och fel för batch_size rader: */
+	static std::size_t gradient_count(const std::size_t num_nodes, const std::size_t num_weights)
+	{
+		return arena_type::padded(num_nodes * basic_matrix<T>::stride_for(num_weights)) + arena_type::padded(num_nodes);
+	}
+
+	static std::size_t buffer_count(const std::size_t batch_size, const std::size_t num_nodes)
+	{
+		return 2 * arena_type::padded(batch_size * basic_matrix<T>::stride_for(num_nodes));
+	}
+
+	/********************************************************************************
+	* attach_gradients: Placerar vikt- och biasgradienten i angiven arena, som
+	*                   måste ha plats för gradient_count element.
+	********************************************************************************/
+	void attach_gradients(arena_type& arena,
+		const std::size_t num_nodes,
+		const std::size_t num_weights)
+	{
+		const auto stride = basic_matrix<T>::stride_for(num_weights);
+		this->weight_gradient.attach(arena.allocate(num_nodes * stride), num_nodes, num_weights, stride);
+		this->bias_gradient.attach(arena.allocate(num_nodes), num_nodes);
+		return;
+	}
+
+	/********************************************************************************
+	* attach_buffers: Placerar utsignaler och fel för batch_size rader i angiven
+	*                 arena, som måste ha plats för buffer_count element.
+	********************************************************************************/
+	void attach_buffers(arena_type& arena,
+		const std::size_t batch_size,
+		const std::size_t num_nodes)
+	{
+		const auto stride = basic_matrix<T>::stride_for(num_nodes);
+		this->output.attach(arena.allocate(batch_size * stride), batch_size, num_nodes, stride);
+		this->error.attach(arena.allocate(batch_size * stride), batch_size, num_nodes, stride);
+		return;
+	}
+};
+
+/********************************************************************************
+* basic_dense_layer: Dense-lager med parametrar av typen T, normalt double
+*                    eller float. Med float halveras minnesåtgången och
+*                    beräkningskärnorna behandlar dubbelt så många element per
+*                    instruktion, på bekostnad av lägre precision.
+********************************************************************************/
+template <typename T>
+struct basic_dense_layer
+{
+	typedef T value_type;
+	typedef basic_layer_state<T> state_type;
+	typedef basic_matrix_view<T> matrix_view;
+	typedef basic_const_matrix_view<T> const_matrix_view;
+
+	basic_array<T> bias;
+	basic_matrix<T> weights;
+	basic_matrix<T> weights_t;
+	bool use_transposed = false;
+	activation::type activation_type = activation::type::tanh;
+	activation::tanh_mode activation_mode = activation::tanh_mode::exact;
+
+	/* Antalet noder vars summor beräknas innan aktiveringsfunktionen
+	   tillämpas på dem, se feedforward_fused: */
+	static constexpr std::size_t fused_tile_size = 32;
+
+	basic_dense_layer(void) { }
+
+	basic_dense_layer(const std::size_t num_nodes,
+		const std::size_t num_weights)
+	{
+		this->resize(num_nodes, num_weights);
+		return;
+	}
+
+	~basic_dense_layer(void)
+	{
+		this->clear();
+		return;
+	}
+
+	/********************************************************************************
+	* num_nodes: Returnerar antalet befintliga noder i angivet dense-lager.
+	********************************************************************************/
+	inline std::size_t num_nodes(void) const
+	{
+		return this->bias.size();
+	}
+
+	/********************************************************************************
+	* num_weights: Returnerar antalet vikter per nod i angivet dense-lager.
+	********************************************************************************/
+	inline std::size_t num_weights(void) const
+	{
+		return this->weights.cols();
+	}
+
+	/********************************************************************************
+	* clear: Tömmer angiven vektor.
+	********************************************************************************/
+	void clear(void)
+	{
+		this->bias.clear();
+		this->weights.clear();
+		this->weights_t.clear();
+		return;
+	}
+
+	basic_dense_layer(const std::size_t num_nodes,
+		const std::size_t num_weights,
+		prng::generator& generator,
+		const prng::init_scheme scheme = prng::init_scheme::uniform)
+	{
+		this->resize(num_nodes, num_weights, generator, scheme);
+		return;
+	}
+
+	/********************************************************************************
+	* resize: Ändrar lagrets storlek och tilldelar nya startvärden med en
+	*         generator med standardfrö, dvs. samma värden vid varje anrop.
+	*
+	*         - num_nodes  : Antalet noder.
+	*         - num_weights: Antalet vikter per nod.
+	********************************************************************************/
+	void resize(const std::size_t num_nodes,
+		const std::size_t num_weights)
+	{
+		prng::generator generator;
+		this->resize(num_nodes, num_weights, generator);
+		return;
+	}
+
+	/********************************************************************************
+	* resize: Ändrar lagrets storlek och tilldelar nya startvärden, se initialize.
+	*
+	*         - num_nodes  : Antalet noder.
+	*         - num_weights: Antalet vikter per nod.
+	*         - generator  : Generatorn som startvärdena dras från.
+	*         - scheme     : Fördelning för startvärdena (default [-1, 1]).
+	********************************************************************************/
+	void resize(const std::size_t num_nodes,
+		const std::size_t num_weights,
+		prng::generator& generator,
+		const prng::init_scheme scheme = prng::init_scheme::uniform)
+	{
+		this->bias.resize(num_nodes, T(0));
+		this->weights.resize(num_nodes, num_weights);
+		this->initialize(generator, scheme);
+		return;
+	}
+
+	/********************************************************************************
+	* initialize: Tilldelar vikter och bias nya startvärden enligt angiven
+	*             metod, se prng::init_scheme. Med automatic väljs metod utifrån
+	*             lagrets aktiveringsfunktion, som därmed ska vara satt innan.
+	*             Vikterna dras radvis i nodordning, så att samma frö alltid ger
+	*             samma startvärden.
+	*
+	*             - generator: Generatorn som startvärdena dras från.
+	*             - scheme   : Fördelning för startvärdena.
+	********************************************************************************/
+	void initialize(prng::generator& generator, prng::init_scheme scheme)
+	{
+		if (scheme == prng::init_scheme::automatic)
+		{
+			scheme = this->activation_type == activation::type::relu ? prng::init_scheme::he : prng::init_scheme::xavier;
+		}
+
+		const auto limit = prng::init_limit(scheme, this->num_weights(), this->num_nodes());
+		const auto random_bias = scheme == prng::init_scheme::uniform;
+
+		for (std::size_t i = 0; i < this->num_nodes(); ++i)
+		{
+			this->bias[i] = random_bias ? static_cast<T>(generator.uniform(-1.0, 1.0)) : T(0);
+			auto w = this->weights.row(i);
+
+			for (std::size_t j = 0; j < this->num_weights(); ++j)
+			{
+				w[j] = static_cast<T>(generator.uniform(-limit, limit));
+			}
+		}
+
+		if (this->use_transposed) this->weights.transpose_into(this->weights_t);
+		return;
+	}
+
+	/********************************************************************************
+	* enable_transposed: Aktiverar eller avaktiverar en transponerad kopia av
+	*                    vikterna. Kopian används av föregående lager vid
+	*                    backpropagering, då varje nods fel beräknas som en
+	*                    skalärprodukt över en sammanhängande rad. Kopian
+	*                    uppdateras efter varje optimering.
+	*
+	*                    - enabled: Indikerar ifall kopian ska användas.
+	********************************************************************************/
+	void enable_transposed(const bool enabled = true)
+	{
+		this->use_transposed = enabled;
+
+		if (enabled)
+		{
+			this->weights.transpose_into(this->weights_t);
+		}
+		else
+		{
+			this->weights_t.clear();
+		}
+
+		return;
+	}
+
+	/********************************************************************************
+	* parameter_count: Returnerar antalet element som lagrets bias och vikter
+	*                  upptar i en arena, dvs. bias utfylld till en hel
+	*                  cache-rad följd av viktmatrisens rader inklusive
+	*                  utfyllnad. Samma layout används av write_parameters och
+	*                  read_parameters.
+	********************************************************************************/
+	static std::size_t parameter_count(const std::size_t num_nodes,
+		const std::size_t num_weights)
+	{
+		return basic_arena<T>::padded(num_nodes) + num_nodes * basic_matrix<T>::stride_for(num_weights);
+	}
+
+	inline std::size_t parameter_count(void) const
+	{
+		return parameter_count(this->num_nodes(), this->num_weights());
+	}
+
+	/********************************************************************************
+	* write_parameters: Kopierar bias och vikter till angiven buffert med
+	*                   layouten enligt parameter_count. Utfyllnaden nollställs.
+	*
+	*                   - destination: Buffert med plats för parameter_count() element.
+	********************************************************************************/
+	void write_parameters(T* destination) const
+	{
+		const auto stride = basic_matrix<T>::stride_for(this->num_weights());
+		const auto weights = destination + basic_arena<T>::padded(this->num_nodes());
+
+		std::fill(destination, weights, T(0));
+		std::copy(this->bias.begin(), this->bias.end(), destination);
+
+		for (std::size_t i = 0; i < this->num_nodes(); ++i)
+		{
+			const auto row = this->weights.row(i);
+			std::copy(row, row + this->num_weights(), weights + i * stride);
+			std::fill(weights + i * stride + this->num_weights(), weights + (i + 1) * stride, T(0));
+		}
+
+		return;
+	}
+
+	/********************************************************************************
+	* read_parameters: Tilldelar bias och vikter från angiven buffert med
+	*                  layouten enligt parameter_count.
+	*
+	*                  - source: Buffert med parameter_count() element.
+	********************************************************************************/
+	void read_parameters(const T* source)
+	{
+		const auto stride = basic_matrix<T>::stride_for(this->num_weights());
+		const auto weights = source + basic_arena<T>::padded(this->num_nodes());
+
+		std::copy(source, source + this->num_nodes(), this->bias.begin());
+
+		for (std::size_t i = 0; i < this->num_nodes(); ++i)
+		{
+			std::copy(weights + i * stride, weights + i * stride + this->num_weights(), this->weights.row(i));
+		}
+
+		if (this->use_transposed) this->weights.transpose_into(this->weights_t);
+		return;
+	}
+
+	/********************************************************************************
+	* attach_parameters: Placerar lagrets bias och vikter i ett block i angiven
+	*                    arena, som måste ha plats för parameter_count element.
+	*                    Anges storleken får lagret num_nodes noder med
+	*                    num_weights vikter vardera, med arenans värden (normalt
+	*                    noll). Annars flyttas befintliga parametrar dit med
+	*                    bibehållna värden.
+	*
+	*                    - arena      : Arenan som parametrarna placeras i.
+	*                    - num_nodes  : Antalet noder.
+	*                    - num_weights: Antalet vikter per nod.
+	********************************************************************************/
+	void attach_parameters(basic_arena<T>& arena,
+		const std::size_t num_nodes,
+		const std::size_t num_weights)
+	{
+		const auto block = arena.allocate(parameter_count(num_nodes, num_weights));
+
+		this->bias.attach(block, num_nodes);
+		this->weights.attach(block + basic_arena<T>::padded(num_nodes), num_nodes, num_weights,
+			basic_matrix<T>::stride_for(num_weights));
+		return;
+	}
+
+	void attach_parameters(basic_arena<T>& arena)
+	{
+		const auto num_nodes = this->num_nodes();
+		const auto num_weights = this->num_weights();
+		const auto block = arena.allocate(this->parameter_count());
+
+		this->write_parameters(block);
+		this->bias.attach(block, num_nodes);
+		this->weights.attach(block + basic_arena<T>::padded(num_nodes), num_nodes, num_weights,
+			basic_matrix<T>::stride_for(num_weights));
+		return;
+	}
+
+
+	static void print(const std::vector<T>& data,
+		std::ostream& ostream = std::cout,
+		const std::size_t num_decimals = 1,
+		const double threshold = 0.001)
+	{
+		print(data.data(), data.size(), ostream, num_decimals, threshold);
+		return;
+	}
+
+	static void print(const T* data,
+		const std::size_t size,
+		std::ostream& ostream = std::cout,
+		const std::size_t num_decimals = 1,
+		const double threshold = 0.001)
+	{
+		ostream << std::fixed;
+
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			ostream << std::setprecision(num_decimals) << get_rounded(data[i], threshold) << " ";
+		}
+
+		ostream << "\n";
+		return;
+	}
+
+	void print(std::ostream& ostream = std::cout) const
+	{
+		ostream << "--------------------------------------------------------------------------------\n";
+		ostream << "Number of nodes: " << this->num_nodes() << "\n";
+		ostream << "Number of weights per node: " << this->num_weights() << "\n\n";
+
+		ostream << "Bias: ";
+		this->print(this->bias.data(), this->num_nodes(), ostream);
+
+		ostream << "\nWeights:\n";
+
+		for (std::size_t i = 0; i < this->num_nodes(); ++i)
+		{
+			ostream << "Node " << i + 1 << ": ";
+			this->print(this->weights.row(i), this->num_weights(), ostream);
+		}
+
+		ostream << "--------------------------------------------------------------------------------\n\n";
+		return;
+	}
+
+	/********************************************************************************
+	* feedforward: Beräknar lagrets utsignaler för angiven indata med lagrets
+	*              aktiveringsfunktion, se feedforward_fused.
+	*
+	*              - input     : Pekare till indata.
+	*              - num_inputs: Antalet element i indata.
+	*              - output    : Pekare till buffert för num_nodes() utsignaler.
+	********************************************************************************/
+	void feedforward(const T* input,
+		const std::size_t num_inputs,
+		T* output) const
+	{
+		activation::dispatch(this->activation_type, [&](auto policy)
+		{
+			this->template feedforward_fused<decltype(policy)>(input, num_inputs, output);
+		});
+
+		return;
+	}
+
+	/********************************************************************************
+	* feedforward_fused: Beräknar bias + vikter * indata och aktiveringsfunktionen
+	*                    i ett svep, block om fused_tile_size noder åt gången.
+	*                    Varje blocks summor aktiveras direkt medan de ligger
+	*                    kvar i L1-cachen, i stället för att samtliga summor
+	*                    först skrivs ut och sedan läses in igen. Policy är en
+	*                    av policyklasserna i namnrymden activation.
+	*
+	*                    - input     : Pekare till indata.
+	*                    - num_inputs: Antalet element i indata.
+	*                    - output    : Pekare till buffert för num_nodes() utsignaler.
+	********************************************************************************/
+	template <typename Policy>
+	void feedforward_fused(const T* input,
+		const std::size_t num_inputs,
+		T* output) const
+	{
+		const auto n = this->num_weights() < num_inputs ? this->num_weights() : num_inputs;
+
+		for (std::size_t first = 0; first < this->num_nodes(); first += fused_tile_size)
+		{
+			const auto last = first + fused_tile_size < this->num_nodes() ? first + fused_tile_size : this->num_nodes();
+
+			for (std::size_t i = first; i < last; ++i)
+			{
+				output[i] = this->bias[i] + simd::dot(input, this->weights.row(i), n);
+			}
+
+			Policy::apply(output + first, last - first, this->activation_mode);
+		}
+
+		return;
+	}
+
+	void feedforward(const std::vector<T>& input,
+		state_type& state) const
+	{
+		this->feedforward(input.data(), input.size(), state.output.data());
+		return;
+	}
+
+	void backpropagate(const std::vector<T>& reference,
+		state_type& state) const
+	{
+		this->backpropagate(reference.data(), reference.size(), state);
+		return;
+	}
+
+	/********************************************************************************
+	* backpropagate: Beräknar fel/avvikelser i utgångslagret via jämförelse med
+	*                referensdata, som kan ligga i godtycklig buffert.
+	*
+	*                - reference     : Pekare till korrekta utsignaler.
+	*                - num_references: Antalet element i referensdata.
+	*                - state         : Referens till lagrets tillstånd.
+	********************************************************************************/
+	void backpropagate(const T* reference,
+		const std::size_t num_references,
+		state_type& state) const
+	{
+		const auto n = this->num_nodes() < num_references ? this->num_nodes() : num_references;
+
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			state.error[i] = reference[i] - state.output[i];
+		}
+
+		activation::multiply_derivative(this->activation_type, state.output.data(), state.error.data(), n);
+		return;
+	}
+
+	/********************************************************************************
+	* backpropagate: Beräknar fel/avvikelser i angivet dolt lager via parametrar
+	*                från nästa/efterföljande lager. OBS! Denna medlemsfunktion
+	*                är avsedd enbart för dolda lager, se den alternativa
+	*                medlemsfunktionen med samma namn för utgångslager.
+	*
+	*                - next_layer: Referens till nästa/efterföljande dense-lager.
+	*                - next_state: Referens till nästa lagers tillstånd.
+	*                - state     : Referens till detta lagers tillstånd.
+	********************************************************************************/
+	void backpropagate(const basic_dense_layer& next_layer,
+		const state_type& next_state,
+		state_type& state) const
+	{
+		if (next_layer.use_transposed)
+		{
+			for (std::size_t i = 0; i < this->num_nodes(); ++i)
+			{
+				state.error[i] = simd::dot(next_state.error.data(), next_layer.weights_t.row(i), next_layer.num_nodes());
+			}
+		}
+		else
+		{
+			/* Utan transponerad kopia ackumuleras felen rad för rad i nästa lagers
+			   viktmatris, så att minnet läses sekventiellt: */
+			simd::gemv_t(next_layer.weights.view(), next_state.error.data(), state.error.data());
+		}
+
+		activation::multiply_derivative(this->activation_type, state.output.data(), state.error.data(), this->num_nodes());
+		return;
+	}
+
+	void optimize(const std::vector<T>& input,
+		const state_type& state,
+		const T learning_rate)
+	{
+		this->optimize(input.data(), input.size(), state, learning_rate);
+		return;
+	}
+
+	/********************************************************************************
+	* optimize: Justerar vikter och bias utifrån felen med ursprunglig metod,
+	*           där indata kan ligga i godtycklig buffert.
+	*
+	*           - input        : Pekare till indata som användes vid feedforward.
+	*           - num_inputs   : Antalet element i indata.
+	*           - state        : Lagrets tillstånd med beräknade fel.
+	*           - learning_rate: Lärhastigheten.
+	********************************************************************************/
+	void optimize(const T* input,
+		const std::size_t num_inputs,
+		const state_type& state,
+		const T learning_rate)
+	{
+		const auto n = this->num_weights() < num_inputs ? this->num_weights() : num_inputs;
+
+		for (std::size_t i = 0; i < this->num_nodes(); ++i)
+		{
+			const auto delta = state.error[i] * learning_rate;
+			this->bias[i] += delta;
+			simd::axpy(delta, input, this->weights.row(i), n);
+		}
+
+		if (this->use_transposed) this->weights.transpose_into(this->weights_t);
+		return;
+	}
+
+	/********************************************************************************
+	* optimize: Justerar vikter och bias utifrån felen med angiven metod, där
+	*           varje rad vikter och tillhörande moment uppdateras i ett svep.
+	*
+	*           - input     : Pekare till indata som användes vid feedforward.
+	*           - num_inputs: Antalet element i indata.
+	*           - state     : Lagrets tillstånd med beräknade fel.
+	*           - step      : Koefficienter för aktuell uppdatering.
+	*           - slots     : Lagrets tillståndsbuffertar för vald metod.
+	********************************************************************************/
+	void optimize(const T* input,
+		const std::size_t num_inputs,
+		const state_type& state,
+		const optimizer::basic_step<T>& step,
+		optimizer::basic_state<T>& slots)
+	{
+		const auto n = this->num_weights() < num_inputs ? this->num_weights() : num_inputs;
+
+		optimizer::dispatch(step.method, [&](auto policy)
+		{
+			typedef decltype(policy) policy_type;
+
+			for (std::size_t i = 0; i < this->num_nodes(); ++i)
+			{
+				policy_type::update(step, state.error[i], input, this->weights.row(i),
+					slots.weight_moment.row(i), slots.weight_variance.row(i), n);
+			}
+
+			policy_type::update(step, T(1), state.error.data(), this->bias.data(),
+				slots.bias_moment.data(), slots.bias_variance.data(), this->num_nodes());
+		});
+
+		if (this->use_transposed) this->weights.transpose_into(this->weights_t);
+		return;
+	}
+
+	void optimize(const std::vector<T>& input,
+		const state_type& state,
+		const optimizer::basic_step<T>& step,
+		optimizer::basic_state<T>& slots)
+	{
+		this->optimize(input.data(), input.size(), state, step, slots);
+		return;
+	}
+
+	/********************************************************************************
+	* feedforward_batch: Beräknar utsignaler för samtliga rader i en batch.
+	*                    Summeringen sker som en blockad matrismultiplikation
+	*                    output = f(input * weights^T + bias), där bias och
+	*                    aktiveringsfunktionen f tillämpas i samma svep per rad.
+	*
+	*                    - input : Vy över batchens indata, en rad per uppsättning.
+	*                    - output: Vy som tilldelas lagrets utsignaler.
+	********************************************************************************/
+	void feedforward_batch(const const_matrix_view& input,
+		const matrix_view& output) const
+	{
+		simd::gemm_nt(input, this->weights.view(), output);
+
+		activation::dispatch(this->activation_type, [&](auto policy)
+		{
+			typedef decltype(policy) policy_type;
+
+			for (std::size_t r = 0; r < output.rows; ++r)
+			{
+				auto y = output.row(r);
+
+				for (std::size_t i = 0; i < this->num_nodes(); ++i)
+				{
+					y[i] += this->bias[i];
+				}
+
+				policy_type::apply(y, this->num_nodes(), this->activation_mode);
+			}
+		});
+
+		return;
+	}
+
+	/********************************************************************************
+	* backpropagate_batch: Beräknar fel för ett utgångslager över en hel batch.
+	*
+	*                      - reference: Vy över korrekta värden, en rad per uppsättning.
+	*                      - output   : Vy över lagrets utsignaler.
+	*                      - error    : Vy som tilldelas lagrets fel.
+	********************************************************************************/
+	void backpropagate_batch(const const_matrix_view& reference,
+		const const_matrix_view& output,
+		const matrix_view& error) const
+	{
+		for (std::size_t r = 0; r < output.rows; ++r)
+		{
+			const auto ref = reference.row(r);
+			const auto y = output.row(r);
+			auto e = error.row(r);
+
+			for (std::size_t i = 0; i < this->num_nodes(); ++i)
+			{
+				e[i] = i < reference.cols ? ref[i] - y[i] : T(0);
+			}
+
+			activation::multiply_derivative(this->activation_type, y, e, this->num_nodes());
+		}
+
+		return;
+	}
+
+	/********************************************************************************
+	* backpropagate_batch: Beräknar fel för ett dolt lager över en hel batch via
+	*                      nästa lagers vikter och fel, error = (next_error *
+	*                      next_weights) * f'(output).
+	*
+	*                      - next_layer: Referens till nästa/efterföljande dense-lager.
+	*                      - next_error: Vy över nästa lagers fel för batchen.
+	*                      - output    : Vy över lagrets utsignaler.
+	*                      - error     : Vy som tilldelas lagrets fel.
+	********************************************************************************/
+	void backpropagate_batch(const basic_dense_layer& next_layer,
+		const const_matrix_view& next_error,
+		const const_matrix_view& output,
+		const matrix_view& error) const
+	{
+		simd::gemm_nn(next_error, next_layer.weights.view(), error);
+
+		for (std::size_t r = 0; r < output.rows; ++r)
+		{
+			activation::multiply_derivative(this->activation_type, output.row(r), error.row(r), this->num_nodes());
+		}
+
+		return;
+	}
+
+	/********************************************************************************
+	* accumulate_gradients: Adderar batchens gradienter till angivna buffertar.
+	*                       Viktgradienten beräknas som error^T * input.
+	*
+	*                       - input          : Vy över lagrets indata för batchen.
+	*                       - error          : Vy över lagrets fel för batchen.
+	*                       - weight_gradient: Vy som viktgradienten adderas till.
+	*                       - bias_gradient  : Pekare till buffert för biasgradienten.
+	********************************************************************************/
+	void accumulate_gradients(const const_matrix_view& input,
+		const const_matrix_view& error,
+		const matrix_view& weight_gradient,
+		T* bias_gradient) const
+	{
+		simd::gemm_tn(error, input, weight_gradient);
+
+		for (std::size_t r = 0; r < error.rows; ++r)
+		{
+			const auto e = error.row(r);
+
+			for (std::size_t i = 0; i < this->num_nodes(); ++i)
+			{
+				bias_gradient[i] += e[i];
+			}
+		}
+
+		return;
+	}
+
+	/********************************************************************************
+	* apply_gradients: Uppdaterar vikter och bias med summerade gradienter.
+	*
+	*                  - weight_gradient: Vy över summerad viktgradient.
+	*                  - bias_gradient  : Pekare till summerad biasgradient.
+	*                  - scale          : Faktor som gradienterna multipliceras med,
+	*                                     normalt lärhastigheten delat med batchstorleken.
+	********************************************************************************/
+	void apply_gradients(const const_matrix_view& weight_gradient,
+		const T* bias_gradient,
+		const T scale)
+	{
+		for (std::size_t i = 0; i < this->num_nodes(); ++i)
+		{
+			this->bias[i] += bias_gradient[i] * scale;
+			simd::axpy(scale, weight_gradient.row(i), this->weights.row(i), this->num_weights());
+		}
+
+		if (this->use_transposed) this->weights.transpose_into(this->weights_t);
+		return;
+	}
+
+	/********************************************************************************
+	* apply_gradients: Uppdaterar vikter och bias med summerade gradienter och
+	*                  angiven metod.
+	*
+	*                  - weight_gradient: Vy över summerad viktgradient.
+	*                  - bias_gradient  : Pekare till summerad biasgradient.
+	*                  - scale          : Faktor som gradienterna multipliceras med,
+	*                                     normalt 1 delat med batchstorleken.
+	*                  - step           : Koefficienter för aktuell uppdatering.
+	*                  - slots          : Lagrets tillståndsbuffertar för vald metod.
+	********************************************************************************/
+	void apply_gradients(const const_matrix_view& weight_gradient,
+		const T* bias_gradient,
+		const T scale,
+		const optimizer::basic_step<T>& step,
+		optimizer::basic_state<T>& slots)
+	{
+		optimizer::dispatch(step.method, [&](auto policy)
+		{
+			typedef decltype(policy) policy_type;
+
+			for (std::size_t i = 0; i < this->num_nodes(); ++i)
+			{
+				policy_type::update(step, scale, weight_gradient.row(i), this->weights.row(i),
+					slots.weight_moment.row(i), slots.weight_variance.row(i), this->num_weights());
+			}
+
+			policy_type::update(step, scale, bias_gradient, this->bias.data(),
+				slots.bias_moment.data(), slots.bias_variance.data(), this->num_nodes());
+		});
+
+		if (this->use_transposed) this->weights.transpose_into(this->weights_t);
+		return;
+	}
+
+private:
+	/********************************************************************************
+	* get_rounded: Kontrollerar angivet flyttal och returnerar noll ifall detta
+	*              ligger inom angivet intervall [-threshold, threshold].
+	*              I praktiken gäller därmed att flyttalet jämförs med
+	*              absolutbeloppet av angivet tröskelvärde. Annars om flyttalet
+	*              i fråga inte ligger inom intervallet returneras detta tal.
+	*
+	*              - number   : Flyttalet som ska kontrolleras.
+	*              - threshold: Tröskelvärdet som används för jämförelse.
+	********************************************************************************/
+	static T get_rounded(const T number,
+		const double threshold = 0.001)
+	{
+		if (number > -threshold && number < threshold)
+		{
+			return 0;
+		}
+		else
+		{
+			return number;
+		}
+	}
+};
+
+typedef basic_layer_state<double> layer_state;
+typedef basic_layer_batch<double> layer_batch;
+typedef basic_dense_layer<double> dense_layer;
+
+#endif /* DENSE_LAYER_HPP_ */  #pragma once
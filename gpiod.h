@@ -1,37 +1,195 @@
-#ifndef GPIOD_H_
-#define GPIOD_H_
-
-#ifdef __cplusplus
-extern "C"
-{
-#endif
-
-	/*************************************************************************************
-	* Denna headerfil utgr enbart dummyfiler fr kompilering i Windowsmilj.
-	* Ta inte med dessa filer vid kompilering i Linuxmilj, utan inkludera i stllet
-	* biblioteket gpiod.h genom att lgga till -l gpiod vid kompilering av projektet!
-	*
-	* Som exempel, fr att kompilera samtliga C-filer i en katalog med GCC-kompilatorn
-	* och skapa en krbar fil dpt main kan fljande kommando anvndas:
-	*
-	* gcc *c -o main -Wall -l gpiod
-	**************************************************************************************/
-
-	static struct gpiod_chip* gpiod_chip_open(const char* path) { return 0; }
-	static struct gpiod_chip* gpiod_chip_open_by_name(const char* name) { return 0; }
-	static struct gpiod_chip* gpiod_chip_open_by_number(unsigned int number) { return 0; }
-	static struct gpiod_line* gpiod_chip_get_line(struct gpiod_chip* chip, unsigned int offset) { return 0; }
-	static void gpiod_chip_close(struct gpiod_chip* chip) { }
-	static int gpiod_line_request_input(struct gpiod_line* line, const char* consumer) { return 0; }
-	static int gpiod_line_request_output(struct gpiod_line* line, const char* consumer, int default_val) { return 0; }
-	static int gpiod_line_set_value(struct gpiod_line* line, int value) { return 0; }
-	static int gpiod_line_get_value(struct gpiod_line* line) { return 0; }
-	static void gpiod_line_release(struct gpiod_line* line) { }
-	static const char* gpiod_line_consumer(struct gpiod_line* line) { return 0; }
-	static unsigned int gpiod_line_offset(struct gpiod_line* line) { return 0; }
-
-#ifdef __cplusplus
-}
-#endif
-
-#endif /* GPIOD_H_ */
\ No newline at end of file
+#ifndef GPIOD_H_
+#define GPIOD_H_
+
+/* Inkluderingsdirektiv: */
+#include <time.h>
+
+#if !defined(_WIN32)
+#include <poll.h>
+#include <sys/eventfd.h>
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+	/*************************************************************************************
+	* Denna headerfil utgör enbart dummyfiler för kompilering i Windowsmiljö.
+	* Ta inte med dessa filer vid kompilering i Linuxmiljö, utan inkludera i stället
+	* biblioteket gpiod.h genom att lägga till -l gpiod vid kompilering av projektet!
+	*
+	* Som exempel, för att kompilera samtliga C-filer i en katalog med GCC-kompilatorn
+	* och skapa en körbar fil döpt main kan följande kommando användas:
+	*
+	* gcc *c -o main -Wall -l gpiod
+	*
+	* Dummyfilerna simulerar 64 GPIO-linjer på ett enda chip. Insignaler kan sättas
+	* via gpiod_sim_line_set_value, vilket på Linux även genererar en flankhändelse
+	* för linjer som begärts med gpiod_line_request_both_edges_events. Varje händelse
+	* signaleras via en eventfd, så att programmet kan vänta på händelser med poll
+	* precis som med det riktiga biblioteket. På så vis kan det händelsestyrda
+	* programmet testas utan hårdvara. Varje översättningsenhet har ett eget chip.
+	**************************************************************************************/
+
+#define GPIOD_LINE_EVENT_RISING_EDGE 1
+#define GPIOD_LINE_EVENT_FALLING_EDGE 2
+#define GPIOD_SIM_NUM_LINES 64
+
+#if defined(_MSC_VER)
+#define GPIOD_SIM_LOAD(address) (*(volatile int*)(address))
+#define GPIOD_SIM_STORE(address, value) (*(volatile int*)(address) = (value))
+#else
+#define GPIOD_SIM_LOAD(address) __atomic_load_n(address, __ATOMIC_ACQUIRE)
+#define GPIOD_SIM_STORE(address, value) __atomic_store_n(address, value, __ATOMIC_RELEASE)
+#endif
+
+	struct gpiod_line_event
+	{
+		struct timespec ts;
+		int event_type;
+	};
+
+	struct gpiod_line
+	{
+		unsigned int offset;
+		int value;
+		int event_fd;
+		long long last_edge_ns;
+	};
+
+	struct gpiod_chip
+	{
+		struct gpiod_line lines[GPIOD_SIM_NUM_LINES];
+		int initialized;
+	};
+
+	static struct gpiod_chip gpiod_sim_chip;
+
+	static inline struct gpiod_chip* gpiod_chip_open(const char* path)
+	{
+		unsigned int i;
+		(void)path;
+
+		if (!gpiod_sim_chip.initialized)
+		{
+			for (i = 0; i < GPIOD_SIM_NUM_LINES; ++i)
+			{
+				gpiod_sim_chip.lines[i].offset = i;
+				gpiod_sim_chip.lines[i].event_fd = -1;
+			}
+
+			gpiod_sim_chip.initialized = 1;
+		}
+
+		return &gpiod_sim_chip;
+	}
+
+	static inline struct gpiod_chip* gpiod_chip_open_by_name(const char* name) { return gpiod_chip_open(name); }
+	static inline struct gpiod_chip* gpiod_chip_open_by_number(unsigned int number) { (void)number; return gpiod_chip_open(0); }
+
+	static inline struct gpiod_line* gpiod_chip_get_line(struct gpiod_chip* chip, unsigned int offset)
+	{
+		return chip && offset < GPIOD_SIM_NUM_LINES ? &chip->lines[offset] : 0;
+	}
+
+	static inline void gpiod_chip_close(struct gpiod_chip* chip) { (void)chip; }
+	static inline int gpiod_line_request_input(struct gpiod_line* line, const char* consumer) { (void)line; (void)consumer; return 0; }
+
+	static inline int gpiod_line_request_output(struct gpiod_line* line, const char* consumer, int default_val)
+	{
+		(void)consumer;
+		if (line) line->value = default_val;
+		return 0;
+	}
+
+	static inline int gpiod_line_set_value(struct gpiod_line* line, int value)
+	{
+		if (!line) return -1;
+		GPIOD_SIM_STORE(&line->value, value);
+		return 0;
+	}
+
+	static inline int gpiod_line_get_value(struct gpiod_line* line)
+	{
+		return line ? GPIOD_SIM_LOAD(&line->value) : 0;
+	}
+
+	static inline void gpiod_line_release(struct gpiod_line* line) { (void)line; }
+	static inline const char* gpiod_line_consumer(struct gpiod_line* line) { (void)line; return 0; }
+	static inline unsigned int gpiod_line_offset(struct gpiod_line* line) { return line ? line->offset : 0; }
+
+#if !defined(_WIN32)
+	static inline int gpiod_line_request_both_edges_events(struct gpiod_line* line, const char* consumer)
+	{
+		(void)consumer;
+		if (!line) return -1;
+		if (line->event_fd < 0) line->event_fd = eventfd(0, EFD_NONBLOCK);
+		return line->event_fd < 0 ? -1 : 0;
+	}
+
+	static inline int gpiod_line_event_get_fd(struct gpiod_line* line)
+	{
+		return line ? line->event_fd : -1;
+	}
+
+	/* Returnerar 1 om en händelse finns att läsa, 0 vid timeout och -1 vid fel. */
+	static inline int gpiod_line_event_wait(struct gpiod_line* line, const struct timespec* timeout)
+	{
+		struct pollfd fd;
+		int timeout_ms = -1;
+
+		if (!line || line->event_fd < 0) return -1;
+		if (timeout) timeout_ms = (int)(timeout->tv_sec * 1000 + timeout->tv_nsec / 1000000);
+
+		fd.fd = line->event_fd;
+		fd.events = POLLIN;
+		fd.revents = 0;
+
+		const int result = poll(&fd, 1, timeout_ms);
+		return result < 0 ? -1 : (result > 0 ? 1 : 0);
+	}
+
+	/* Flera studsar som inträffat sedan föregående läsning slås samman till en
+	   händelse, vars typ bestäms av linjens nuvarande värde. */
+	static inline int gpiod_line_event_read(struct gpiod_line* line, struct gpiod_line_event* event)
+	{
+		eventfd_t count = 0;
+		long long last_edge_ns;
+
+		if (!line || line->event_fd < 0 || eventfd_read(line->event_fd, &count) != 0) return -1;
+
+		last_edge_ns = __atomic_load_n(&line->last_edge_ns, __ATOMIC_ACQUIRE);
+		event->ts.tv_sec = (time_t)(last_edge_ns / 1000000000LL);
+		event->ts.tv_nsec = (long)(last_edge_ns % 1000000000LL);
+		event->event_type = gpiod_line_get_value(line) ? GPIOD_LINE_EVENT_RISING_EDGE : GPIOD_LINE_EVENT_FALLING_EDGE;
+		return 0;
+	}
+
+	/* Simulerar en ny nivå på en insignal. Om nivån ändras genereras en flankhändelse.
+	   Tidsstämpeln lagras atomärt som nanosekunder och publiceras innan händelsen
+	   signaleras, så att en annan tråd som läser händelsen ser en hel tidsstämpel. */
+	static inline int gpiod_sim_line_set_value(struct gpiod_line* line, int value)
+	{
+		struct timespec now;
+
+		if (!line) return -1;
+		if (__atomic_exchange_n(&line->value, value, __ATOMIC_ACQ_REL) == value) return 0;
+
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		__atomic_store_n(&line->last_edge_ns, (long long)now.tv_sec * 1000000000LL + now.tv_nsec, __ATOMIC_RELEASE);
+		return line->event_fd >= 0 ? eventfd_write(line->event_fd, 1) : 0;
+	}
+#else
+	static inline int gpiod_line_request_both_edges_events(struct gpiod_line* line, const char* consumer) { (void)line; (void)consumer; return -1; }
+	static inline int gpiod_line_event_get_fd(struct gpiod_line* line) { (void)line; return -1; }
+	static inline int gpiod_line_event_wait(struct gpiod_line* line, const struct timespec* timeout) { (void)line; (void)timeout; return -1; }
+	static inline int gpiod_line_event_read(struct gpiod_line* line, struct gpiod_line_event* event) { (void)line; (void)event; return -1; }
+	static inline int gpiod_sim_line_set_value(struct gpiod_line* line, int value) { return gpiod_line_set_value(line, value); }
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GPIOD_H_ */
@@ -1,59 +1,176 @@
-#pragma once
-
-#include "dense_layer.hpp"
-#include "ann.hpp"
-#include "unistd.h"
-#include "gpiod.h"
-
-
-
-
-
-enum gpiod_direction { GPIO_DIRECTION_IN, GPIO_DIRECTION_OUT };
-
-
-
-/*
-* gpiod_line_new: Initierar GPIO-linje till in- eller utport och returnerar en
-* GPIO-linjepekare. Passerat namn sparas som GPIO-linjens alias.
-* gpiochip0 implementeras via en statisk lokal struktpekare dpt
-* chip0, som enbart anvnds fr att aktivera GPIO-linjer och hlls
-* icke tkomlig fr anvndare.
-**/
-struct gpiod_line* gpiod_line_new(const uint8_t pin, const enum gpiod_direction direction, const char* alias) {
-    static struct gpiod_chip* chip0 = 0;
-    if (!chip0) chip0 = gpiod_chip_open("/dev/gpiochip0");
-
-    struct gpiod_line* self = gpiod_chip_get_line(chip0, pin);
-
-    if (direction == GPIO_DIRECTION_OUT) {
-        gpiod_line_request_output(self, alias, 0);
-    }
-    else {
-        gpiod_line_request_input(self, alias);
-    }
-
-    return self;
-}
-
-/*
-* gpiod_line_delay: Genererar frdrjning mtt i millisekunder
-**/
-void gpiod_line_delay(const size_t delay_time) {
-    usleep(delay_time * 1000);
-    return;
-}
-
-
-
-/*
-* gpiod_line_toggle: togglar lysdioden
-**/
-void gpiod_line_toggle(struct gpiod_line* self) {
-    if (gpiod_line_get_value(self) == 1) {
-        gpiod_line_set_value(self, 0);
-    }
-    else {
-        gpiod_line_set_value(self, 1);
-    }
-}
+#pragma once
+
+#include "dense_layer.hpp"
+#include "ann.hpp"
+#include "unistd.h"
+#include "gpiod.h"
+
+#include <chrono>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <poll.h>
+#endif
+
+
+
+
+
+enum gpiod_direction { GPIO_DIRECTION_IN, GPIO_DIRECTION_OUT, GPIO_DIRECTION_IN_EDGES };
+
+/* Högsta antalet linjer som kan bevakas samtidigt via gpiod_line_wait_edges. */
+#define GPIOD_LINE_MAX_WAIT 16
+
+
+
+/*
+* gpiod_line_new: Initierar GPIO-linje till in- eller utport och returnerar en
+* GPIO-linjepekare. Passerat namn sparas som GPIO-linjens alias.
+* gpiochip0 implementeras via en statisk lokal struktpekare döpt
+* chip0, som enbart används för att aktivera GPIO-linjer och hålls
+* icke åtkomlig för användare. Vid GPIO_DIRECTION_IN_EDGES begärs
+* händelser för både stigande och fallande flank, så att linjen kan
+* bevakas via gpiod_line_wait_edges i stället för att läsas av i en loop.
+**/
+struct gpiod_line* gpiod_line_new(const uint8_t pin, const enum gpiod_direction direction, const char* alias) {
+    static struct gpiod_chip* chip0 = 0;
+    if (!chip0) chip0 = gpiod_chip_open("/dev/gpiochip0");
+
+    struct gpiod_line* self = gpiod_chip_get_line(chip0, pin);
+
+    if (direction == GPIO_DIRECTION_OUT) {
+        gpiod_line_request_output(self, alias, 0);
+    }
+    else if (direction == GPIO_DIRECTION_IN_EDGES) {
+        if (gpiod_line_request_both_edges_events(self, alias) != 0) {
+            gpiod_line_request_input(self, alias);
+        }
+    }
+    else {
+        gpiod_line_request_input(self, alias);
+    }
+
+    return self;
+}
+
+/*
+* gpiod_line_delay: Genererar fördröjning mätt i millisekunder
+**/
+void gpiod_line_delay(const size_t delay_time) {
+    usleep(delay_time * 1000);
+    return;
+}
+
+
+
+/*
+* gpiod_line_toggle: togglar lysdioden
+**/
+void gpiod_line_toggle(struct gpiod_line* self) {
+    if (gpiod_line_get_value(self) == 1) {
+        gpiod_line_set_value(self, 0);
+    }
+    else {
+        gpiod_line_set_value(self, 1);
+    }
+}
+
+/*
+* gpiod_line_wait_edges: Väntar tills en flank inträffar på någon av angivna
+* linjer eller tills timeout löper ut. Samtliga väntande händelser
+* läses ut, så att flera studsar på samma linje räknas som en. Tiden
+* för den tidigaste flanken skrivs till first_edge (om angiven), vilket
+* möjliggör mätning av fördröjningen från knapptryck till utsignal.
+* Returnerar antalet linjer med händelser, 0 vid timeout och -1 vid fel.
+* Om linjerna saknar händelsestöd (exempelvis i Windowsmiljö) läses
+* linjernas nivåer i stället av varje millisekund, tills någon nivå har
+* ändrats eller timeout löper ut. Negativ timeout innebär obegränsad väntan.
+**/
+int gpiod_line_wait_edges(struct gpiod_line** lines, const size_t num_lines, const int timeout_ms,
+                          std::chrono::steady_clock::time_point* first_edge = nullptr) {
+#if !defined(_WIN32)
+    struct pollfd fds[GPIOD_LINE_MAX_WAIT];
+    const size_t n = num_lines < GPIOD_LINE_MAX_WAIT ? num_lines : GPIOD_LINE_MAX_WAIT;
+
+    for (size_t i = 0; i < n; ++i) {
+        fds[i].fd = gpiod_line_event_get_fd(lines[i]);
+        fds[i].events = POLLIN;
+        fds[i].revents = 0;
+        if (fds[i].fd < 0) goto fallback;
+    }
+
+    {
+        const int result = poll(fds, static_cast<nfds_t>(n), timeout_ms);
+        if (result <= 0) return result;
+
+        int num_changed = 0;
+        bool has_edge = false;
+        struct timespec earliest = { 0, 0 };
+
+        for (size_t i = 0; i < n; ++i) {
+            if (!(fds[i].revents & POLLIN)) continue;
+            struct gpiod_line_event event;
+
+            while (poll(&fds[i], 1, 0) > 0 && gpiod_line_event_read(lines[i], &event) == 0) {
+                if (!has_edge || event.ts.tv_sec < earliest.tv_sec ||
+                    (event.ts.tv_sec == earliest.tv_sec && event.ts.tv_nsec < earliest.tv_nsec)) {
+                    earliest = event.ts;
+                    has_edge = true;
+                }
+            }
+
+            num_changed++;
+        }
+
+        /* Händelsernas tidsstämplar anges i CLOCK_MONOTONIC, vilket är samma
+           klocka som steady_clock använder i Linuxmiljö: */
+        if (first_edge && has_edge) {
+            *first_edge = std::chrono::steady_clock::time_point(
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::seconds(earliest.tv_sec) + std::chrono::nanoseconds(earliest.tv_nsec)));
+        }
+
+        return num_changed;
+    }
+
+fallback:
+#endif
+    /* Väntan sker med sleep_for, eftersom usleep i dummyfilen unistd.h
+       returnerar direkt och loopen då skulle belasta processorn fullt: */
+    const size_t count = num_lines < GPIOD_LINE_MAX_WAIT ? num_lines : GPIOD_LINE_MAX_WAIT;
+    const auto start = std::chrono::steady_clock::now();
+    int initial[GPIOD_LINE_MAX_WAIT];
+
+    for (size_t i = 0; i < count; ++i) {
+        initial[i] = gpiod_line_get_value(lines[i]);
+    }
+
+    for (;;) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        int num_changed = 0;
+
+        for (size_t i = 0; i < count; ++i) {
+            if (gpiod_line_get_value(lines[i]) != initial[i]) num_changed++;
+        }
+
+        if (num_changed > 0) {
+            if (first_edge) *first_edge = std::chrono::steady_clock::now();
+            return num_changed;
+        }
+
+        if (timeout_ms >= 0 && std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(timeout_ms)) {
+            return 0;
+        }
+    }
+}
+
+/*
+* gpiod_line_debounce: Väntar tills angivna linjer har varit stilla, dvs. utan
+* flanker, under quiet_ms millisekunder. Händelser som inträffar under
+* tiden (exempelvis kontaktstudsar) läses ut och kastas. Efter anropet
+* kan linjernas stabila nivåer läsas av.
+**/
+void gpiod_line_debounce(struct gpiod_line** lines, const size_t num_lines, const int quiet_ms) {
+    while (gpiod_line_wait_edges(lines, num_lines, quiet_ms) > 0);
+    return;
+}
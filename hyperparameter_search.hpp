@@ -0,0 +1,489 @@
+#ifndef HYPERPARAMETER_SEARCH_HPP_
+#define HYPERPARAMETER_SEARCH_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <iostream>
+
+#include "ann.hpp"
+
+/********************************************************************************
+* search: Sökning efter hyperparametrar (antal dolda noder och lager,
+*         lärhastighet och antal epoker), där många oberoende nätverk tränas
+*         samtidigt på en trådpool. Varje konfiguration utvärderas med k-faldig
+*         korsvalidering och konfigurationer vars träningsfel släpar efter
+*         övrigas avbryts i förtid (pruning).
+********************************************************************************/
+namespace search
+{
+	/********************************************************************************
+	* config: En konfiguration av hyperparametrar.
+	********************************************************************************/
+	struct config
+	{
+		std::size_t num_hidden_nodes = 4;
+		std::size_t num_hidden_layers = 1;
+		double learning_rate = 0.03;
+		std::size_t num_epochs = 1000;
+	};
+
+	/********************************************************************************
+	* grid_space: Värden för rutnätssökning, där samtliga kombinationer prövas.
+	********************************************************************************/
+	struct grid_space
+	{
+		std::vector<std::size_t> hidden_nodes = { 4 };
+		std::vector<std::size_t> hidden_layers = { 1 };
+		std::vector<double> learning_rates = { 0.03 };
+		std::vector<std::size_t> epochs = { 1000 };
+	};
+
+	/********************************************************************************
+	* random_space: Intervall för slumpmässig sökning. Lärhastigheten dras
+	*               log-likformigt, dvs. lika sannolikt i varje tiopotens,
+	*               medan övriga parametrar dras likformigt (inklusive gränser).
+	********************************************************************************/
+	struct random_space
+	{
+		std::size_t min_hidden_nodes = 2;
+		std::size_t max_hidden_nodes = 32;
+		std::size_t min_hidden_layers = 1;
+		std::size_t max_hidden_layers = 1;
+		double min_learning_rate = 0.001;
+		double max_learning_rate = 0.3;
+		std::size_t min_epochs = 500;
+		std::size_t max_epochs = 5000;
+	};
+
+	/********************************************************************************
+	* settings: Inställningar som är gemensamma för samtliga konfigurationer.
+	*
+	*           - num_folds       : Antalet delar vid korsvalidering. Vid 1 eller
+	*                               mindre tränas och utvärderas varje
+	*                               konfiguration på samtliga uppsättningar.
+	*           - batch_size      : Antalet uppsättningar per viktuppdatering.
+	*           - optimizer       : Optimeringsmetod för samtliga nätverk.
+	*           - prune_interval  : Antalet epoker mellan varje jämförelse av
+	*                               träningsfelet, 0 = ingen pruning.
+	*           - prune_warmup    : Antalet epoker innan något avbryts, eftersom
+	*                               felkurvorna ofta är lika i början.
+	*           - prune_min_trials: Minsta antalet rapporterade fel vid en
+	*                               jämförelsepunkt innan något avbryts.
+	*           - prune_quantile  : Körningar med större fel än denna kvantil av
+	*                               övrigas fel vid samma del och epok avbryts
+	*                               (0.5 = medianen).
+	*           - seed            : Frö för uppdelningen i delar och startvärdena,
+	*                               där konfiguration i använder seed + i.
+	********************************************************************************/
+	struct settings
+	{
+		std::size_t num_folds = 4;
+		std::size_t batch_size = 1;
+		optimizer::settings optimizer;
+		std::size_t prune_interval = 100;
+		std::size_t prune_warmup = 500;
+		std::size_t prune_min_trials = 4;
+		double prune_quantile = 0.5;
+		std::uint64_t seed = prng::generator::default_seed;
+	};
+
+	/********************************************************************************
+	* trial: Resultatet för en konfiguration.
+	*
+	*        - parameters     : Konfigurationen.
+	*        - validation_loss: Medelkvadratfelet på valideringsdelarna, i
+	*                           medeltal över delarna (NaN om avbruten).
+	*        - training_loss  : Senaste träningsfelet, i medeltal över delarna.
+	*        - epochs         : Antalet genomförda epoker, summerat över delarna.
+	*        - seconds        : Träningstiden, summerad över delarna.
+	*        - pruned         : Indikerar ifall konfigurationen avbröts i förtid.
+	********************************************************************************/
+	struct trial
+	{
+		config parameters;
+		double validation_loss = std::numeric_limits<double>::quiet_NaN();
+		double training_loss = std::numeric_limits<double>::quiet_NaN();
+		std::size_t epochs = 0;
+		double seconds = 0.0;
+		bool pruned = false;
+	};
+
+	/********************************************************************************
+	* report: Resultatet av en sökning. Den sekventiella tiden är summan av
+	*         samtliga körningars tid, dvs. en uppskattning av tiden om
+	*         konfigurationerna i stället hade tränats efter varandra. Med fler
+	*         trådar än kärnor delar körningarna på kärnorna och tar längre tid
+	*         var, varvid uppskattningen blir för hög; jämför då i stället med
+	*         en körning på en trådpool med en tråd.
+	********************************************************************************/
+	struct report
+	{
+		std::vector<trial> trials;
+		std::size_t best = 0;
+		std::size_t num_pruned = 0;
+		double wall_seconds = 0.0;
+		double sequential_seconds = 0.0;
+
+		inline bool empty(void) const { return this->best >= this->trials.size(); }
+		inline const trial& best_trial(void) const { return this->trials[this->best]; }
+
+		/********************************************************************************
+		* estimated_speedup: Kvoten mellan den uppskattade sekventiella tiden och
+		*                    sökningens verkliga tid. Eftersom körningarnas tid
+		*                    mäts medan de delar på kärnorna blir kvoten för hög;
+		*                    verklig speedup fås genom att mäta samma sökning på
+		*                    en trådpool med en tråd.
+		********************************************************************************/
+		inline double estimated_speedup(void) const
+		{
+			return this->wall_seconds > 0.0 ? this->sequential_seconds / this->wall_seconds : 0.0;
+		}
+
+		/********************************************************************************
+		* print: Skriver ut antalet körningar och avbrutna körningar, sökningens
+		*        tid och summan av körningarnas tid samt bästa konfigurationen
+		*        via angiven utström. Någon speedup skrivs inte ut, se
+		*        estimated_speedup.
+		********************************************************************************/
+		void print(std::ostream& ostream = std::cout) const
+		{
+			ostream << " Trials: " << this->trials.size() << ", pruned: " << this->num_pruned
+				<< ", wall: " << this->wall_seconds << " s, sum of trial times: " << this->sequential_seconds
+				<< " s\n";
+			if (this->empty()) return;
+
+			const auto& trial = this->best_trial();
+			ostream << " Best: hidden nodes " << trial.parameters.num_hidden_nodes
+				<< " x " << trial.parameters.num_hidden_layers
+				<< ", learning rate " << trial.parameters.learning_rate
+				<< ", epochs " << trial.parameters.num_epochs
+				<< ", validation MSE " << trial.validation_loss << "\n";
+			return;
+		}
+	};
+
+	/********************************************************************************
+	* grid: Returnerar samtliga kombinationer av värdena i angivet rutnät.
+	********************************************************************************/
+	static inline std::vector<config> grid(const grid_space& space)
+	{
+		std::vector<config> configs;
+
+		for (const auto nodes : space.hidden_nodes)
+		{
+			for (const auto layers : space.hidden_layers)
+			{
+				for (const auto rate : space.learning_rates)
+				{
+					for (const auto epochs : space.epochs)
+					{
+						configs.push_back(config{ nodes, layers, rate, epochs });
+					}
+				}
+			}
+		}
+
+		return configs;
+	}
+
+	/********************************************************************************
+	* random: Returnerar count konfigurationer dragna ur angivna intervall.
+	*
+	*         - space: Intervallen för respektive parameter.
+	*         - count: Antalet konfigurationer.
+	*         - rng  : Generatorn som används.
+	********************************************************************************/
+	static inline std::vector<config> random(const random_space& space,
+		const std::size_t count,
+		prng::generator& rng)
+	{
+		const auto draw = [&rng](const std::size_t low, const std::size_t high)
+		{
+			return high > low ? low + rng.below(static_cast<std::uint32_t>(high - low + 1)) : low;
+		};
+
+		std::vector<config> configs(count);
+
+		for (auto& parameters : configs)
+		{
+			parameters.num_hidden_nodes = draw(space.min_hidden_nodes, space.max_hidden_nodes);
+			parameters.num_hidden_layers = draw(space.min_hidden_layers, space.max_hidden_layers);
+			parameters.learning_rate = std::exp(rng.uniform(std::log(space.min_learning_rate), std::log(space.max_learning_rate)));
+			parameters.num_epochs = draw(space.min_epochs, space.max_epochs);
+		}
+
+		return configs;
+	}
+
+	/********************************************************************************
+	* pruner: Medianregeln för att avbryta körningar i förtid. Varje körning
+	*         följer sitt lägsta träningsfel hittills vid fasta epoker, vilket
+	*         bortser från tillfälliga toppar i felkurvan. Körningar som
+	*         genomförts utan att avbrytas lämnar in sina värden via commit.
+	*         En pågående körning avbryts om dess värde är större än angiven
+	*         kvantil av de inlämnade värdena för samma del och epok, förutsatt
+	*         att minst min_trials körningar har lämnat in ett värde där. De
+	*         första körningarna avbryts därmed aldrig. Vilka körningar som
+	*         avbryts beror på i vilken ordning trådarna blir klara. Trådsäker.
+	********************************************************************************/
+	class pruner
+	{
+	public:
+		typedef std::pair<std::size_t, std::size_t> checkpoint;
+		typedef std::vector<std::pair<checkpoint, double>> curve;
+
+		pruner(const std::size_t min_trials, const double quantile)
+			: min_trials(min_trials > 0 ? min_trials : 1), quantile(quantile) { }
+
+		void commit(const curve& losses)
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+
+			for (const auto& point : losses)
+			{
+				this->checkpoints[point.first].push_back(point.second);
+			}
+
+			return;
+		}
+
+		bool should_prune(const checkpoint& point, const double loss)
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			const auto position = this->checkpoints.find(point);
+			if (position == this->checkpoints.end() || position->second.size() < this->min_trials) return false;
+
+			const auto& losses = position->second;
+
+			this->sorted.assign(losses.begin(), losses.end());
+			const auto rank = static_cast<std::size_t>(this->quantile * static_cast<double>(this->sorted.size() - 1));
+			std::nth_element(this->sorted.begin(), this->sorted.begin() + static_cast<std::ptrdiff_t>(rank), this->sorted.end());
+			return loss > this->sorted[rank];
+		}
+
+	private:
+		std::mutex mutex;
+		std::map<checkpoint, std::vector<double>> checkpoints;
+		std::vector<double> sorted;
+		std::size_t min_trials;
+		double quantile;
+	};
+
+	/********************************************************************************
+	* run: Tränar ett nätverk per konfiguration och del samtidigt på angiven
+	*      trådpool och utvärderar felet på respektive valideringsdel. Data
+	*      packas en gång till en matris, varefter samtliga nätverk tränar på
+	*      vyer över den utan egna kopior. Samtliga nätverk har tanh i alla
+	*      lager. Returnerar samtliga resultat och bästa konfigurationen, dvs.
+	*      den med lägst valideringsfel bland dem som inte avbrutits.
+	*
+	*      - pool      : Trådpoolen som ska användas.
+	*      - inputs    : Indata, en vektor per uppsättning.
+	*      - references: Referensdata, en vektor per uppsättning.
+	*      - configs   : Konfigurationerna som ska prövas.
+	*      - options   : Gemensamma inställningar.
+	********************************************************************************/
+	template <typename T>
+	report run(thread_pool& pool,
+		const std::vector<std::vector<T>>& inputs,
+		const std::vector<std::vector<T>>& references,
+		const std::vector<config>& configs,
+		const settings& options = settings())
+	{
+		typedef basic_matrix<T> matrix;
+		typedef basic_sample_view<T> sample_view;
+		typedef std::chrono::steady_clock clock;
+
+		const auto start = clock::now();
+		const auto num_sets = inputs.size() < references.size() ? inputs.size() : references.size();
+		const auto num_folds = options.num_folds > 1 && options.num_folds <= num_sets ? options.num_folds : 1;
+		const auto num_inputs = num_sets ? inputs[0].size() : 0;
+		const auto num_outputs = num_sets ? references[0].size() : 0;
+
+		report outcome;
+		outcome.trials.resize(configs.size());
+		outcome.best = configs.size();
+		if (num_sets == 0 || num_inputs == 0 || num_outputs == 0) return outcome;
+
+		matrix samples(num_sets, num_inputs);
+		matrix targets(num_sets, num_outputs);
+
+		for (std::size_t i = 0; i < num_sets; ++i)
+		{
+			std::copy(inputs[i].begin(), inputs[i].begin() + static_cast<std::ptrdiff_t>(std::min(num_inputs, inputs[i].size())), samples.row(i));
+			std::copy(references[i].begin(), references[i].begin() + static_cast<std::ptrdiff_t>(std::min(num_outputs, references[i].size())), targets.row(i));
+		}
+
+		/* Uppsättningarna blandas en gång och delas i num_folds lika stora
+		   delar, där del f valideras mot ett nätverk tränat på övriga delar: */
+		std::vector<std::size_t> order(num_sets);
+		for (std::size_t i = 0; i < num_sets; ++i) order[i] = i;
+		prng::generator rng(options.seed);
+		prng::shuffle(order.data(), num_sets, rng);
+
+		std::vector<std::vector<const T*>> train_inputs(num_folds);
+		std::vector<std::vector<const T*>> train_references(num_folds);
+		std::vector<matrix> validation_inputs(num_folds);
+		std::vector<matrix> validation_references(num_folds);
+
+		for (std::size_t f = 0; f < num_folds; ++f)
+		{
+			const auto first = num_sets * f / num_folds;
+			const auto last = num_sets * (f + 1) / num_folds;
+			const auto num_validation = num_folds > 1 ? last - first : num_sets;
+			validation_inputs[f].resize(num_validation, num_inputs);
+			validation_references[f].resize(num_validation, num_outputs);
+
+			for (std::size_t i = 0, v = 0; i < num_sets; ++i)
+			{
+				const auto index = order[i];
+				const auto validate = num_folds == 1 || (i >= first && i < last);
+
+				if (num_folds == 1 || !validate)
+				{
+					train_inputs[f].push_back(samples.row(index));
+					train_references[f].push_back(targets.row(index));
+				}
+
+				if (validate)
+				{
+					std::copy(samples.row(index), samples.row(index) + num_inputs, validation_inputs[f].row(v));
+					std::copy(targets.row(index), targets.row(index) + num_outputs, validation_references[f].row(v));
+					v++;
+				}
+			}
+		}
+
+		const auto num_jobs = configs.size() * num_folds;
+		std::vector<double> validation_losses(num_jobs, 0.0);
+		std::vector<double> training_losses(num_jobs, 0.0);
+		std::vector<std::size_t> epochs(num_jobs, 0);
+		std::vector<double> seconds(num_jobs, 0.0);
+		std::unique_ptr<std::atomic<bool>[]> pruned(new std::atomic<bool>[configs.size()]);
+		std::atomic<std::size_t> next_job(0);
+		pruner rule(options.prune_min_trials, options.prune_quantile);
+
+		for (std::size_t t = 0; t < configs.size(); ++t) pruned[t] = false;
+
+		/* Varje tråd hämtar nästa körning (konfiguration, del) tills samtliga
+		   är klara, så att långa och korta körningar fördelas dynamiskt: */
+		pool.run([&](const std::size_t)
+		{
+			for (auto job = next_job++; job < num_jobs; job = next_job++)
+			{
+				const auto t = job / num_folds;
+				const auto f = job % num_folds;
+				const auto& parameters = configs[t];
+				if (pruned[t]) continue;
+
+				const auto job_start = clock::now();
+				network_builder topology(num_inputs);
+				for (std::size_t l = 0; l < std::max<std::size_t>(parameters.num_hidden_layers, 1); ++l) topology.hidden(parameters.num_hidden_nodes);
+
+				basic_ann<T> network(topology.output(num_outputs));
+				network.seed(options.seed + t);
+				network.set_optimizer(options.optimizer);
+				network.set_training_data(sample_view(train_inputs[f].data(), train_inputs[f].size(), num_inputs),
+					sample_view(train_references[f].data(), train_references[f].size(), num_outputs));
+
+				training::stopping stopping;
+				stopping.interval = options.prune_interval ? options.prune_interval : parameters.num_epochs;
+				network.set_stopping(stopping);
+
+				pruner::curve losses;
+
+				if (options.prune_interval)
+				{
+					network.set_progress_callback([&](const training::progress& state)
+					{
+						if (pruned[t]) return false;
+						const auto point = pruner::checkpoint(f, state.epoch);
+
+						if (state.epoch >= options.prune_warmup && state.epoch < state.num_epochs &&
+							rule.should_prune(point, state.best_loss))
+						{
+							pruned[t] = true;
+							return false;
+						}
+
+						losses.emplace_back(point, state.best_loss);
+						return true;
+					});
+				}
+
+				const auto result = network.train(parameters.num_epochs, static_cast<T>(parameters.learning_rate), options.batch_size);
+				epochs[job] = result.epochs;
+				training_losses[job] = result.loss;
+
+				if (!pruned[t])
+				{
+					rule.commit(losses);
+
+					const auto& x = validation_inputs[f];
+					const auto& y = validation_references[f];
+					matrix outputs(x.rows(), num_outputs);
+					double squared_error = 0.0;
+					network.predict_batch(x.view(), outputs.view());
+
+					for (std::size_t i = 0; i < x.rows(); ++i)
+					{
+						for (std::size_t j = 0; j < num_outputs; ++j)
+						{
+							const auto error = static_cast<double>(y(i, j)) - static_cast<double>(outputs(i, j));
+							squared_error += error * error;
+						}
+					}
+
+					validation_losses[job] = squared_error / static_cast<double>(x.rows() * num_outputs);
+				}
+
+				seconds[job] = std::chrono::duration<double>(clock::now() - job_start).count();
+			}
+		});
+
+		for (std::size_t t = 0; t < configs.size(); ++t)
+		{
+			auto& trial = outcome.trials[t];
+			trial.parameters = configs[t];
+			trial.pruned = pruned[t];
+			trial.training_loss = 0.0;
+			trial.validation_loss = 0.0;
+
+			for (std::size_t f = 0; f < num_folds; ++f)
+			{
+				const auto job = t * num_folds + f;
+				trial.epochs += epochs[job];
+				trial.seconds += seconds[job];
+				trial.training_loss += training_losses[job] / num_folds;
+				trial.validation_loss += validation_losses[job] / num_folds;
+			}
+
+			outcome.sequential_seconds += trial.seconds;
+
+			if (trial.pruned)
+			{
+				trial.validation_loss = std::numeric_limits<double>::quiet_NaN();
+				outcome.num_pruned++;
+			}
+			else if (outcome.empty() || trial.validation_loss < outcome.trials[outcome.best].validation_loss)
+			{
+				outcome.best = t;
+			}
+		}
+
+		outcome.wall_seconds = std::chrono::duration<double>(clock::now() - start).count();
+		return outcome;
+	}
+}
+
+#endif /* HYPERPARAMETER_SEARCH_HPP_ */
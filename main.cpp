@@ -1,88 +1,234 @@
-#include "gpiod_line.hpp"
-
-/* Todo: Slutfr optimeringsfunktionen i klassen ann s att parametrarna korrigeras vid fel.
- */
-
-static void read_button(gpiod_line* button, vector<double>& data, const size_t index);
-static int get_multi_output(ann& multi1, const vector<double>& input);
-
-int main(void)
-{
-	/* Fel i trningsuppsttningarna, korrigerade dem: */
-	const vector<vector<double>> button_in = {
-		{0,0,0,0}, {0,0,0,1}, {0,0,1,0}, {0,0,1,1}, 
-        {0,1,0,0}, {0,1,0,1}, {0,1,1,1}, {1,0,0,0},
-		{1,0,0,0}, {1,0,0,1}, {1,0,1,0}, {1,0,1,1}, 
-        {1,1,0,0}, {1,1,0,1}, {1,1,1,0}, {1,1,1,1} 
-    };
-
-	const vector<vector<double>> diod_out = {
-		{0}, {1}, {1}, {0}, 
-        {1}, {0}, {1}, {1},
-        {1}, {0}, {0}, {1}, 
-        {0}, {1}, {1}, {0} };
-	
-	ann multi1 (4, 1, 4, 1);
-	multi1.set_training_data(button_in, diod_out);
-	multi1.train(80000, 0.03);
-	multi1.print();
-
-
-    /* Array fr lagring av tryckknapparnas tillstnd */
-	vector<double>input(4, 0);
-
-    struct gpiod_line* led = gpiod_line_new(17, GPIO_DIRECTION_OUT, "led");
-    struct gpiod_line* button1 = gpiod_line_new(27, GPIO_DIRECTION_IN, " BUtton1");
-    struct gpiod_line* button2 = gpiod_line_new(22, GPIO_DIRECTION_IN, " BUtton2");
-    struct gpiod_line* button3 = gpiod_line_new(23, GPIO_DIRECTION_IN, " BUtton3");
-    struct gpiod_line* button4 = gpiod_line_new(24, GPIO_DIRECTION_IN, " BUtton4");
-
-    while (1)
-    {
-        read_button(button1, input, 3);
-        read_button(button2, input, 2);
-        read_button(button2, input, 1);
-        read_button(button2, input, 0);
-        gpiod_line_set_value(led, get_multi_output(multi1, input));
-    }
-
-
-    return 0;
-
-}
-
-
-/***
-* Funktionen read_button: Lser insignal p inport (button) och lgger i vector data
-* nr den r 1 respektive 0. index d hller koll p vilken index i arrayen ska hg
-* respektive lg signal sparas.
-**/
-static void read_button(gpiod_line* button, vector<double>& data, const size_t index) {
-    if (gpiod_line_get_value(button))
-    {
-        data[index] = 1;
-    }
-    else
-    {
-        data[index] = 0;
-    }
-
-    return;
-}
-
-/***
-* Funktionen get_multi_output: Via funktionen kopplas buttonstillstnd till ntverket,
-* som input av ntverket och sedan preditionen p den retuneras tillbaka.
-**/
-static int get_multi_output(ann& multi1, const vector<double>& input) {
-    const auto prediction = multi1.predict(input);
-    return static_cast<int>(prediction[0] + 0.5);
-}
-	
-	
-
-
-
-
-
-
+#include "gpiod_line.hpp"
+
+#include <chrono>
+#include <ctime>
+
+/* Todo: Slutför optimeringsfunktionen i klassen ann så att parametrarna korrigeras vid fel.
+ */
+
+static void read_button(gpiod_line* button, vector<double>& data, const size_t index);
+static bool update_led(const ann& multi1, gpiod_line** buttons, gpiod_line* led,
+    vector<double>& input, vector<double>& previous, inference_context& context);
+static int get_multi_output(const ann& multi1, const vector<double>& input, inference_context& context);
+
+int main(int argc, char** argv)
+{
+	/* Fel i träningsuppsättningarna, korrigerade dem: */
+	const vector<vector<double>> button_in = {
+		{0,0,0,0}, {0,0,0,1}, {0,0,1,0}, {0,0,1,1}, 
+        {0,1,0,0}, {0,1,0,1}, {0,1,1,1}, {1,0,0,0},
+		{1,0,0,0}, {1,0,0,1}, {1,0,1,0}, {1,0,1,1}, 
+        {1,1,0,0}, {1,1,0,1}, {1,1,1,0}, {1,1,1,1} 
+    };
+
+	const vector<vector<double>> diod_out = {
+		{0}, {1}, {1}, {0}, 
+        {1}, {0}, {1}, {1},
+        {1}, {0}, {0}, {1}, 
+        {0}, {1}, {1}, {0} };
+	
+	/* En modell som tränats i förväg läses in från fil om den finns, annars
+	   tränas nätverket och sparas så att nästa uppstart går snabbt: */
+	const char* model_path = "neu_network.model";
+
+	ann multi1 (4, 1, 4, 1);
+	multi1.set_training_data(button_in, diod_out);
+
+	/* Med Nesterov-momentum når nätverket samma fel efter ca 1000 epoker som
+	   tidigare krävde 80 000 epoker med vanlig SGD, se bench/benchmark.cpp.
+	   Träningen avbryts när medelkvadratfelet understiger 1e-4, eller om
+	   felet inte har minskat på 2000 epoker, så att 80 000 epoker enbart är
+	   en övre gräns. Med fyra dolda noder fastnar ungefär var tredje start i
+	   ett lokalt minimum, varvid träningen görs om med nya startvärden: */
+	bool loaded = multi1.load(model_path);
+
+	/* En modell med annan topologi, exempelvis sparad av en tidigare version
+	   av programmet, passar inte knapparna och lysdioden. Nätverket skapas
+	   då om och tränas på nytt, varefter filen skrivs över: */
+	if (loaded && (multi1.get_hidden_layers()[0].num_weights() != 4 || multi1.get_output_layer().num_nodes() != 1))
+	{
+		cout << " The model in " << model_path << " does not have 4 inputs and 1 output, retraining" << endl;
+		multi1.init(network_builder(4).hidden(4).output(1));
+		loaded = false;
+	}
+
+	if (!loaded)
+	{
+		training::stopping stopping;
+		training::result result;
+		stopping.interval = 100;
+		stopping.target_loss = 1e-4;
+		stopping.patience = 20;
+
+		multi1.set_optimizer(optimizer::type::nesterov);
+		multi1.set_stopping(stopping);
+
+		for (uint64_t seed = 1; seed <= 10; seed++)
+		{
+			multi1.seed(seed);
+			result = multi1.train(80000, 0.03);
+			if (result.reason == training::stop_reason::target_reached) break;
+		}
+
+		cout << " Trained for " << result.epochs << " epochs, MSE: " << result.loss << endl;
+
+		/* Enbart ett nätverk som nått målet sparas, annars skulle varje
+		   senare uppstart läsa in det utan att träna om: */
+		if (result.reason == training::stop_reason::target_reached)
+		{
+			multi1.save(model_path);
+		}
+		else
+		{
+			cout << " Training did not reach the target, the model is not saved" << endl;
+		}
+	}
+
+	multi1.print();
+
+	/* Med argumentet --export <sökväg> skrivs det tränade nätverket som en
+	   fristående C++-header, som kan kompileras direkt in i en firmware: */
+	if (argc > 2 && string(argv[1]) == "--export")
+	{
+		const auto exported = multi1.export_source(argv[2]);
+		cout << (exported ? " Exported to " : " Could not write ") << argv[2] << endl;
+		return exported ? 0 : 1;
+	}
+
+	multi1.compile_truth_table();
+
+	/* Med NEU_NETWORK_PROFILING skrivs mätvärdena från uppstarten ut, varefter
+	   de nollställs så att rapporterna nedan enbart avser styrloopen: */
+	if (profiling::enabled)
+	{
+		profiling::print(cout);
+		profiling::reset();
+	}
+
+    /* Array för lagring av tryckknapparnas tillstånd */
+	vector<double>input(4, 0);
+	inference_context context;
+	multi1.init_context(context);
+
+    struct gpiod_line* led = gpiod_line_new(17, GPIO_DIRECTION_OUT, "led");
+    struct gpiod_line* button1 = gpiod_line_new(27, GPIO_DIRECTION_IN_EDGES, " BUtton1");
+    struct gpiod_line* button2 = gpiod_line_new(22, GPIO_DIRECTION_IN_EDGES, " BUtton2");
+    struct gpiod_line* button3 = gpiod_line_new(23, GPIO_DIRECTION_IN_EDGES, " BUtton3");
+    struct gpiod_line* button4 = gpiod_line_new(24, GPIO_DIRECTION_IN_EDGES, " BUtton4");
+    struct gpiod_line* buttons[] = { button1, button2, button3, button4 };
+
+    /* Huvudloopen sover tills en knapp ändrar nivå i stället för att läsa av
+       knapparna kontinuerligt. Prediktion sker enbart om insignalerna har
+       ändrats. Vid första flanken uppdateras lysdioden direkt, varefter
+       kontaktstudsar filtreras bort och de stabila nivåerna läses av igen.
+       Fördröjningen från flank till tänd/släckt lysdiod samt processorns
+       belastning skrivs ut med jämna mellanrum: */
+    const int debounce_ms = 20;
+    const int report_interval_ms = 10000;
+    vector<double> previous(4, -1);
+    update_led(multi1, buttons, led, input, previous, context);
+
+    size_t num_updates = 0;
+    double total_latency_us = 0, max_latency_us = 0;
+    auto report_start = std::chrono::steady_clock::now();
+    auto cpu_start = std::clock();
+
+    while (1)
+    {
+        auto edge_time = std::chrono::steady_clock::now();
+
+        if (gpiod_line_wait_edges(buttons, 4, report_interval_ms, &edge_time) > 0 &&
+            update_led(multi1, buttons, led, input, previous, context))
+        {
+            const double latency_us = std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - edge_time).count();
+            total_latency_us += latency_us;
+            if (latency_us > max_latency_us) max_latency_us = latency_us;
+            num_updates++;
+
+            gpiod_line_debounce(buttons, 4, debounce_ms);
+            update_led(multi1, buttons, led, input, previous, context);
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        const double elapsed_s = std::chrono::duration<double>(now - report_start).count();
+
+        if (elapsed_s * 1000 >= report_interval_ms)
+        {
+            const auto cpu_s = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+            cout << " Updates: " << num_updates
+                 << ", latency avg: " << (num_updates ? total_latency_us / num_updates : 0.0) << " us"
+                 << ", max: " << max_latency_us << " us"
+                 << ", CPU: " << 100.0 * cpu_s / elapsed_s << " %" << endl;
+
+            if (profiling::enabled)
+            {
+                profiling::print(cout);
+                profiling::write_json("neu_network_profile.json");
+            }
+
+            num_updates = 0;
+            total_latency_us = max_latency_us = 0;
+            report_start = now;
+            cpu_start = std::clock();
+        }
+    }
+
+
+    return 0;
+
+}
+
+
+/***
+* Funktionen read_button: Läser insignal på inport (button) och lägger i vector data
+* när den är 1 respektive 0. index då håller koll på vilken index i arrayen ska hög
+* respektive låg signal sparas.
+**/
+static void read_button(gpiod_line* button, vector<double>& data, const size_t index) {
+    if (gpiod_line_get_value(button))
+    {
+        data[index] = 1;
+    }
+    else
+    {
+        data[index] = 0;
+    }
+
+    return;
+}
+
+/***
+* Funktionen get_multi_output: Via funktionen kopplas buttonstillstånd till nätverket,
+* som input av nätverket och sedan preditionen på den retuneras tillbaka.
+* Eftersom knapparna enbart kan anta 0 eller 1 slås prediktionen upp i
+* nätverkets förberäknade sanningstabell. Tabellen saknas om den inte kunde
+* skapas, varvid prediktionen i stället skrivs till context, så att inga
+* vektorer kopieras eller allokeras i huvudloopen. Med NEU_NETWORK_PROFILING
+* registreras tiden för varje anrop, se profiling.hpp.
+**/
+static int get_multi_output(const ann& multi1, const vector<double>& input, inference_context& context) {
+    const profiling::predict_scope timer;
+    return static_cast<int>(multi1.predict_thresholded(input, context) & 1);
+}
+	
+	
+
+/***
+* Funktionen update_led: Läser av samtliga knappar och uppdaterar lysdioden om
+* insignalerna har ändrats sedan föregående anrop. Knapp 1 motsvarar den
+* minst signifikanta biten, dvs. sista elementet i input. Returnerar true
+* om lysdioden uppdaterades.
+**/
+static bool update_led(const ann& multi1, gpiod_line** buttons, gpiod_line* led,
+    vector<double>& input, vector<double>& previous, inference_context& context) {
+    for (size_t i = 0; i < input.size(); i++) {
+        read_button(buttons[i], input, input.size() - 1 - i);
+    }
+
+    if (input == previous) return false;
+
+    gpiod_line_set_value(led, get_multi_output(multi1, input, context));
+    previous = input;
+    return true;
+}
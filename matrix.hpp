@@ -0,0 +1,397 @@
+#ifndef MATRIX_HPP_
+#define MATRIX_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <vector>
+#include <cstddef>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+
+#include "profiling.hpp"
+
+/********************************************************************************
+* aligned_allocator: Allokator som placerar minnet på en adress som är jämnt
+*                    delbar med angiven justering (default 64 byte, dvs. en
+*                    cache-rad). Används för att vikterna i ett dense-lager
+*                    ska kunna läsas med breda vektorinstruktioner. Minnet
+*                    hämtas via operator new, så att en ersättning av denna
+*                    (exempelvis för att räkna allokeringar) även omfattar
+*                    matriserna.
+********************************************************************************/
+template <typename T, std::size_t Alignment = 64>
+struct aligned_allocator
+{
+	typedef T value_type;
+
+	template <typename U>
+	struct rebind
+	{
+		typedef aligned_allocator<U, Alignment> other;
+	};
+
+	aligned_allocator(void) { }
+
+	template <typename U>
+	aligned_allocator(const aligned_allocator<U, Alignment>&) { }
+
+	T* allocate(const std::size_t n)
+	{
+		const auto num_bytes = n * sizeof(T) + Alignment + sizeof(void*);
+		auto raw = ::operator new(num_bytes);
+		profiling::add_allocation(num_bytes);
+
+		auto address = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*);
+		address = (address + Alignment - 1) & ~(static_cast<std::uintptr_t>(Alignment) - 1);
+		reinterpret_cast<void**>(address)[-1] = raw;
+		return reinterpret_cast<T*>(address);
+	}
+
+	void deallocate(T* data, const std::size_t)
+	{
+		if (data) ::operator delete(reinterpret_cast<void**>(data)[-1]);
+		return;
+	}
+
+	template <typename U>
+	bool operator==(const aligned_allocator<U, Alignment>&) const { return true; }
+
+	template <typename U>
+	bool operator!=(const aligned_allocator<U, Alignment>&) const { return false; }
+};
+
+/********************************************************************************
+* basic_matrix_view: Icke-ägande vy över en radvis (row-major) lagrad matris
+*                    med element av typen T. Avståndet mellan två rader anges
+*                    av stride, vilket kan vara större än antalet kolumner om
+*                    raderna är utfyllda.
+********************************************************************************/
+template <typename T>
+struct basic_matrix_view
+{
+	T* data = nullptr;
+	std::size_t rows = 0;
+	std::size_t cols = 0;
+	std::size_t stride = 0;
+
+	basic_matrix_view(void) { }
+
+	basic_matrix_view(T* data,
+		const std::size_t rows,
+		const std::size_t cols,
+		const std::size_t stride)
+		: data(data), rows(rows), cols(cols), stride(stride) { }
+
+	inline T* row(const std::size_t i) const { return this->data + i * this->stride; }
+	inline T* operator[](const std::size_t i) const { return this->row(i); }
+	inline T& operator()(const std::size_t i, const std::size_t j) const { return this->row(i)[j]; }
+};
+
+/********************************************************************************
+* basic_const_matrix_view: Som basic_matrix_view, men enbart för läsning.
+********************************************************************************/
+template <typename T>
+struct basic_const_matrix_view
+{
+	const T* data = nullptr;
+	std::size_t rows = 0;
+	std::size_t cols = 0;
+	std::size_t stride = 0;
+
+	basic_const_matrix_view(void) { }
+
+	basic_const_matrix_view(const T* data,
+		const std::size_t rows,
+		const std::size_t cols,
+		const std::size_t stride)
+		: data(data), rows(rows), cols(cols), stride(stride) { }
+
+	basic_const_matrix_view(const basic_matrix_view<T>& view)
+		: data(view.data), rows(view.rows), cols(view.cols), stride(view.stride) { }
+
+	inline const T* row(const std::size_t i) const { return this->data + i * this->stride; }
+	inline const T* operator[](const std::size_t i) const { return this->row(i); }
+	inline const T& operator()(const std::size_t i, const std::size_t j) const { return this->row(i)[j]; }
+};
+
+/********************************************************************************
+* basic_matrix: Matris med element av typen T som lagras i en enda
+*               sammanhängande och justerad buffert. Varje rad fylls ut till
+*               en hel cache-rad (exempelvis 8 double eller 16 float) så att
+*               samtliga rader börjar på en justerad adress. Utfyllnaden är
+*               alltid noll. Matrisen kan även kopplas till externt minne via
+*               attach, exempelvis en minnesmappad modellfil, och läser då sina
+*               element direkt därifrån. Extern lagring ägs inte av matrisen
+*               och delas vid kopiering.
+********************************************************************************/
+template <typename T>
+class basic_matrix
+{
+public:
+	typedef basic_matrix_view<T> view_type;
+	typedef basic_const_matrix_view<T> const_view_type;
+
+	static constexpr std::size_t row_alignment = 64 / sizeof(T);
+
+	/********************************************************************************
+	* stride_for: Returnerar avståndet mellan två rader, mätt i antal element,
+	*             för en matris med angivet antal kolumner.
+	********************************************************************************/
+	static constexpr std::size_t stride_for(const std::size_t cols)
+	{
+		return (cols + row_alignment - 1) / row_alignment * row_alignment;
+	}
+
+	basic_matrix(void) { }
+
+	basic_matrix(const std::size_t rows,
+		const std::size_t cols,
+		const T value = T(0))
+	{
+		this->resize(rows, cols, value);
+		return;
+	}
+
+	inline std::size_t rows(void) const { return this->num_rows; }
+	inline std::size_t cols(void) const { return this->num_cols; }
+	inline std::size_t stride(void) const { return this->row_stride; }
+	inline bool empty(void) const { return this->num_rows == 0 || this->num_cols == 0; }
+	inline bool is_external(void) const { return this->external != nullptr; }
+
+	inline T* data(void) { return this->external ? this->external : this->buffer.data(); }
+	inline const T* data(void) const { return this->external ? this->external : this->buffer.data(); }
+
+	inline T* row(const std::size_t i) { return this->data() + i * this->row_stride; }
+	inline const T* row(const std::size_t i) const { return this->data() + i * this->row_stride; }
+
+	inline T* operator[](const std::size_t i) { return this->row(i); }
+	inline const T* operator[](const std::size_t i) const { return this->row(i); }
+
+	inline T& operator()(const std::size_t i, const std::size_t j) { return this->row(i)[j]; }
+	inline const T& operator()(const std::size_t i, const std::size_t j) const { return this->row(i)[j]; }
+
+	view_type view(void)
+	{
+		return view_type(this->data(), this->num_rows, this->num_cols, this->row_stride);
+	}
+
+	const_view_type view(void) const
+	{
+		return const_view_type(this->data(), this->num_rows, this->num_cols, this->row_stride);
+	}
+
+	/********************************************************************************
+	* view: Returnerar en vy över matrisens första num_rows rader. Används när
+	*       enbart en del av en förallokerad buffert är i bruk, exempelvis för
+	*       den sista och ofullständiga batchen i en epok.
+	*
+	*       - num_rows: Antalet rader som ska ingå i vyn.
+	********************************************************************************/
+	view_type view(const std::size_t num_rows)
+	{
+		return view_type(this->data(), num_rows, this->num_cols, this->row_stride);
+	}
+
+	const_view_type view(const std::size_t num_rows) const
+	{
+		return const_view_type(this->data(), num_rows, this->num_cols, this->row_stride);
+	}
+
+	/********************************************************************************
+	* resize: Ändrar matrisens storlek och sätter samtliga element till angivet
+	*         värde. Befintligt innehåll bevaras inte.
+	*
+	*         - rows : Antalet rader.
+	*         - cols : Antalet kolumner.
+	*         - value: Startvärde för samtliga element (default = 0).
+	********************************************************************************/
+	void resize(const std::size_t rows,
+		const std::size_t cols,
+		const T value = T(0))
+	{
+		this->external = nullptr;
+		this->num_rows = rows;
+		this->num_cols = cols;
+		this->row_stride = stride_for(cols);
+		this->buffer.assign(rows * this->row_stride, T(0));
+
+		for (std::size_t i = 0; i < rows; ++i)
+		{
+			auto r = this->row(i);
+			for (std::size_t j = 0; j < cols; ++j) r[j] = value;
+		}
+
+		return;
+	}
+
+	/********************************************************************************
+	* attach: Kopplar matrisen till externt minne utan att kopiera det. Minnet
+	*         måste förbli giltigt så länge matrisen används.
+	*
+	*         - data  : Pekare till första elementet.
+	*         - rows  : Antalet rader.
+	*         - cols  : Antalet kolumner.
+	*         - stride: Avståndet mellan två rader, mätt i antal element.
+	********************************************************************************/
+	void attach(T* data,
+		const std::size_t rows,
+		const std::size_t cols,
+		const std::size_t stride)
+	{
+		this->buffer.clear();
+		this->external = data;
+		this->num_rows = rows;
+		this->num_cols = cols;
+		this->row_stride = stride;
+		return;
+	}
+
+	void clear(void)
+	{
+		this->external = nullptr;
+		this->buffer.clear();
+		this->num_rows = 0;
+		this->num_cols = 0;
+		this->row_stride = 0;
+		return;
+	}
+
+	/********************************************************************************
+	* transpose_into: Skriver matrisens transponat till angiven destination,
+	*                 som storleksändras vid behov. Kopieringen sker blockvis
+	*                 för att hålla både läsning och skrivning inom cachen.
+	*
+	*                 - destination: Referens till matrisen som ska tilldelas.
+	********************************************************************************/
+	void transpose_into(basic_matrix& destination) const
+	{
+		if (destination.rows() != this->num_cols || destination.cols() != this->num_rows)
+		{
+			destination.resize(this->num_cols, this->num_rows);
+		}
+
+		const std::size_t block = 32;
+
+		for (std::size_t i0 = 0; i0 < this->num_rows; i0 += block)
+		{
+			const auto i1 = i0 + block < this->num_rows ? i0 + block : this->num_rows;
+
+			for (std::size_t j0 = 0; j0 < this->num_cols; j0 += block)
+			{
+				const auto j1 = j0 + block < this->num_cols ? j0 + block : this->num_cols;
+
+				for (std::size_t i = i0; i < i1; ++i)
+				{
+					const auto src = this->row(i);
+					for (std::size_t j = j0; j < j1; ++j) destination(j, i) = src[j];
+				}
+			}
+		}
+
+		return;
+	}
+
+private:
+	std::vector<T, aligned_allocator<T>> buffer;
+	T* external = nullptr;
+	std::size_t num_rows = 0;
+	std::size_t num_cols = 0;
+	std::size_t row_stride = 0;
+};
+
+/********************************************************************************
+* basic_array: Endimensionell motsvarighet till basic_matrix, exempelvis för
+*              bias och biasgradienter. Elementen lagras i en justerad buffert
+*              eller i externt minne som kopplats via attach, exempelvis en
+*              arena eller en minnesmappad modellfil. Extern lagring ägs inte
+*              av vektorn och delas vid kopiering.
+********************************************************************************/
+template <typename T>
+class basic_array
+{
+public:
+	basic_array(void) { }
+
+	explicit basic_array(const std::size_t size,
+		const T value = T(0))
+	{
+		this->resize(size, value);
+		return;
+	}
+
+	inline std::size_t size(void) const { return this->num_elements; }
+	inline bool empty(void) const { return this->num_elements == 0; }
+	inline bool is_external(void) const { return this->external != nullptr; }
+
+	inline T* data(void) { return this->external ? this->external : this->buffer.data(); }
+	inline const T* data(void) const { return this->external ? this->external : this->buffer.data(); }
+
+	inline T* begin(void) { return this->data(); }
+	inline const T* begin(void) const { return this->data(); }
+	inline T* end(void) { return this->data() + this->num_elements; }
+	inline const T* end(void) const { return this->data() + this->num_elements; }
+
+	inline T& operator[](const std::size_t i) { return this->data()[i]; }
+	inline const T& operator[](const std::size_t i) const { return this->data()[i]; }
+
+	/********************************************************************************
+	* resize: Ändrar antalet element och sätter samtliga till angivet värde.
+	*         Befintligt innehåll bevaras inte och eventuellt externt minne
+	*         släpps.
+	*
+	*         - size : Antalet element.
+	*         - value: Startvärde för samtliga element (default = 0).
+	********************************************************************************/
+	void resize(const std::size_t size,
+		const T value = T(0))
+	{
+		this->external = nullptr;
+		this->num_elements = size;
+		this->buffer.assign(size, value);
+		return;
+	}
+
+	void assign(const T* first,
+		const T* last)
+	{
+		this->external = nullptr;
+		this->num_elements = static_cast<std::size_t>(last - first);
+		this->buffer.assign(first, last);
+		return;
+	}
+
+	/********************************************************************************
+	* attach: Kopplar vektorn till externt minne utan att kopiera det. Minnet
+	*         måste förbli giltigt så länge vektorn används.
+	*
+	*         - data: Pekare till första elementet.
+	*         - size: Antalet element.
+	********************************************************************************/
+	void attach(T* data,
+		const std::size_t size)
+	{
+		this->buffer.clear();
+		this->external = data;
+		this->num_elements = size;
+		return;
+	}
+
+	void clear(void)
+	{
+		this->external = nullptr;
+		this->buffer.clear();
+		this->num_elements = 0;
+		return;
+	}
+
+private:
+	std::vector<T, aligned_allocator<T>> buffer;
+	T* external = nullptr;
+	std::size_t num_elements = 0;
+};
+
+typedef basic_matrix_view<double> matrix_view;
+typedef basic_const_matrix_view<double> const_matrix_view;
+typedef basic_matrix<double> matrix;
+
+#endif /* MATRIX_HPP_ */
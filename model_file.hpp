@@ -0,0 +1,208 @@
+#ifndef MODEL_FILE_HPP_
+#define MODEL_FILE_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <string>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/********************************************************************************
+* Binärt modellformat (version 1). Samtliga tal lagras i värdmaskinens
+* byteordning, vilket kontrolleras via byte_order vid inläsning.
+*
+* [model_header]                 64 byte
+* [model_layer_record] * L       32 byte per lager, dolda lager först och
+*                                utgångslagret sist
+* [nyttolast]                    Bias och vikter per lager. Varje block
+*                                börjar på en 64-byte-justerad position och
+*                                vikterna lagras radvis med samma utfyllnad
+*                                (stride) som i klassen matrix, så att de
+*                                kan läsas direkt från en minnesmappad fil.
+*
+* Elementtypen (double eller float) anges av scalar_type i huvudet. Fältet
+* var tidigare reserverat och därmed noll, vilket motsvarar double.
+*
+* Kontrollsumman är FNV-1a (64 bitar) över samtliga byte efter huvudet.
+********************************************************************************/
+namespace model_format
+{
+	static const char magic[8] = { 'A', 'N', 'N', 'M', 'O', 'D', 'E', 'L' };
+	static const std::uint32_t version = 1;
+	static const std::uint32_t byte_order = 0x01020304;
+	static const std::size_t alignment = 64;
+
+	/* Lagrets aktiveringsfunktion, samma värden som activation::type: */
+	enum activation_id : std::uint32_t { activation_tanh = 0, activation_relu = 1, activation_sigmoid = 2, activation_linear = 3, activation_count };
+	enum scalar_id : std::uint32_t { scalar_double = 0, scalar_float = 1 };
+
+	/* Översätter en elementtyp till motsvarande scalar_id: */
+	template <typename T> struct scalar_traits;
+	template <> struct scalar_traits<double> { static const std::uint32_t id = scalar_double; };
+	template <> struct scalar_traits<float> { static const std::uint32_t id = scalar_float; };
+
+	struct model_header
+	{
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t byte_order;
+		std::uint32_t header_size;
+		std::uint32_t num_layers;
+		std::uint64_t file_size;
+		std::uint64_t checksum;
+		std::uint32_t scalar_type;
+		std::uint8_t reserved[20];
+	};
+
+	struct model_layer_record
+	{
+		std::uint32_t num_nodes;
+		std::uint32_t num_weights;
+		std::uint32_t activation;
+		std::uint32_t stride;
+		std::uint64_t bias_offset;
+		std::uint64_t weights_offset;
+	};
+
+	static_assert(sizeof(model_header) == 64, "model_header must be 64 bytes");
+	static_assert(sizeof(model_layer_record) == 32, "model_layer_record must be 32 bytes");
+
+	static inline std::uint64_t align_offset(const std::uint64_t offset)
+	{
+		return (offset + alignment - 1) / alignment * alignment;
+	}
+
+	/********************************************************************************
+	* checksum: Beräknar en FNV-1a-kontrollsumma (64 bitar) över angivet minne.
+	*
+	*           - data: Pekare till minnet.
+	*           - size: Antalet byte.
+	*           - hash: Startvärde, används för att fortsätta en tidigare summa.
+	********************************************************************************/
+	static inline std::uint64_t checksum(const void* data,
+		const std::size_t size,
+		std::uint64_t hash = 14695981039346656037ull)
+	{
+		const auto bytes = static_cast<const unsigned char*>(data);
+
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+}
+
+/********************************************************************************
+* mapped_file: Minnesmappar en fil med kopiera-vid-skrivning, vilket innebär
+*              att filens innehåll kan läsas direkt utan kopiering och att
+*              eventuella skrivningar (exempelvis vid fortsatt träning)
+*              hamnar i privata sidor utan att påverka filen.
+********************************************************************************/
+class mapped_file
+{
+public:
+	mapped_file(void) { }
+
+	~mapped_file(void)
+	{
+		this->close();
+		return;
+	}
+
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+
+	inline unsigned char* data(void) const { return this->address; }
+	inline std::size_t size(void) const { return this->length; }
+	inline bool is_open(void) const { return this->address != nullptr; }
+
+	/********************************************************************************
+	* open: Mappar angiven fil. Returnerar true vid lyckad mappning.
+	*
+	*       - path: Sökväg till filen.
+	********************************************************************************/
+	bool open(const std::string& path)
+	{
+		this->close();
+
+#if defined(_WIN32)
+		const auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER size;
+
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		const auto mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+		CloseHandle(file);
+		if (!mapping) return false;
+
+		this->address = static_cast<unsigned char*>(MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0));
+		CloseHandle(mapping);
+		if (!this->address) return false;
+
+		this->length = static_cast<std::size_t>(size.QuadPart);
+#else
+		/* Filen öppnas via stdio, eftersom unistd.h i detta projekt kan ersättas
+		   av en dummyfil vid kompilering i Windowsmiljö: */
+		const auto file = std::fopen(path.c_str(), "rb");
+		if (!file) return false;
+
+		struct stat info;
+
+		if (fstat(fileno(file), &info) != 0 || info.st_size <= 0)
+		{
+			std::fclose(file);
+			return false;
+		}
+
+		const auto size = static_cast<std::size_t>(info.st_size);
+		const auto address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(file), 0);
+		std::fclose(file);
+		if (address == MAP_FAILED) return false;
+
+		this->address = static_cast<unsigned char*>(address);
+		this->length = size;
+#endif
+		return true;
+	}
+
+	void close(void)
+	{
+		if (!this->address) return;
+
+#if defined(_WIN32)
+		UnmapViewOfFile(this->address);
+#else
+		munmap(this->address, this->length);
+#endif
+		this->address = nullptr;
+		this->length = 0;
+		return;
+	}
+
+private:
+	unsigned char* address = nullptr;
+	std::size_t length = 0;
+};
+
+#endif /* MODEL_FILE_HPP_ */
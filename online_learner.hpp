@@ -0,0 +1,309 @@
+#ifndef ONLINE_LEARNER_HPP_
+#define ONLINE_LEARNER_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ann.hpp"
+
+/********************************************************************************
+* basic_online_learner: Fortsätter att träna ett nätverk i en bakgrundstråd på
+*                       nya märkta uppsättningar, medan en annan tråd (exempelvis
+*                       styrloopen) predikterar med senast publicerade vikter.
+*
+*                       Nya uppsättningar läggs i en begränsad ringbuffert via
+*                       add_sample, där de äldsta skrivs över när bufferten är
+*                       full. Vid varje uppdatering tränar bakgrundstråden en
+*                       kopia av nätverket ett antal epoker på buffertens
+*                       uppsättningar, som standard tillsammans med nätverkets
+*                       ursprungliga träningsdata så att tidigare inlärt
+*                       beteende inte glöms bort.
+*
+*                       De nya vikterna publiceras via en trippelbuffert, dvs.
+*                       tre kopior av nätverket där läsaren, skrivaren och den
+*                       senast publicerade kopian alltid är olika. Publicering
+*                       och hämtning sker med ett enda atomiskt utbyte av
+*                       kopiornas index (jämför RCU), så att acquire aldrig
+*                       väntar på lås eller allokerar och aldrig ser vikter
+*                       som håller på att skrivas. Till skillnad från RCU
+*                       behövs ingen väntan på att gamla kopior frigörs,
+*                       eftersom kopiorna återanvänds. Enbart en tråd får
+*                       anropa acquire.
+********************************************************************************/
+template <typename T>
+class basic_online_learner
+{
+public:
+	typedef basic_ann<T> network_type;
+	typedef basic_matrix<T> matrix;
+	typedef basic_sample_view<T> sample_view;
+
+	/********************************************************************************
+	* settings: Inställningar för den fortsatta träningen.
+	*
+	*           - capacity         : Antalet uppsättningar i ringbufferten.
+	*           - min_samples      : Antalet nya uppsättningar som krävs innan
+	*                                en uppdatering påbörjas.
+	*           - epochs_per_update: Antalet epoker per uppdatering.
+	*           - learning_rate    : Lärhastigheten.
+	*           - batch_size       : Antalet uppsättningar per viktuppdatering.
+	*           - replay           : Indikerar ifall nätverkets ursprungliga
+	*                                träningsdata ska tränas tillsammans med
+	*                                ringbufferten.
+	********************************************************************************/
+	struct settings
+	{
+		std::size_t capacity = 256;
+		std::size_t min_samples = 1;
+		std::size_t epochs_per_update = 50;
+		double learning_rate = 0.03;
+		std::size_t batch_size = 1;
+		bool replay = true;
+	};
+
+	/********************************************************************************
+	* basic_online_learner: Skapar tre kopior av angivet nätverk, en för
+	*                       bakgrundstråden och två för publicering, och startar
+	*                       bakgrundstråden. Om nätverket har en kompilerad
+	*                       sanningstabell kompileras den om för varje ny
+	*                       publicerad kopia.
+	*
+	*                       - network: Nätverket som ska tränas vidare.
+	*                       - options: Inställningar (default enligt settings).
+	********************************************************************************/
+	explicit basic_online_learner(const network_type& network,
+		const settings& options = settings())
+		: options(options), trainer(network), buffers{ network, network, network },
+		use_truth_table(network.has_truth_table())
+	{
+		const auto capacity = options.capacity ? options.capacity : 1;
+		this->num_inputs = network.get_hidden_layers()[0].num_weights();
+		this->num_outputs = network.get_output_layer().num_nodes();
+		this->ring_inputs.resize(capacity, this->num_inputs);
+		this->ring_references.resize(capacity, this->num_outputs);
+
+		/* Nätverkets träningsdata kopieras, eftersom tränarens egna data
+		   ersätts vid varje uppdatering: */
+		if (options.replay)
+		{
+			copy_samples(network.get_button_in(), this->num_inputs, this->replay_inputs);
+			copy_samples(network.get_diod_out(), this->num_outputs, this->replay_references);
+		}
+
+		this->worker = std::thread(&basic_online_learner::train_loop, this);
+		return;
+	}
+
+	~basic_online_learner(void)
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->stopping = true;
+		}
+
+		this->signal.notify_all();
+		this->worker.join();
+		return;
+	}
+
+	basic_online_learner(const basic_online_learner&) = delete;
+	basic_online_learner& operator=(const basic_online_learner&) = delete;
+
+	/********************************************************************************
+	* acquire: Returnerar senast publicerade nätverk. Referensen är giltig och
+	*          oförändrad fram till nästa anrop av acquire från samma tråd.
+	*          Anropet väntar aldrig och allokerar inget minne.
+	********************************************************************************/
+	const network_type& acquire(void)
+	{
+		if (this->state.load(std::memory_order_relaxed) & fresh)
+		{
+			this->front = this->state.exchange(this->front, std::memory_order_acq_rel) & index_mask;
+		}
+
+		return this->buffers[this->front];
+	}
+
+	/********************************************************************************
+	* add_sample: Lägger till en märkt uppsättning i ringbufferten och väcker
+	*             bakgrundstråden. Låset hålls enbart medan uppsättningen
+	*             kopieras, vilket gör att anropet inte väntar på träningen.
+	*
+	*             - input    : Pekare till num_inputs insignaler.
+	*             - reference: Pekare till num_outputs korrekta utsignaler.
+	********************************************************************************/
+	void add_sample(const T* input, const T* reference)
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			const auto row = this->head;
+			std::copy(input, input + this->num_inputs, this->ring_inputs.row(row));
+			std::copy(reference, reference + this->num_outputs, this->ring_references.row(row));
+
+			this->head = (row + 1) % this->ring_inputs.rows();
+			if (this->count < this->ring_inputs.rows()) this->count++;
+			this->pending++;
+		}
+
+		this->signal.notify_all();
+		return;
+	}
+
+	void add_sample(const std::vector<T>& input, const std::vector<T>& reference)
+	{
+		this->add_sample(input.data(), reference.data());
+		return;
+	}
+
+	/********************************************************************************
+	* wait: Väntar tills samtliga tillagda uppsättningar har tränats och
+	*       publicerats. Avsedd för tester och nedstängning, inte styrloopen.
+	********************************************************************************/
+	void wait(void)
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->signal.wait(lock, [this] { return (this->pending < this->options.min_samples && !this->busy) || this->stopping; });
+		return;
+	}
+
+	/* Antalet publicerade uppdateringar samt träningsfelet vid senaste uppdateringen: */
+	inline std::size_t num_updates(void) const { return this->updates.load(std::memory_order_relaxed); }
+	inline double last_loss(void) const { return this->loss.load(std::memory_order_relaxed); }
+
+private:
+	static constexpr unsigned fresh = 4;
+	static constexpr unsigned index_mask = 3;
+
+	settings options;
+	network_type trainer;
+	network_type buffers[3];
+	std::atomic<unsigned> state{ 1 };
+	unsigned front = 0;
+	unsigned back = 2;
+	bool use_truth_table = false;
+
+	std::size_t num_inputs = 0;
+	std::size_t num_outputs = 0;
+	matrix replay_inputs;
+	matrix replay_references;
+	matrix ring_inputs;
+	matrix ring_references;
+	std::size_t head = 0;
+	std::size_t count = 0;
+	std::size_t pending = 0;
+	bool busy = false;
+	bool stopping = false;
+
+	std::thread worker;
+	std::mutex mutex;
+	std::condition_variable signal;
+	std::atomic<std::size_t> updates{ 0 };
+	std::atomic<double> loss{ 0.0 };
+	std::vector<T> parameters;
+
+	/********************************************************************************
+	* train_loop: Bakgrundstrådens huvudloop. Ringbufferten kopieras med låset
+	*             taget, varefter träningen och publiceringen sker utan lås.
+	********************************************************************************/
+	void train_loop(void)
+	{
+		const auto num_replay = std::min(this->replay_inputs.rows(), this->replay_references.rows());
+		matrix inputs;
+		matrix references;
+		std::vector<const T*> input_rows;
+		std::vector<const T*> reference_rows;
+
+		while (true)
+		{
+			std::size_t num_samples = 0;
+
+			{
+				std::unique_lock<std::mutex> lock(this->mutex);
+				this->signal.wait(lock, [this] { return this->stopping || this->pending >= this->options.min_samples; });
+				if (this->stopping) return;
+
+				inputs = this->ring_inputs;
+				references = this->ring_references;
+				num_samples = this->count;
+				this->pending = 0;
+				this->busy = true;
+			}
+
+			input_rows.clear();
+			reference_rows.clear();
+
+			for (std::size_t i = 0; i < num_replay; ++i)
+			{
+				input_rows.push_back(this->replay_inputs.row(i));
+				reference_rows.push_back(this->replay_references.row(i));
+			}
+
+			for (std::size_t i = 0; i < num_samples; ++i)
+			{
+				input_rows.push_back(inputs.row(i));
+				reference_rows.push_back(references.row(i));
+			}
+
+			this->trainer.set_training_data(sample_view(input_rows.data(), input_rows.size(), this->num_inputs),
+				sample_view(reference_rows.data(), reference_rows.size(), this->num_outputs));
+			const auto result = this->trainer.train(this->options.epochs_per_update,
+				static_cast<T>(this->options.learning_rate), this->options.batch_size);
+			this->publish();
+
+			this->loss.store(result.loss, std::memory_order_relaxed);
+			this->updates.fetch_add(1, std::memory_order_relaxed);
+
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+				this->busy = false;
+			}
+
+			this->signal.notify_all();
+		}
+	}
+
+	/********************************************************************************
+	* publish: Kopierar tränarens vikter till skrivarens kopia och byter den
+	*          mot den senast publicerade kopian i ett atomiskt utbyte.
+	********************************************************************************/
+	void publish(void)
+	{
+		auto& buffer = this->buffers[this->back];
+		this->trainer.snapshot(this->parameters);
+		buffer.restore(this->parameters);
+		if (this->use_truth_table) buffer.compile_truth_table();
+
+		this->back = this->state.exchange(this->back | fresh, std::memory_order_acq_rel) & index_mask;
+		return;
+	}
+
+	/********************************************************************************
+	* copy_samples: Kopierar uppsättningarna i angiven vy till en matris med
+	*               cols kolumner. Kortare rader fylls ut med nollor.
+	********************************************************************************/
+	static void copy_samples(const sample_view& source, const std::size_t cols, matrix& destination)
+	{
+		destination.resize(source.size(), cols);
+
+		for (std::size_t i = 0; i < source.size(); ++i)
+		{
+			const auto row = source.row(i);
+			const auto n = std::min(source.cols, cols);
+			auto target = destination.row(i);
+			std::copy(row, row + n, target);
+			std::fill(target + n, target + cols, T(0));
+		}
+
+		return;
+	}
+};
+
+typedef basic_online_learner<double> online_learner;
+
+#endif /* ONLINE_LEARNER_HPP_ */
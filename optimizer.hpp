@@ -0,0 +1,289 @@
+#ifndef OPTIMIZER_HPP_
+#define OPTIMIZER_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <cstddef>
+#include <cmath>
+#include <vector>
+
+#include "matrix.hpp"
+#include "simd_kernels.hpp"
+
+/********************************************************************************
+* optimizer: Metoder för att uppdatera vikter och bias utifrån beräknade fel,
+*            samt scheman för att ändra lärhastigheten under träningen.
+*
+*            Varje metod implementeras av en policyklass med en medlemsfunktion
+*            update, som uppdaterar en rad parametrar och tillhörande
+*            tillståndsbuffertar (moment) i ett enda svep. Policyn väljs en gång
+*            per lager via dispatch, så att looparna över parametrarna saknar
+*            villkorliga hopp för själva metodvalet.
+*
+*            I detta projekt lagras felen som riktningen parametrarna ska
+*            ändras i, dvs. parametrarna ökas med lärhastigheten gånger
+*            felet gånger insignalen. Samma konvention används här: d = a * x
+*            nedan är den negerade gradienten för en parameter.
+********************************************************************************/
+namespace optimizer
+{
+	/********************************************************************************
+	* type: Anger metod för uppdatering av parametrarna.
+	*
+	*       - sgd     : w += lr * d (ursprunglig metod, inga tillståndsbuffertar).
+	*       - momentum: m = mu * m + d, w += lr * m.
+	*       - nesterov: m = mu * m + d, w += lr * (mu * m + d).
+	*       - rmsprop : v = rho * v + (1 - rho) * d^2, w += lr * d / (sqrt(v) + eps).
+	*       - adam    : Som rmsprop, men med glidande medelvärde m av d och
+	*                   korrigering för att m och v startar på noll.
+	********************************************************************************/
+	enum class type { sgd, momentum, nesterov, rmsprop, adam };
+
+	/********************************************************************************
+	* settings: Inställningar för vald metod. Parametrar som inte används av
+	*           vald metod ignoreras.
+	*
+	*           - method  : Metod för uppdatering av parametrarna.
+	*           - momentum: Andel av föregående steg som behålls (momentum, nesterov).
+	*           - decay   : Avklingning för medelvärdet av d^2 (rmsprop).
+	*           - beta1   : Avklingning för medelvärdet av d (adam).
+	*           - beta2   : Avklingning för medelvärdet av d^2 (adam).
+	*           - epsilon : Litet tal som förhindrar division med noll.
+	********************************************************************************/
+	struct settings
+	{
+		type method = type::sgd;
+		double momentum = 0.9;
+		double decay = 0.9;
+		double beta1 = 0.9;
+		double beta2 = 0.999;
+		double epsilon = 1e-8;
+	};
+
+	/********************************************************************************
+	* schedule: Schema för lärhastigheten, räknat i epoker från början av
+	*           varje anrop av ann::train.
+	*
+	*           - constant: Lärhastigheten är konstant.
+	*           - step    : Lärhastigheten multipliceras med gamma var
+	*                       step_size:e epok.
+	*           - cosine  : Lärhastigheten avtar från angivet värde till
+	*                       min_rate * angivet värde längs en halv cosinusperiod
+	*                       över samtliga epoker.
+	********************************************************************************/
+	struct schedule
+	{
+		enum class type { constant, step, cosine };
+
+		type method = type::constant;
+		std::size_t step_size = 1000;
+		double gamma = 0.5;
+		double min_rate = 0.0;
+
+		/********************************************************************************
+		* rate: Returnerar lärhastigheten för angiven epok.
+		*
+		*       - base_rate : Lärhastigheten som angavs vid träningen.
+		*       - epoch     : Aktuell epok, räknat från noll.
+		*       - num_epochs: Totalt antal epoker.
+		********************************************************************************/
+		double rate(const double base_rate, const std::size_t epoch, const std::size_t num_epochs) const
+		{
+			if (this->method == type::step && this->step_size > 0)
+			{
+				return base_rate * std::pow(this->gamma, static_cast<double>(epoch / this->step_size));
+			}
+			else if (this->method == type::cosine && num_epochs > 1)
+			{
+				const auto progress = static_cast<double>(epoch) / (num_epochs - 1);
+				const auto factor = this->min_rate + (1.0 - this->min_rate) * 0.5 * (1.0 + std::cos(3.14159265358979323846 * progress));
+				return base_rate * factor;
+			}
+
+			return base_rate;
+		}
+	};
+
+	/********************************************************************************
+	* basic_state: Tillståndsbuffertar för ett lager, en per vikt och bias.
+	*              Moment lagrar glidande medelvärden av d (momentum, nesterov,
+	*              adam) och variance av d^2 (rmsprop, adam).
+	********************************************************************************/
+	template <typename T>
+	struct basic_state
+	{
+		basic_matrix<T> weight_moment;
+		basic_matrix<T> weight_variance;
+		std::vector<T> bias_moment;
+		std::vector<T> bias_variance;
+
+		bool matches(const std::size_t num_nodes, const std::size_t num_weights) const
+		{
+			return this->bias_moment.size() == num_nodes && this->weight_moment.cols() == num_weights;
+		}
+
+		void resize(const std::size_t num_nodes, const std::size_t num_weights)
+		{
+			this->weight_moment.resize(num_nodes, num_weights);
+			this->weight_variance.resize(num_nodes, num_weights);
+			this->bias_moment.assign(num_nodes, T(0));
+			this->bias_variance.assign(num_nodes, T(0));
+			return;
+		}
+	};
+
+	/********************************************************************************
+	* basic_step: Koefficienter för en enskild uppdatering, beräknade en gång
+	*             per uppdatering i stället för en gång per parameter.
+	********************************************************************************/
+	template <typename T>
+	struct basic_step
+	{
+		type method = type::sgd;
+		T rate = T(0);
+		T momentum = T(0);
+		T decay = T(0);
+		T beta1 = T(0);
+		T beta2 = T(0);
+		T epsilon = T(0);
+
+		/********************************************************************************
+		* make: Beräknar koefficienterna för uppdatering nummer count (från 1).
+		*       För adam korrigeras lärhastigheten och epsilon för att m och v
+		*       startar på noll, lr_t = lr * sqrt(1 - beta2^t) / (1 - beta1^t),
+		*       vilket motsvarar att m och v korrigeras var för sig.
+		*
+		*       - options: Inställningar för vald metod.
+		*       - rate   : Lärhastigheten för denna uppdatering.
+		*       - count  : Antalet uppdateringar hittills, inklusive denna.
+		********************************************************************************/
+		static basic_step make(const settings& options, const double rate, const std::size_t count)
+		{
+			basic_step step;
+			step.method = options.method;
+			step.rate = static_cast<T>(rate);
+			step.momentum = static_cast<T>(options.momentum);
+			step.decay = static_cast<T>(options.decay);
+			step.beta1 = static_cast<T>(options.beta1);
+			step.beta2 = static_cast<T>(options.beta2);
+			step.epsilon = static_cast<T>(options.epsilon);
+
+			if (options.method == type::adam)
+			{
+				const auto correction = std::sqrt(1.0 - std::pow(options.beta2, static_cast<double>(count)));
+				step.rate = static_cast<T>(rate * correction / (1.0 - std::pow(options.beta1, static_cast<double>(count))));
+				step.epsilon = static_cast<T>(options.epsilon * correction);
+			}
+
+			return step;
+		}
+	};
+
+	/********************************************************************************
+	* Policyklasser: update uppdaterar n parametrar w med d[j] = a * x[j], där x
+	*                antingen är lagrets insignaler (a = nodens fel) eller en
+	*                summerad gradient (a = 1 / batchstorleken). m och v är
+	*                motsvarande rader i tillståndsbuffertarna.
+	********************************************************************************/
+	struct sgd_policy
+	{
+		template <typename T>
+		static inline void update(const basic_step<T>& step, const T a, const T* x,
+			T* w, T*, T*, const std::size_t n)
+		{
+			simd::axpy(step.rate * a, x, w, n);
+			return;
+		}
+	};
+
+	struct momentum_policy
+	{
+		template <typename T>
+		static inline void update(const basic_step<T>& step, const T a, const T* x,
+			T* w, T* m, T*, const std::size_t n)
+		{
+			for (std::size_t j = 0; j < n; ++j)
+			{
+				m[j] = step.momentum * m[j] + a * x[j];
+				w[j] += step.rate * m[j];
+			}
+
+			return;
+		}
+	};
+
+	struct nesterov_policy
+	{
+		template <typename T>
+		static inline void update(const basic_step<T>& step, const T a, const T* x,
+			T* w, T* m, T*, const std::size_t n)
+		{
+			for (std::size_t j = 0; j < n; ++j)
+			{
+				const auto d = a * x[j];
+				m[j] = step.momentum * m[j] + d;
+				w[j] += step.rate * (step.momentum * m[j] + d);
+			}
+
+			return;
+		}
+	};
+
+	struct rmsprop_policy
+	{
+		template <typename T>
+		static inline void update(const basic_step<T>& step, const T a, const T* x,
+			T* w, T*, T* v, const std::size_t n)
+		{
+			for (std::size_t j = 0; j < n; ++j)
+			{
+				const auto d = a * x[j];
+				v[j] = step.decay * v[j] + (T(1) - step.decay) * d * d;
+				w[j] += step.rate * d / (std::sqrt(v[j]) + step.epsilon);
+			}
+
+			return;
+		}
+	};
+
+	struct adam_policy
+	{
+		template <typename T>
+		static inline void update(const basic_step<T>& step, const T a, const T* x,
+			T* w, T* m, T* v, const std::size_t n)
+		{
+			for (std::size_t j = 0; j < n; ++j)
+			{
+				const auto d = a * x[j];
+				m[j] = step.beta1 * m[j] + (T(1) - step.beta1) * d;
+				v[j] = step.beta2 * v[j] + (T(1) - step.beta2) * d * d;
+				w[j] += step.rate * m[j] / (std::sqrt(v[j]) + step.epsilon);
+			}
+
+			return;
+		}
+	};
+
+	/********************************************************************************
+	* dispatch: Anropar angivet funktionsobjekt med policyklassen för angiven
+	*           metod, dvs. function(adam_policy()) och så vidare.
+	*
+	*           - method  : Metod för uppdatering av parametrarna.
+	*           - function: Funktionsobjekt med en mall för operator().
+	********************************************************************************/
+	template <typename Function>
+	static inline void dispatch(const type method, Function&& function)
+	{
+		switch (method)
+		{
+		case type::momentum: function(momentum_policy()); break;
+		case type::nesterov: function(nesterov_policy()); break;
+		case type::rmsprop: function(rmsprop_policy()); break;
+		case type::adam: function(adam_policy()); break;
+		default: function(sgd_policy()); break;
+		}
+
+		return;
+	}
+}
+
+#endif /* OPTIMIZER_HPP_ */
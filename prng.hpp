@@ -0,0 +1,236 @@
+#ifndef PRNG_HPP_
+#define PRNG_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+
+/********************************************************************************
+* prng: Snabb och seedbar slumptalsgenerator samt metoder för initiering av
+*       vikter. Till skillnad från std::rand har varje generator ett eget
+*       tillstånd, så att ett nätverk ger samma startvärden och samma
+*       träningsordning för ett givet frö oavsett vad andra nätverk eller
+*       trådar gör. Trådar som behöver egna slumptal tar var sin oberoende
+*       följd via split.
+********************************************************************************/
+namespace prng
+{
+	/********************************************************************************
+	* generator: xoshiro256** (Blackman och Vigna). Tillståndet är fyra 64-bitars
+	*            ord och perioden 2^256 - 1. Varje tal kostar ett fåtal
+	*            skift, rotationer och en multiplikation, utan lås eller
+	*            globalt tillstånd. Klassen uppfyller kraven på en
+	*            UniformRandomBitGenerator och kan därmed även användas med
+	*            fördelningarna i <random>.
+	********************************************************************************/
+	class generator
+	{
+	public:
+		typedef std::uint64_t result_type;
+
+		static constexpr std::uint64_t default_seed = 0x853c49e6748fea9bULL;
+
+		generator(void)
+		{
+			this->seed(default_seed);
+			return;
+		}
+
+		explicit generator(const std::uint64_t value)
+		{
+			this->seed(value);
+			return;
+		}
+
+		static constexpr result_type min(void) { return 0; }
+		static constexpr result_type max(void) { return ~static_cast<result_type>(0); }
+
+		/********************************************************************************
+		* seed: Sätter tillståndet utifrån angivet frö. Fröet sprids över de fyra
+		*       orden via splitmix64, så att även små eller närliggande frön ger
+		*       välblandade och helt olika följder.
+		*
+		*       - value: Fröet.
+		********************************************************************************/
+		void seed(std::uint64_t value)
+		{
+			for (auto& word : this->state)
+			{
+				value += 0x9e3779b97f4a7c15ULL;
+				auto z = value;
+				z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+				z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+				word = z ^ (z >> 31);
+			}
+
+			return;
+		}
+
+		inline result_type operator()(void)
+		{
+			const auto result = rotate(this->state[1] * 5, 7) * 9;
+			const auto t = this->state[1] << 17;
+
+			this->state[2] ^= this->state[0];
+			this->state[3] ^= this->state[1];
+			this->state[1] ^= this->state[2];
+			this->state[0] ^= this->state[3];
+			this->state[2] ^= t;
+			this->state[3] = rotate(this->state[3], 45);
+			return result;
+		}
+
+		/********************************************************************************
+		* uniform: Returnerar ett flyttal i intervallet [0, 1) med 53 bitars
+		*          upplösning, dvs. samtliga värden som en double kan anta med
+		*          jämna steg.
+		********************************************************************************/
+		inline double uniform(void)
+		{
+			return static_cast<double>((*this)() >> 11) * (1.0 / 9007199254740992.0);
+		}
+
+		/********************************************************************************
+		* uniform: Returnerar ett flyttal i intervallet [low, high).
+		********************************************************************************/
+		inline double uniform(const double low, const double high)
+		{
+			return low + (high - low) * this->uniform();
+		}
+
+		/********************************************************************************
+		* below: Returnerar ett heltal i intervallet [0, bound) där samtliga värden
+		*        är lika sannolika. Multiplikationsmetoden (Lemire) undviker
+		*        divisionen i rand() % bound, och de fåtal utfall som skulle ge
+		*        en skev fördelning förkastas och dras om.
+		*
+		*        - bound: Övre gräns (exklusive), större än noll.
+		********************************************************************************/
+		std::uint32_t below(const std::uint32_t bound)
+		{
+			auto product = static_cast<std::uint64_t>(static_cast<std::uint32_t>((*this)() >> 32)) * bound;
+			auto low = static_cast<std::uint32_t>(product);
+
+			if (low < bound)
+			{
+				const auto threshold = static_cast<std::uint32_t>(0u - bound) % bound;
+
+				while (low < threshold)
+				{
+					product = static_cast<std::uint64_t>(static_cast<std::uint32_t>((*this)() >> 32)) * bound;
+					low = static_cast<std::uint32_t>(product);
+				}
+			}
+
+			return static_cast<std::uint32_t>(product >> 32);
+		}
+
+		/********************************************************************************
+		* split: Returnerar en kopia av generatorn och flyttar därefter denna
+		*        generator 2^128 steg framåt i följden, så att de två följderna
+		*        aldrig överlappar i praktiken. Anropas en gång per tråd för att
+		*        ge varje tråd en egen reproducerbar följd.
+		********************************************************************************/
+		generator split(void)
+		{
+			const auto other = *this;
+			this->jump();
+			return other;
+		}
+
+	private:
+		std::uint64_t state[4];
+
+		static inline std::uint64_t rotate(const std::uint64_t x, const int k)
+		{
+			return (x << k) | (x >> (64 - k));
+		}
+
+		/* Motsvarar 2^128 anrop av operator(), se xoshiro256**-referensen: */
+		void jump(void)
+		{
+			static const std::uint64_t polynomial[] =
+			{
+				0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+				0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+			};
+
+			std::uint64_t result[4] = { 0, 0, 0, 0 };
+
+			for (const auto word : polynomial)
+			{
+				for (int bit = 0; bit < 64; ++bit)
+				{
+					if (word & (static_cast<std::uint64_t>(1) << bit))
+					{
+						for (int i = 0; i < 4; ++i) result[i] ^= this->state[i];
+					}
+
+					(*this)();
+				}
+			}
+
+			for (int i = 0; i < 4; ++i) this->state[i] = result[i];
+			return;
+		}
+	};
+
+	/********************************************************************************
+	* shuffle: Blandar angivna element med Fisher-Yates, där varje permutation
+	*          är lika sannolik. Varje tråd kan blanda sin egen del av data med
+	*          en egen generator.
+	*
+	*          - data     : Pekare till första elementet.
+	*          - n        : Antalet element (högst 2^32).
+	*          - rng      : Generatorn som används.
+	********************************************************************************/
+	template <typename T>
+	static inline void shuffle(T* data, const std::size_t n, generator& rng)
+	{
+		for (std::size_t i = n; i > 1; --i)
+		{
+			const auto j = rng.below(static_cast<std::uint32_t>(i));
+			const auto copy = data[i - 1];
+			data[i - 1] = data[j];
+			data[j] = copy;
+		}
+
+		return;
+	}
+
+	/********************************************************************************
+	* init_scheme: Anger fördelning för startvärdena i ett dense-lager med
+	*              fan_in insignaler och fan_out noder.
+	*
+	*              - uniform  : Vikter och bias i [-1, 1] (ursprunglig metod).
+	*              - xavier   : Vikter i [-a, a] där a = sqrt(6 / (fan_in + fan_out)),
+	*                           bias noll. Håller variansen konstant genom lager
+	*                           med tanh, sigmoid eller linjär aktivering.
+	*              - he       : Vikter i [-a, a] där a = sqrt(6 / fan_in), bias
+	*                           noll. Kompenserar för att ReLU nollställer
+	*                           hälften av utsignalerna.
+	*              - automatic: he för lager med ReLU, annars xavier.
+	********************************************************************************/
+	enum class init_scheme { uniform, xavier, he, automatic };
+
+	/********************************************************************************
+	* init_limit: Returnerar gränsen a för vikterna enligt angiven metod, där
+	*             automatic redan ska vara ersatt med xavier eller he.
+	********************************************************************************/
+	static inline double init_limit(const init_scheme scheme, const std::size_t fan_in, const std::size_t fan_out)
+	{
+		if (scheme == init_scheme::xavier && fan_in + fan_out > 0)
+		{
+			return std::sqrt(6.0 / static_cast<double>(fan_in + fan_out));
+		}
+		else if (scheme == init_scheme::he && fan_in > 0)
+		{
+			return std::sqrt(6.0 / static_cast<double>(fan_in));
+		}
+
+		return 1.0;
+	}
+}
+
+#endif /* PRNG_HPP_ */
@@ -0,0 +1,584 @@
+#ifndef PROFILING_HPP_
+#define PROFILING_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <ostream>
+#include <fstream>
+
+/********************************************************************************
+* NEU_NETWORK_PROFILING: Sätts till 1 (exempelvis -DNEU_NETWORK_PROFILING=1 eller
+*                        via CMake-alternativet med samma namn) för att mäta
+*                        var tiden går i träningen och i styrloopen. Default
+*                        är 0, varvid samtliga mätpunkter nedan är tomma
+*                        inline-funktioner och tomma objekt som kompilatorn
+*                        tar bort helt.
+********************************************************************************/
+#ifndef NEU_NETWORK_PROFILING
+#define NEU_NETWORK_PROFILING 0
+#endif
+
+#if NEU_NETWORK_PROFILING
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define PROFILING_TSC 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#else
+#define PROFILING_TSC 0
+#if defined(__unix__) || defined(__APPLE__)
+#include <time.h>
+#endif
+#endif
+#endif
+
+/********************************************************************************
+* profiling: Mätpunkter för träningen och prediktionen, som ger:
+*
+*            - Tid och antal anrop per lager för feedforward (forward),
+*              backpropagering (backprop) och viktuppdatering (optimize).
+*            - Antalet tränade uppsättningar per sekund.
+*            - Felet och tiden för de senaste epokerna.
+*            - Antalet minnesallokeringar via aligned_allocator, dvs. samtliga
+*              matriser, vektorer och arenor i nätverket.
+*            - Fördelningen av prediktionstiden (p50, p99 och max) i
+*              styrloopen, se get_multi_output i main.cpp.
+*
+*            Tidsstämplarna tas med räknaren rdtsc på x86, som kostar ett
+*            tiotal cykler, och annars med clock_gettime(CLOCK_MONOTONIC).
+*            Räknarvärdena omvandlas till tid först vid utskrift, där
+*            räknarens frekvens uppskattas mot std::chrono::steady_clock
+*            sedan första mätningen. Räknarna är atomiska, så att mätningar
+*            kan ske från flera trådar samtidigt.
+********************************************************************************/
+namespace profiling
+{
+	typedef std::uint64_t ticks;
+
+	enum class phase { forward, backprop, optimize };
+
+	/* Lager med högre index summeras i det sista: */
+	static constexpr std::size_t max_layers = 16;
+	static constexpr std::size_t num_phases = 3;
+
+	static inline const char* phase_name(const phase value)
+	{
+		return value == phase::forward ? "forward" : value == phase::backprop ? "backprop" : "optimize";
+	}
+
+#if NEU_NETWORK_PROFILING
+	static constexpr bool enabled = true;
+
+	/********************************************************************************
+	* now: Returnerar aktuell tidsstämpel i räknarens enhet.
+	********************************************************************************/
+	static inline ticks now(void)
+	{
+#if PROFILING_TSC
+		return __rdtsc();
+#elif defined(__unix__) || defined(__APPLE__)
+		timespec time;
+		clock_gettime(CLOCK_MONOTONIC, &time);
+		return static_cast<ticks>(time.tv_sec) * 1000000000u + static_cast<ticks>(time.tv_nsec);
+#else
+		return static_cast<ticks>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+	}
+
+	/********************************************************************************
+	* counter: Antalet anrop och den summerade tiden för en mätpunkt.
+	********************************************************************************/
+	struct counter
+	{
+		std::atomic<std::uint64_t> calls{ 0 };
+		std::atomic<ticks> elapsed{ 0 };
+
+		inline void add(const ticks duration)
+		{
+			this->calls.fetch_add(1, std::memory_order_relaxed);
+			this->elapsed.fetch_add(duration, std::memory_order_relaxed);
+		}
+	};
+
+	/********************************************************************************
+	* histogram: Log-linjärt histogram över tider, där varje tvåpotens delas i
+	*            åtta lika breda fack. Ett värde registreras med ett fåtal
+	*            skift och ett atomiskt tillägg, utan minnesallokeringar, och
+	*            percentilerna har ett relativt fel på högst 1/16.
+	********************************************************************************/
+	class histogram
+	{
+	public:
+		static constexpr std::size_t sub_bits = 3;
+		static constexpr std::size_t sub_buckets = 1 << sub_bits;
+		static constexpr std::size_t num_buckets = (64 - sub_bits + 1) * sub_buckets;
+
+		inline void add(const ticks value)
+		{
+			this->buckets[bucket(value)].fetch_add(1, std::memory_order_relaxed);
+			auto current = this->largest.load(std::memory_order_relaxed);
+
+			while (value > current && !this->largest.compare_exchange_weak(current, value, std::memory_order_relaxed)) { }
+		}
+
+		std::uint64_t count(void) const
+		{
+			std::uint64_t sum = 0;
+			for (const auto& bucket : this->buckets) sum += bucket.load(std::memory_order_relaxed);
+			return sum;
+		}
+
+		inline ticks max(void) const { return this->largest.load(std::memory_order_relaxed); }
+
+		/********************************************************************************
+		* percentile: Returnerar värdet som andelen q av mätningarna understiger,
+		*             som mitten av motsvarande fack, eller 0 om histogrammet
+		*             är tomt.
+		*
+		*             - q: Andelen, exempelvis 0.5 för medianen.
+		********************************************************************************/
+		double percentile(const double q) const
+		{
+			const auto total = this->count();
+			if (total == 0) return 0.0;
+
+			const auto rank = static_cast<std::uint64_t>(q * static_cast<double>(total - 1)) + 1;
+			std::uint64_t sum = 0;
+
+			for (std::size_t i = 0; i < num_buckets; ++i)
+			{
+				sum += this->buckets[i].load(std::memory_order_relaxed);
+				if (sum >= rank) return lower_bound(i) + 0.5 * static_cast<double>(width(i));
+			}
+
+			return static_cast<double>(this->max());
+		}
+
+		void reset(void)
+		{
+			for (auto& bucket : this->buckets) bucket.store(0, std::memory_order_relaxed);
+			this->largest.store(0, std::memory_order_relaxed);
+			return;
+		}
+
+	private:
+		std::atomic<std::uint64_t> buckets[num_buckets] = {};
+		std::atomic<ticks> largest{ 0 };
+
+		static inline std::size_t bucket(const ticks value)
+		{
+			if (value < sub_buckets) return static_cast<std::size_t>(value);
+			const auto exponent = highest_bit(value);
+			const auto sub = static_cast<std::size_t>(value >> (exponent - sub_bits)) & (sub_buckets - 1);
+			return (exponent - sub_bits + 1) * sub_buckets + sub;
+		}
+
+		static inline ticks width(const std::size_t index)
+		{
+			return index < sub_buckets ? 1 : static_cast<ticks>(1) << (index / sub_buckets - 1);
+		}
+
+		static inline double lower_bound(const std::size_t index)
+		{
+			if (index < sub_buckets) return static_cast<double>(index);
+			return static_cast<double>((sub_buckets + index % sub_buckets) * width(index));
+		}
+
+		static inline std::size_t highest_bit(ticks value)
+		{
+			std::size_t bit = 0;
+
+			for (std::size_t shift = 32; shift > 0; shift /= 2)
+			{
+				if (value >> shift)
+				{
+					value >>= shift;
+					bit += shift;
+				}
+			}
+
+			return bit;
+		}
+	};
+
+	/********************************************************************************
+	* epoch_record: Felet och tiden för en epok.
+	********************************************************************************/
+	struct epoch_record
+	{
+		std::size_t epoch;
+		double loss;
+		ticks elapsed;
+	};
+
+	/********************************************************************************
+	* registry: Samtliga mätvärden. En gemensam instans nås via instance().
+	********************************************************************************/
+	struct registry
+	{
+		static constexpr std::size_t max_epochs = 256;
+
+		counter layers[max_layers][num_phases];
+		std::atomic<std::uint64_t> samples{ 0 };
+		std::atomic<std::uint64_t> epochs{ 0 };
+		std::atomic<ticks> training_time{ 0 };
+		std::atomic<std::uint64_t> allocations{ 0 };
+		std::atomic<std::uint64_t> allocated_bytes{ 0 };
+		histogram predict;
+
+		std::mutex mutex;
+		std::vector<epoch_record> recent_epochs;
+		std::size_t next_epoch = 0;
+
+		ticks origin_ticks = now();
+		std::chrono::steady_clock::time_point origin_time = std::chrono::steady_clock::now();
+
+		/********************************************************************************
+		* ticks_per_second: Returnerar räknarens frekvens. För rdtsc uppskattas den
+		*                   utifrån tiden sedan första mätningen, som förlängs
+		*                   till minst 10 ms vid behov.
+		********************************************************************************/
+		double ticks_per_second(void) const
+		{
+#if PROFILING_TSC
+			auto time = std::chrono::steady_clock::now();
+			while (time - this->origin_time < std::chrono::milliseconds(10)) time = std::chrono::steady_clock::now();
+			const auto count = now() - this->origin_ticks;
+			return static_cast<double>(count) / std::chrono::duration<double>(time - this->origin_time).count();
+#else
+			return 1e9;
+#endif
+		}
+	};
+
+	static inline registry& instance(void)
+	{
+		static registry values;
+		return values;
+	}
+
+	/********************************************************************************
+	* layer_scope: Mäter tiden från skapandet till destrueringen och lägger den
+	*              till angiven fas och angivet lager (0 = första dolda lagret).
+	********************************************************************************/
+	class layer_scope
+	{
+	public:
+		inline layer_scope(const phase type, const std::size_t layer)
+			: target(instance().layers[layer < max_layers ? layer : max_layers - 1][static_cast<std::size_t>(type)]),
+			start(now()) { }
+
+		inline ~layer_scope(void) { this->target.add(now() - this->start); }
+
+		layer_scope(const layer_scope&) = delete;
+		layer_scope& operator=(const layer_scope&) = delete;
+
+	private:
+		counter& target;
+		ticks start;
+	};
+
+	/********************************************************************************
+	* predict_scope: Mäter tiden från skapandet till destrueringen och lägger
+	*                den till histogrammet för prediktionstiden.
+	********************************************************************************/
+	class predict_scope
+	{
+	public:
+		inline predict_scope(void) : start(now()) { }
+		inline ~predict_scope(void) { instance().predict.add(now() - this->start); }
+
+		predict_scope(const predict_scope&) = delete;
+		predict_scope& operator=(const predict_scope&) = delete;
+
+	private:
+		ticks start;
+	};
+
+	/********************************************************************************
+	* epoch_timer: Mäter tiden mellan varje anrop av lap, dvs. tiden per epok,
+	*              räknat från skapandet. Används av training::monitor.
+	********************************************************************************/
+	class epoch_timer
+	{
+	public:
+		inline epoch_timer(void) : start(now()) { }
+
+		void lap(const std::size_t epoch, const double loss)
+		{
+			const auto time = now();
+			const auto elapsed = time - this->start;
+			auto& values = instance();
+			this->start = time;
+
+			values.epochs.fetch_add(1, std::memory_order_relaxed);
+			values.training_time.fetch_add(elapsed, std::memory_order_relaxed);
+
+			std::lock_guard<std::mutex> lock(values.mutex);
+			const epoch_record record{ epoch, loss, elapsed };
+
+			if (values.recent_epochs.size() < registry::max_epochs)
+			{
+				values.recent_epochs.push_back(record);
+			}
+			else
+			{
+				values.recent_epochs[values.next_epoch] = record;
+			}
+
+			values.next_epoch = (values.next_epoch + 1) % registry::max_epochs;
+			return;
+		}
+
+	private:
+		ticks start;
+	};
+
+	static inline void add_samples(const std::size_t n)
+	{
+		instance().samples.fetch_add(n, std::memory_order_relaxed);
+	}
+
+	static inline void add_allocation(const std::size_t num_bytes)
+	{
+		auto& values = instance();
+		values.allocations.fetch_add(1, std::memory_order_relaxed);
+		values.allocated_bytes.fetch_add(num_bytes, std::memory_order_relaxed);
+	}
+
+	/********************************************************************************
+	* reset: Nollställer samtliga mätvärden, exempelvis efter uppstarten så att
+	*        enbart styrloopen mäts.
+	********************************************************************************/
+	static inline void reset(void)
+	{
+		auto& values = instance();
+
+		for (auto& layer : values.layers)
+		{
+			for (auto& value : layer)
+			{
+				value.calls.store(0, std::memory_order_relaxed);
+				value.elapsed.store(0, std::memory_order_relaxed);
+			}
+		}
+
+		values.samples.store(0, std::memory_order_relaxed);
+		values.epochs.store(0, std::memory_order_relaxed);
+		values.training_time.store(0, std::memory_order_relaxed);
+		values.allocations.store(0, std::memory_order_relaxed);
+		values.allocated_bytes.store(0, std::memory_order_relaxed);
+		values.predict.reset();
+
+		std::lock_guard<std::mutex> lock(values.mutex);
+		values.recent_epochs.clear();
+		values.next_epoch = 0;
+		return;
+	}
+
+	/********************************************************************************
+	* for_each_layer: Anropar function(layer, phase, calls, seconds) för varje
+	*                 lager och fas som har mätts.
+	********************************************************************************/
+	template <typename Function>
+	static void for_each_layer(const double seconds_per_tick, Function&& function)
+	{
+		auto& values = instance();
+
+		for (std::size_t i = 0; i < max_layers; ++i)
+		{
+			for (std::size_t j = 0; j < num_phases; ++j)
+			{
+				const auto calls = values.layers[i][j].calls.load(std::memory_order_relaxed);
+				if (calls == 0) continue;
+
+				const auto elapsed = values.layers[i][j].elapsed.load(std::memory_order_relaxed);
+				function(i, static_cast<phase>(j), calls, static_cast<double>(elapsed) * seconds_per_tick);
+			}
+		}
+	}
+
+	/* Epokerna i ordning, äldst först: */
+	static std::vector<epoch_record> recent_epochs(void)
+	{
+		auto& values = instance();
+		std::lock_guard<std::mutex> lock(values.mutex);
+		std::vector<epoch_record> records;
+
+		for (std::size_t i = 0; i < values.recent_epochs.size(); ++i)
+		{
+			const auto index = values.recent_epochs.size() < registry::max_epochs ? i : (values.next_epoch + i) % registry::max_epochs;
+			records.push_back(values.recent_epochs[index]);
+		}
+
+		return records;
+	}
+
+	/********************************************************************************
+	* print: Skriver ut mätvärdena som en tabell.
+	*
+	*        - ostream: Referens till godtycklig utström.
+	********************************************************************************/
+	static void print(std::ostream& ostream)
+	{
+		auto& values = instance();
+		const auto seconds_per_tick = 1.0 / values.ticks_per_second();
+		const auto training_s = static_cast<double>(values.training_time.load(std::memory_order_relaxed)) * seconds_per_tick;
+		const auto samples = values.samples.load(std::memory_order_relaxed);
+		const auto flags = ostream.flags();
+		const auto precision = ostream.precision();
+
+		ostream << std::fixed << std::setprecision(1);
+		ostream << "-----------------------------------------------------------------\n";
+		ostream << " Layer  Phase        Calls     Total ms    ns/call\n";
+
+		for_each_layer(seconds_per_tick, [&](const std::size_t layer, const phase type, const std::uint64_t calls, const double seconds)
+		{
+			ostream << " " << std::setw(5) << layer << "  " << std::left << std::setw(8) << phase_name(type) << std::right
+				<< std::setw(13) << calls << std::setw(13) << seconds * 1e3
+				<< std::setw(11) << seconds * 1e9 / static_cast<double>(calls) << "\n";
+		});
+
+		ostream << " Epochs: " << values.epochs.load(std::memory_order_relaxed)
+			<< ", samples: " << samples
+			<< ", samples/s: " << (training_s > 0.0 ? static_cast<double>(samples) / training_s : 0.0) << "\n";
+
+		const auto epochs = recent_epochs();
+
+		if (!epochs.empty())
+		{
+			const auto& last = epochs.back();
+			ostream << " Last epoch: " << last.epoch << ", " << static_cast<double>(last.elapsed) * seconds_per_tick * 1e6 << " us, loss: ";
+			ostream.unsetf(std::ios::floatfield);
+			ostream << std::setprecision(6) << last.loss << std::fixed << std::setprecision(1) << "\n";
+		}
+
+		ostream << " Allocations: " << values.allocations.load(std::memory_order_relaxed)
+			<< " (" << values.allocated_bytes.load(std::memory_order_relaxed) << " bytes)\n";
+		ostream << " Predict: " << values.predict.count()
+			<< " calls, p50: " << values.predict.percentile(0.5) * seconds_per_tick * 1e9
+			<< " ns, p99: " << values.predict.percentile(0.99) * seconds_per_tick * 1e9
+			<< " ns, max: " << static_cast<double>(values.predict.max()) * seconds_per_tick * 1e9 << " ns\n";
+		ostream << "-----------------------------------------------------------------\n";
+
+		ostream.flags(flags);
+		ostream.precision(precision);
+		return;
+	}
+
+	/********************************************************************************
+	* write_json: Skriver mätvärdena som JSON, med tider i nanosekunder.
+	*
+	*             - ostream: Referens till godtycklig utström.
+	********************************************************************************/
+	static void write_json(std::ostream& ostream)
+	{
+		auto& values = instance();
+		const auto seconds_per_tick = 1.0 / values.ticks_per_second();
+		const auto training_s = static_cast<double>(values.training_time.load(std::memory_order_relaxed)) * seconds_per_tick;
+		const auto samples = values.samples.load(std::memory_order_relaxed);
+		const char* separator = "\n";
+
+		ostream << "{\n  \"enabled\": true,\n  \"layers\": [";
+
+		for_each_layer(seconds_per_tick, [&](const std::size_t layer, const phase type, const std::uint64_t calls, const double seconds)
+		{
+			ostream << separator << "    { \"layer\": " << layer
+				<< ", \"phase\": \"" << phase_name(type) << "\""
+				<< ", \"calls\": " << calls
+				<< ", \"total_ns\": " << seconds * 1e9
+				<< ", \"ns_per_call\": " << seconds * 1e9 / static_cast<double>(calls) << " }";
+			separator = ",\n";
+		});
+
+		ostream << "\n  ],\n";
+		ostream << "  \"epochs\": " << values.epochs.load(std::memory_order_relaxed) << ",\n";
+		ostream << "  \"samples\": " << samples << ",\n";
+		ostream << "  \"samples_per_second\": " << (training_s > 0.0 ? static_cast<double>(samples) / training_s : 0.0) << ",\n";
+		ostream << "  \"recent_epochs\": [";
+		separator = "\n";
+
+		for (const auto& record : recent_epochs())
+		{
+			ostream << separator << "    { \"epoch\": " << record.epoch
+				<< ", \"loss\": " << record.loss
+				<< ", \"ns\": " << static_cast<double>(record.elapsed) * seconds_per_tick * 1e9 << " }";
+			separator = ",\n";
+		}
+
+		ostream << "\n  ],\n";
+		ostream << "  \"allocations\": " << values.allocations.load(std::memory_order_relaxed) << ",\n";
+		ostream << "  \"allocated_bytes\": " << values.allocated_bytes.load(std::memory_order_relaxed) << ",\n";
+		ostream << "  \"predict\": { \"calls\": " << values.predict.count()
+			<< ", \"p50_ns\": " << values.predict.percentile(0.5) * seconds_per_tick * 1e9
+			<< ", \"p99_ns\": " << values.predict.percentile(0.99) * seconds_per_tick * 1e9
+			<< ", \"max_ns\": " << static_cast<double>(values.predict.max()) * seconds_per_tick * 1e9 << " }\n}\n";
+		return;
+	}
+#else
+	static constexpr bool enabled = false;
+
+	/* Tomma mätpunkter, som inte genererar någon kod: */
+	static inline ticks now(void) { return 0; }
+
+	class layer_scope
+	{
+	public:
+		inline layer_scope(const phase, const std::size_t) { }
+	};
+
+	class predict_scope
+	{
+	public:
+		inline predict_scope(void) { }
+	};
+
+	class epoch_timer
+	{
+	public:
+		inline void lap(const std::size_t, const double) { }
+	};
+
+	static inline void add_samples(const std::size_t) { }
+	static inline void add_allocation(const std::size_t) { }
+	static inline void reset(void) { }
+
+	static inline void print(std::ostream& ostream)
+	{
+		ostream << " Profiling is disabled, compile with NEU_NETWORK_PROFILING=1\n";
+	}
+
+	static inline void write_json(std::ostream& ostream)
+	{
+		ostream << "{\n  \"enabled\": false\n}\n";
+	}
+#endif
+
+	/********************************************************************************
+	* write_json: Sparar mätvärdena som JSON till angiven fil. Returnerar false
+	*             om filen inte kunde skrivas.
+	*
+	*             - path: Sökväg till filen.
+	********************************************************************************/
+	static inline bool write_json(const std::string& path)
+	{
+		std::ofstream file(path);
+		if (!file) return false;
+
+		write_json(static_cast<std::ostream&>(file));
+		return static_cast<bool>(file);
+	}
+}
+
+#endif /* PROFILING_HPP_ */
@@ -0,0 +1,264 @@
+#ifndef QUANTIZED_ANN_HPP_
+#define QUANTIZED_ANN_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+
+#include "ann.hpp"
+
+/********************************************************************************
+* quantized_ann: Kvantiserad kopia av ett tränat nätverk för prediktion utan
+*                flyttal, avsedd för små målsystem. Vikterna lagras som int8
+*                med en skalfaktor per nod och summeras i int32. Aktiveringar
+*                lagras som int8 med en gemensam skala för samtliga lager,
+*                1/127, dvs. 127 motsvarar 1.0. En skalfaktor per nod i stället
+*                för per lager behövs eftersom enskilda noder i ett tränat
+*                lager ofta har tio gånger större vikter än övriga, vilket
+*                annars gör de små vikterna mycket grova.
+*
+*                Varje nods summa (bias + vikter * indata) skalas om till ett
+*                index i en tabell med förberäknade tanh-värden via en
+*                heltalsmultiplikation och ett skift, så att prediktionen enbart
+*                använder heltalsaritmetik. Flyttal används enbart vid
+*                kvantiseringen av nätverket.
+*
+*                Samtliga parametrar lagras i fasta vektorer i objektet, vilket
+*                gör att ingen dynamisk minnesallokering sker. Objektet kan
+*                därmed placeras statiskt. Prediktionens mellanresultat lagras
+*                på stacken (2 * max_nodes byte).
+********************************************************************************/
+class quantized_ann
+{
+public:
+	static constexpr std::size_t max_layers = 8;
+	static constexpr std::size_t max_nodes = 64;
+	static constexpr std::size_t max_weights = 4096;
+	static constexpr std::size_t max_biases = max_layers * max_nodes;
+	static constexpr std::size_t lut_size = 1024;
+	static constexpr int activation_scale = 127;
+	static constexpr double lut_range = 4.0;
+
+	quantized_ann(void) { }
+
+	inline std::size_t num_layers(void) const { return this->layer_count; }
+	inline std::size_t num_inputs(void) const { return this->layer_count ? this->layers[0].num_weights : 0; }
+	inline std::size_t num_outputs(void) const { return this->layer_count ? this->layers[this->layer_count - 1].num_nodes : 0; }
+	inline bool empty(void) const { return this->layer_count == 0; }
+
+	/********************************************************************************
+	* quantize: Kvantiserar angivet tränat nätverk. Varje nods vikter skalas
+	*           så att det största absolutvärdet motsvarar 127, medan nodens
+	*           bias lagras i summans skala (viktskala * aktiveringsskala).
+	*           Returnerar false, och lämnar objektet tomt, om nätverket inte
+	*           ryms i de fasta buffertarna, om något lager har en annan
+	*           aktiveringsfunktion än tanh, eftersom tabellen enbart
+	*           innehåller tanh-värden, eller om någon nods bias eller
+	*           skalfaktor inte kan representeras i heltal, exempelvis när
+	*           biasen är mycket stor jämfört med nodens vikter. Summan av
+	*           bias och vikter * indata ryms därmed alltid i int32.
+	*
+	*           - network: Referens till nätverket som ska kvantiseras.
+	********************************************************************************/
+	template <typename T>
+	bool quantize(const basic_ann<T>& network)
+	{
+		const auto& hidden_layers = network.get_hidden_layers();
+		const auto num_layers = hidden_layers.size() + 1;
+		std::size_t weight_offset = 0;
+		std::size_t bias_offset = 0;
+
+		this->layer_count = 0;
+		if (hidden_layers.empty() || num_layers > max_layers) return false;
+
+		for (std::size_t l = 0; l < num_layers; ++l)
+		{
+			const auto& layer = l < hidden_layers.size() ? hidden_layers[l] : network.get_output_layer();
+			auto& record = this->layers[l];
+
+			if (layer.activation_type != activation::type::tanh ||
+				layer.num_nodes() > max_nodes || layer.num_weights() > max_nodes ||
+				weight_offset + layer.num_nodes() * layer.num_weights() > max_weights)
+			{
+				return false;
+			}
+
+			record.num_nodes = layer.num_nodes();
+			record.num_weights = layer.num_weights();
+			record.weight_offset = weight_offset;
+			record.bias_offset = bias_offset;
+
+			for (std::size_t i = 0; i < layer.num_nodes(); ++i)
+			{
+				const auto w = layer.weights.row(i);
+				auto q = this->weights + weight_offset + i * record.num_weights;
+				double max_weight = 0.0;
+
+				for (std::size_t j = 0; j < layer.num_weights(); ++j)
+				{
+					if (std::fabs(static_cast<double>(w[j])) > max_weight) max_weight = std::fabs(static_cast<double>(w[j]));
+				}
+
+				const auto weight_scale = max_weight > 0.0 ? max_weight / 127.0 : 1.0;
+				const auto sum_scale = weight_scale / activation_scale;
+				const auto bias = std::round(static_cast<double>(layer.bias[i]) / sum_scale);
+				const auto max_bias = static_cast<double>(INT32_MAX) - 127.0 * activation_scale * layer.num_weights();
+
+				if (!(std::fabs(bias) <= max_bias) ||
+					!this->set_multiplier(bias_offset + i, sum_scale * lut_size / (2.0 * lut_range)))
+				{
+					return false;
+				}
+
+				for (std::size_t j = 0; j < layer.num_weights(); ++j)
+				{
+					q[j] = static_cast<std::int8_t>(std::lround(static_cast<double>(w[j]) / weight_scale));
+				}
+
+				this->biases[bias_offset + i] = static_cast<std::int32_t>(bias);
+			}
+
+			weight_offset += record.num_nodes * record.num_weights;
+			bias_offset += record.num_nodes;
+		}
+
+		/* Tabellens index i motsvarar summan (i - lut_size / 2) * steg, där
+		   steget är 2 * lut_range / lut_size: */
+		for (std::size_t i = 0; i < lut_size; ++i)
+		{
+			const auto x = (static_cast<double>(i) - lut_size / 2.0) * 2.0 * lut_range / lut_size;
+			this->tanh_lut[i] = static_cast<std::int8_t>(std::lround(std::tanh(x) * activation_scale));
+		}
+
+		this->layer_count = num_layers;
+		return true;
+	}
+
+	/********************************************************************************
+	* predict: Genomför prediktion med enbart heltalsaritmetik. Indata och
+	*          utdata anges i aktiveringsskalan, dvs. 127 motsvarar 1.0.
+	*
+	*          - input : Pekare till num_inputs() kvantiserade insignaler.
+	*          - output: Pekare till buffert för num_outputs() utsignaler.
+	********************************************************************************/
+	void predict(const std::int8_t* input, std::int8_t* output) const
+	{
+		std::int8_t buffers[2][max_nodes];
+		const std::int8_t* x = input;
+
+		for (std::size_t l = 0; l < this->layer_count; ++l)
+		{
+			const auto& record = this->layers[l];
+			const auto y = l + 1 < this->layer_count ? buffers[l % 2] : output;
+
+			for (std::size_t i = 0; i < record.num_nodes; ++i)
+			{
+				const auto w = this->weights + record.weight_offset + i * record.num_weights;
+				std::int32_t sum = this->biases[record.bias_offset + i];
+
+				for (std::size_t j = 0; j < record.num_weights; ++j)
+				{
+					sum += static_cast<std::int32_t>(w[j]) * x[j];
+				}
+
+				y[i] = this->activate(record.bias_offset + i, sum);
+			}
+
+			x = y;
+		}
+
+		return;
+	}
+
+	/********************************************************************************
+	* quantize_value: Omvandlar ett flyttal i intervallet [-1, 1] till
+	*                 aktiveringsskalan. Värden utanför intervallet mättas.
+	*
+	*                 - value: Värdet som ska omvandlas.
+	********************************************************************************/
+	static inline std::int8_t quantize_value(const double value)
+	{
+		const auto q = std::lround(value * activation_scale);
+		return static_cast<std::int8_t>(q > activation_scale ? activation_scale : (q < -activation_scale ? -activation_scale : q));
+	}
+
+	/********************************************************************************
+	* dequantize_value: Omvandlar ett värde i aktiveringsskalan till ett flyttal.
+	*
+	*                   - value: Värdet som ska omvandlas.
+	********************************************************************************/
+	static inline double dequantize_value(const std::int8_t value)
+	{
+		return static_cast<double>(value) / activation_scale;
+	}
+
+private:
+	struct layer_record
+	{
+		std::size_t num_nodes = 0;
+		std::size_t num_weights = 0;
+		std::size_t weight_offset = 0;
+		std::size_t bias_offset = 0;
+	};
+
+	layer_record layers[max_layers];
+	std::int8_t weights[max_weights] = {};
+	std::int32_t biases[max_biases] = {};
+	std::int32_t multipliers[max_biases] = {};
+	std::int8_t shifts[max_biases] = {};
+	std::int8_t tanh_lut[lut_size] = {};
+	std::size_t layer_count = 0;
+
+	/********************************************************************************
+	* set_multiplier: Uttrycker angiven nods skalfaktor som multiplier / 2^shift,
+	*                 där multiplier ryms i 31 bitar. Produkten av en int32-summa
+	*                 och multiplikatorn ryms därmed alltid i 64 bitar. Returnerar
+	*                 false om faktorn inte är positiv och ändlig eller är minst
+	*                 2^30, eftersom skiftet då skulle bli 0, vilket activate
+	*                 inte hanterar.
+	*
+	*                 - node : Nodens index bland samtliga lagers noder.
+	*                 - scale: Faktorn som summan ska multipliceras med.
+	********************************************************************************/
+	bool set_multiplier(const std::size_t node, const double scale)
+	{
+		int shift = 0;
+		auto multiplier = scale;
+
+		if (!(scale > 0.0 && scale < 1073741824.0)) return false;
+
+		while (multiplier < 1073741824.0 && shift < 62)
+		{
+			multiplier *= 2.0;
+			++shift;
+		}
+
+		/* Multiplikatorn ligger i [2^30, 2^31) och avrundas nedåt om den annars
+		   skulle avrundas upp till 2^31, som inte ryms i int32: */
+		const auto rounded = std::llround(multiplier);
+		this->multipliers[node] = static_cast<std::int32_t>(rounded > INT32_MAX ? INT32_MAX : rounded);
+		this->shifts[node] = static_cast<std::int8_t>(shift);
+		return true;
+	}
+
+	/********************************************************************************
+	* activate: Skalar om angiven nods summa till ett tabellindex med avrundning
+	*           och returnerar motsvarande tanh-värde. Summor utanför tabellens
+	*           intervall mättas till tabellens ändpunkter. Skiftet är minst 1,
+	*           se set_multiplier.
+	********************************************************************************/
+	inline std::int8_t activate(const std::size_t node, const std::int32_t sum) const
+	{
+		const auto shift = this->shifts[node];
+		const auto rounding = static_cast<std::int64_t>(1) << (shift - 1);
+		auto index = ((static_cast<std::int64_t>(sum) * this->multipliers[node] + rounding) >> shift) +
+			static_cast<std::int64_t>(lut_size / 2);
+
+		if (index < 0) index = 0;
+		if (index >= static_cast<std::int64_t>(lut_size)) index = lut_size - 1;
+		return this->tanh_lut[index];
+	}
+};
+
+#endif /* QUANTIZED_ANN_HPP_ */
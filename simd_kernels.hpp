@@ -0,0 +1,1043 @@
+#ifndef SIMD_KERNELS_HPP_
+#define SIMD_KERNELS_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <cstddef>
+
+#include "matrix.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define SIMD_X86 0
+#endif
+
+/* Kompilatorattribut som tillåter AVX-instruktioner i enskilda funktioner
+   utan att hela programmet kompileras för AVX. MSVC kräver inga attribut. */
+#if SIMD_X86 && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define SIMD_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#else
+#define SIMD_TARGET_AVX2
+#define SIMD_TARGET_AVX512
+#endif
+
+/********************************************************************************
+* simd: Vektoriserade beräkningskärnor för dense-lagren, för både double och
+*       float. Vilken implementering som används väljs en gång per elementtyp
+*       vid körning utifrån processorns stöd: AVX-512, AVX2 + FMA, SSE2 eller
+*       ren skalär kod. Med float ryms dubbelt så många element per register
+*       och cache-rad, vilket ungefär halverar minnesbandbredden per element.
+*
+*       - dot   : Skalärprodukt sum(x[i] * y[i]).
+*       - axpy  : y[i] += alpha * x[i].
+*       - dot4  : Fyra skalärprodukter mot samma vektor y.
+*       - axpy4 : y[i] += summan av alpha[k] * x[k][i] för k = 0..3.
+*       - tanh  : x[i] = tanh(x[i]) via rationell approximation.
+*       - gemv_t: y = A^T * x, där A lagras radvis.
+********************************************************************************/
+namespace simd
+{
+	enum class isa { scalar, sse2, avx2, avx512 };
+
+	template <typename T>
+	struct basic_kernel_table
+	{
+		typedef T (*dot_function)(const T* x, const T* y, std::size_t n);
+		typedef void (*axpy_function)(T alpha, const T* x, T* y, std::size_t n);
+		typedef void (*dot4_function)(const T* const* x, const T* y, std::size_t n, T* result);
+		typedef void (*axpy4_function)(const T* alpha, const T* const* x, T* y, std::size_t n);
+		typedef void (*tanh_function)(T* x, std::size_t n);
+
+		isa level;
+		dot_function dot;
+		axpy_function axpy;
+		dot4_function dot4;
+		axpy4_function axpy4;
+		tanh_function tanh;
+	};
+
+	typedef basic_kernel_table<double> kernel_table;
+
+	namespace detail
+	{
+		/* Gör att elementtypen enbart härleds från pekarna och inte från
+		   skalära argument, så att exempelvis axpy(1.0, x, y, n) fungerar
+		   även när x och y pekar på float. */
+		template <typename T>
+		struct identity
+		{
+			typedef T type;
+		};
+
+		template <typename T>
+		static inline T dot_scalar(const T* x, const T* y, const std::size_t n)
+		{
+			T sum = 0;
+
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				sum += x[i] * y[i];
+			}
+
+			return sum;
+		}
+
+		template <typename T>
+		static inline void axpy_scalar(const T alpha, const T* x, T* y, const std::size_t n)
+		{
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				y[i] += alpha * x[i];
+			}
+
+			return;
+		}
+
+		template <typename T>
+		static inline void dot4_scalar(const T* const* x, const T* y, const std::size_t n, T* result)
+		{
+			for (std::size_t k = 0; k < 4; ++k)
+			{
+				result[k] = dot_scalar(x[k], y, n);
+			}
+
+			return;
+		}
+
+		template <typename T>
+		static inline void axpy4_scalar(const T* alpha, const T* const* x, T* y, const std::size_t n)
+		{
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				y[i] += alpha[0] * x[0][i] + alpha[1] * x[1][i] + alpha[2] * x[2][i] + alpha[3] * x[3][i];
+			}
+
+			return;
+		}
+
+		/* Koefficienter för en rationell approximation av tanh av grad 13/6,
+		   tanh(x) = x * P(x^2) / Q(x^2), med högsta gradtalet först. Utanför
+		   [-tanh_limit, tanh_limit] avrundas tanh till +/- 1 med float-precision. */
+		static const double tanh_limit = 7.90531110763549805;
+		static const double tanh_numerator[7] = { -2.76076847742355e-16, 2.00018790482477e-13, -8.60467152213735e-11,
+			5.12229709037114e-08, 1.48572235717979e-05, 6.37261928875436e-04, 4.89352455891786e-03 };
+		static const double tanh_denominator[4] = { 1.19825839466702e-06, 1.18534705686654e-04,
+			2.26843463243900e-03, 4.89352518554385e-03 };
+
+		template <typename T>
+		static inline T tanh_rational(const T x)
+		{
+			const T limit = static_cast<T>(tanh_limit);
+			const T clamped = x < -limit ? -limit : (x > limit ? limit : x);
+			const T x2 = clamped * clamped;
+			T p = static_cast<T>(tanh_numerator[0]);
+			T q = static_cast<T>(tanh_denominator[0]);
+
+			for (std::size_t k = 1; k < 7; ++k) p = p * x2 + static_cast<T>(tanh_numerator[k]);
+			for (std::size_t k = 1; k < 4; ++k) q = q * x2 + static_cast<T>(tanh_denominator[k]);
+			return clamped * p / q;
+		}
+
+		template <typename T>
+		static inline void tanh_scalar(T* x, const std::size_t n)
+		{
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				x[i] = tanh_rational(x[i]);
+			}
+
+			return;
+		}
+
+#if SIMD_X86
+		static inline double dot_sse2(const double* x, const double* y, const std::size_t n)
+		{
+			auto s0 = _mm_setzero_pd();
+			auto s1 = _mm_setzero_pd();
+			std::size_t i = 0;
+
+			for (; i + 4 <= n; i += 4)
+			{
+				s0 = _mm_add_pd(s0, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+				s1 = _mm_add_pd(s1, _mm_mul_pd(_mm_loadu_pd(x + i + 2), _mm_loadu_pd(y + i + 2)));
+			}
+
+			s0 = _mm_add_pd(s0, s1);
+			double lanes[2];
+			_mm_storeu_pd(lanes, s0);
+			auto sum = lanes[0] + lanes[1];
+
+			for (; i < n; ++i) sum += x[i] * y[i];
+			return sum;
+		}
+
+		static inline void axpy_sse2(const double alpha, const double* x, double* y, const std::size_t n)
+		{
+			const auto a = _mm_set1_pd(alpha);
+			std::size_t i = 0;
+
+			for (; i + 2 <= n; i += 2)
+			{
+				_mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_mul_pd(a, _mm_loadu_pd(x + i))));
+			}
+
+			for (; i < n; ++i) y[i] += alpha * x[i];
+			return;
+		}
+
+		SIMD_TARGET_AVX2 static inline double dot_avx2(const double* x, const double* y, const std::size_t n)
+		{
+			auto s0 = _mm256_setzero_pd();
+			auto s1 = _mm256_setzero_pd();
+			auto s2 = _mm256_setzero_pd();
+			auto s3 = _mm256_setzero_pd();
+			std::size_t i = 0;
+
+			for (; i + 16 <= n; i += 16)
+			{
+				s0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), s0);
+				s1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), s1);
+				s2 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 8), _mm256_loadu_pd(y + i + 8), s2);
+				s3 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 12), _mm256_loadu_pd(y + i + 12), s3);
+			}
+
+			for (; i + 4 <= n; i += 4)
+			{
+				s0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), s0);
+			}
+
+			s0 = _mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3));
+			const auto half = _mm_add_pd(_mm256_castpd256_pd128(s0), _mm256_extractf128_pd(s0, 1));
+			double lanes[2];
+			_mm_storeu_pd(lanes, half);
+			auto sum = lanes[0] + lanes[1];
+
+			for (; i < n; ++i) sum += x[i] * y[i];
+			return sum;
+		}
+
+		SIMD_TARGET_AVX2 static inline void axpy_avx2(const double alpha, const double* x, double* y, const std::size_t n)
+		{
+			const auto a = _mm256_set1_pd(alpha);
+			std::size_t i = 0;
+
+			for (; i + 8 <= n; i += 8)
+			{
+				_mm256_storeu_pd(y + i, _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+				_mm256_storeu_pd(y + i + 4, _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4)));
+			}
+
+			for (; i + 4 <= n; i += 4)
+			{
+				_mm256_storeu_pd(y + i, _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+			}
+
+			for (; i < n; ++i) y[i] += alpha * x[i];
+			return;
+		}
+
+		SIMD_TARGET_AVX2 static inline void dot4_avx2(const double* const* x, const double* y, const std::size_t n, double* result)
+		{
+			auto s0 = _mm256_setzero_pd();
+			auto s1 = _mm256_setzero_pd();
+			auto s2 = _mm256_setzero_pd();
+			auto s3 = _mm256_setzero_pd();
+			std::size_t i = 0;
+
+			for (; i + 4 <= n; i += 4)
+			{
+				const auto v = _mm256_loadu_pd(y + i);
+				s0 = _mm256_fmadd_pd(_mm256_loadu_pd(x[0] + i), v, s0);
+				s1 = _mm256_fmadd_pd(_mm256_loadu_pd(x[1] + i), v, s1);
+				s2 = _mm256_fmadd_pd(_mm256_loadu_pd(x[2] + i), v, s2);
+				s3 = _mm256_fmadd_pd(_mm256_loadu_pd(x[3] + i), v, s3);
+			}
+
+			/* Horisontell summering av samtliga fyra ackumulatorer på en gång: */
+			const auto h01 = _mm256_hadd_pd(s0, s1);
+			const auto h23 = _mm256_hadd_pd(s2, s3);
+			const auto lo = _mm256_permute2f128_pd(h01, h23, 0x20);
+			const auto hi = _mm256_permute2f128_pd(h01, h23, 0x31);
+			_mm256_storeu_pd(result, _mm256_add_pd(lo, hi));
+
+			for (; i < n; ++i)
+			{
+				for (std::size_t k = 0; k < 4; ++k) result[k] += x[k][i] * y[i];
+			}
+
+			return;
+		}
+
+		SIMD_TARGET_AVX2 static inline void axpy4_avx2(const double* alpha, const double* const* x, double* y, const std::size_t n)
+		{
+			const auto a0 = _mm256_set1_pd(alpha[0]);
+			const auto a1 = _mm256_set1_pd(alpha[1]);
+			const auto a2 = _mm256_set1_pd(alpha[2]);
+			const auto a3 = _mm256_set1_pd(alpha[3]);
+			std::size_t i = 0;
+
+			for (; i + 4 <= n; i += 4)
+			{
+				auto v = _mm256_loadu_pd(y + i);
+				v = _mm256_fmadd_pd(a0, _mm256_loadu_pd(x[0] + i), v);
+				v = _mm256_fmadd_pd(a1, _mm256_loadu_pd(x[1] + i), v);
+				v = _mm256_fmadd_pd(a2, _mm256_loadu_pd(x[2] + i), v);
+				v = _mm256_fmadd_pd(a3, _mm256_loadu_pd(x[3] + i), v);
+				_mm256_storeu_pd(y + i, v);
+			}
+
+			for (; i < n; ++i)
+			{
+				y[i] += alpha[0] * x[0][i] + alpha[1] * x[1][i] + alpha[2] * x[2][i] + alpha[3] * x[3][i];
+			}
+
+			return;
+		}
+
+		SIMD_TARGET_AVX512 static inline double dot_avx512(const double* x, const double* y, const std::size_t n)
+		{
+			auto s0 = _mm512_setzero_pd();
+			auto s1 = _mm512_setzero_pd();
+			std::size_t i = 0;
+
+			for (; i + 16 <= n; i += 16)
+			{
+				s0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), s0);
+				s1 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 8), _mm512_loadu_pd(y + i + 8), s1);
+			}
+
+			if (i < n)
+			{
+				const auto mask = static_cast<__mmask8>(n - i >= 8 ? 0xFF : (1u << (n - i)) - 1);
+				s0 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i), s0);
+				i += n - i >= 8 ? 8 : n - i;
+			}
+
+			double lanes[8];
+			_mm512_storeu_pd(lanes, _mm512_add_pd(s0, s1));
+			auto sum = ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) + ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7]));
+			for (; i < n; ++i) sum += x[i] * y[i];
+			return sum;
+		}
+
+		SIMD_TARGET_AVX512 static inline void axpy_avx512(const double alpha, const double* x, double* y, const std::size_t n)
+		{
+			const auto a = _mm512_set1_pd(alpha);
+			std::size_t i = 0;
+
+			for (; i + 8 <= n; i += 8)
+			{
+				_mm512_storeu_pd(y + i, _mm512_fmadd_pd(a, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+			}
+
+			if (i < n)
+			{
+				const auto mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+				const auto r = _mm512_fmadd_pd(a, _mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i));
+				_mm512_mask_storeu_pd(y + i, mask, r);
+			}
+
+			return;
+		}
+
+		SIMD_TARGET_AVX512 static inline void dot4_avx512(const double* const* x, const double* y, const std::size_t n, double* result)
+		{
+			auto s0 = _mm512_setzero_pd();
+			auto s1 = _mm512_setzero_pd();
+			auto s2 = _mm512_setzero_pd();
+			auto s3 = _mm512_setzero_pd();
+
+			for (std::size_t i = 0; i < n; i += 8)
+			{
+				const auto mask = static_cast<__mmask8>(n - i >= 8 ? 0xFF : (1u << (n - i)) - 1);
+				const auto v = _mm512_maskz_loadu_pd(mask, y + i);
+				s0 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, x[0] + i), v, s0);
+				s1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, x[1] + i), v, s1);
+				s2 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, x[2] + i), v, s2);
+				s3 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, x[3] + i), v, s3);
+			}
+
+			const __m512d sums[4] = { s0, s1, s2, s3 };
+
+			for (std::size_t k = 0; k < 4; ++k)
+			{
+				double lanes[8];
+				_mm512_storeu_pd(lanes, sums[k]);
+				result[k] = ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) + ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7]));
+			}
+
+			return;
+		}
+
+		SIMD_TARGET_AVX512 static inline void axpy4_avx512(const double* alpha, const double* const* x, double* y, const std::size_t n)
+		{
+			const auto a0 = _mm512_set1_pd(alpha[0]);
+			const auto a1 = _mm512_set1_pd(alpha[1]);
+			const auto a2 = _mm512_set1_pd(alpha[2]);
+			const auto a3 = _mm512_set1_pd(alpha[3]);
+
+			for (std::size_t i = 0; i < n; i += 8)
+			{
+				const auto mask = static_cast<__mmask8>(n - i >= 8 ? 0xFF : (1u << (n - i)) - 1);
+				auto v = _mm512_maskz_loadu_pd(mask, y + i);
+				v = _mm512_fmadd_pd(a0, _mm512_maskz_loadu_pd(mask, x[0] + i), v);
+				v = _mm512_fmadd_pd(a1, _mm512_maskz_loadu_pd(mask, x[1] + i), v);
+				v = _mm512_fmadd_pd(a2, _mm512_maskz_loadu_pd(mask, x[2] + i), v);
+				v = _mm512_fmadd_pd(a3, _mm512_maskz_loadu_pd(mask, x[3] + i), v);
+				_mm512_mask_storeu_pd(y + i, mask, v);
+			}
+
+			return;
+		}
+
+		static inline float dot_sse2(const float* x, const float* y, const std::size_t n)
+		{
+			auto s0 = _mm_setzero_ps();
+			auto s1 = _mm_setzero_ps();
+			std::size_t i = 0;
+
+			for (; i + 8 <= n; i += 8)
+			{
+				s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i)));
+				s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(x + i + 4), _mm_loadu_ps(y + i + 4)));
+			}
+
+			float lanes[4];
+			_mm_storeu_ps(lanes, _mm_add_ps(s0, s1));
+			auto sum = (lanes[0] + lanes[2]) + (lanes[1] + lanes[3]);
+
+			for (; i < n; ++i) sum += x[i] * y[i];
+			return sum;
+		}
+
+		static inline void axpy_sse2(const float alpha, const float* x, float* y, const std::size_t n)
+		{
+			const auto a = _mm_set1_ps(alpha);
+			std::size_t i = 0;
+
+			for (; i + 4 <= n; i += 4)
+			{
+				_mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(a, _mm_loadu_ps(x + i))));
+			}
+
+			for (; i < n; ++i) y[i] += alpha * x[i];
+			return;
+		}
+
+		SIMD_TARGET_AVX2 static inline float dot_avx2(const float* x, const float* y, const std::size_t n)
+		{
+			auto s0 = _mm256_setzero_ps();
+			auto s1 = _mm256_setzero_ps();
+			auto s2 = _mm256_setzero_ps();
+			auto s3 = _mm256_setzero_ps();
+			std::size_t i = 0;
+
+			for (; i + 32 <= n; i += 32)
+			{
+				s0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), s0);
+				s1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8), s1);
+				s2 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 16), _mm256_loadu_ps(y + i + 16), s2);
+				s3 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 24), _mm256_loadu_ps(y + i + 24), s3);
+			}
+
+			for (; i + 8 <= n; i += 8)
+			{
+				s0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), s0);
+			}
+
+			s0 = _mm256_add_ps(_mm256_add_ps(s0, s1), _mm256_add_ps(s2, s3));
+			const auto half = _mm_add_ps(_mm256_castps256_ps128(s0), _mm256_extractf128_ps(s0, 1));
+			float lanes[4];
+			_mm_storeu_ps(lanes, half);
+			auto sum = (lanes[0] + lanes[2]) + (lanes[1] + lanes[3]);
+
+			for (; i < n; ++i) sum += x[i] * y[i];
+			return sum;
+		}
+
+		SIMD_TARGET_AVX2 static inline void axpy_avx2(const float alpha, const float* x, float* y, const std::size_t n)
+		{
+			const auto a = _mm256_set1_ps(alpha);
+			std::size_t i = 0;
+
+			for (; i + 16 <= n; i += 16)
+			{
+				_mm256_storeu_ps(y + i, _mm256_fmadd_ps(a, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+				_mm256_storeu_ps(y + i + 8, _mm256_fmadd_ps(a, _mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8)));
+			}
+
+			for (; i + 8 <= n; i += 8)
+			{
+				_mm256_storeu_ps(y + i, _mm256_fmadd_ps(a, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+			}
+
+			for (; i < n; ++i) y[i] += alpha * x[i];
+			return;
+		}
+
+		SIMD_TARGET_AVX2 static inline void dot4_avx2(const float* const* x, const float* y, const std::size_t n, float* result)
+		{
+			auto s0 = _mm256_setzero_ps();
+			auto s1 = _mm256_setzero_ps();
+			auto s2 = _mm256_setzero_ps();
+			auto s3 = _mm256_setzero_ps();
+			std::size_t i = 0;
+
+			for (; i + 8 <= n; i += 8)
+			{
+				const auto v = _mm256_loadu_ps(y + i);
+				s0 = _mm256_fmadd_ps(_mm256_loadu_ps(x[0] + i), v, s0);
+				s1 = _mm256_fmadd_ps(_mm256_loadu_ps(x[1] + i), v, s1);
+				s2 = _mm256_fmadd_ps(_mm256_loadu_ps(x[2] + i), v, s2);
+				s3 = _mm256_fmadd_ps(_mm256_loadu_ps(x[3] + i), v, s3);
+			}
+
+			/* Två steg av horisontell addition ger samtliga fyra summor per
+			   128-bitarshalva, varefter halvorna adderas: */
+			const auto h01 = _mm256_hadd_ps(s0, s1);
+			const auto h23 = _mm256_hadd_ps(s2, s3);
+			const auto h = _mm256_hadd_ps(h01, h23);
+			_mm_storeu_ps(result, _mm_add_ps(_mm256_castps256_ps128(h), _mm256_extractf128_ps(h, 1)));
+
+			for (; i < n; ++i)
+			{
+				for (std::size_t k = 0; k < 4; ++k) result[k] += x[k][i] * y[i];
+			}
+
+			return;
+		}
+
+		SIMD_TARGET_AVX2 static inline void axpy4_avx2(const float* alpha, const float* const* x, float* y, const std::size_t n)
+		{
+			const auto a0 = _mm256_set1_ps(alpha[0]);
+			const auto a1 = _mm256_set1_ps(alpha[1]);
+			const auto a2 = _mm256_set1_ps(alpha[2]);
+			const auto a3 = _mm256_set1_ps(alpha[3]);
+			std::size_t i = 0;
+
+			for (; i + 8 <= n; i += 8)
+			{
+				auto v = _mm256_loadu_ps(y + i);
+				v = _mm256_fmadd_ps(a0, _mm256_loadu_ps(x[0] + i), v);
+				v = _mm256_fmadd_ps(a1, _mm256_loadu_ps(x[1] + i), v);
+				v = _mm256_fmadd_ps(a2, _mm256_loadu_ps(x[2] + i), v);
+				v = _mm256_fmadd_ps(a3, _mm256_loadu_ps(x[3] + i), v);
+				_mm256_storeu_ps(y + i, v);
+			}
+
+			for (; i < n; ++i)
+			{
+				y[i] += alpha[0] * x[0][i] + alpha[1] * x[1][i] + alpha[2] * x[2][i] + alpha[3] * x[3][i];
+			}
+
+			return;
+		}
+
+		SIMD_TARGET_AVX512 static inline float sum_lanes_avx512(const __m512 v)
+		{
+			float lanes[16];
+			_mm512_storeu_ps(lanes, v);
+
+			for (std::size_t width = 8; width > 0; width /= 2)
+			{
+				for (std::size_t j = 0; j < width; ++j) lanes[j] += lanes[j + width];
+			}
+
+			return lanes[0];
+		}
+
+		SIMD_TARGET_AVX512 static inline __mmask16 tail_mask16(const std::size_t remaining)
+		{
+			return static_cast<__mmask16>(remaining >= 16 ? 0xFFFF : (1u << remaining) - 1);
+		}
+
+		SIMD_TARGET_AVX512 static inline float dot_avx512(const float* x, const float* y, const std::size_t n)
+		{
+			auto s0 = _mm512_setzero_ps();
+			auto s1 = _mm512_setzero_ps();
+			std::size_t i = 0;
+
+			for (; i + 32 <= n; i += 32)
+			{
+				s0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), s0);
+				s1 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 16), _mm512_loadu_ps(y + i + 16), s1);
+			}
+
+			for (; i < n; i += 16)
+			{
+				const auto mask = tail_mask16(n - i);
+				s0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i), s0);
+			}
+
+			return sum_lanes_avx512(_mm512_add_ps(s0, s1));
+		}
+
+		SIMD_TARGET_AVX512 static inline void axpy_avx512(const float alpha, const float* x, float* y, const std::size_t n)
+		{
+			const auto a = _mm512_set1_ps(alpha);
+
+			for (std::size_t i = 0; i < n; i += 16)
+			{
+				const auto mask = tail_mask16(n - i);
+				const auto r = _mm512_fmadd_ps(a, _mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i));
+				_mm512_mask_storeu_ps(y + i, mask, r);
+			}
+
+			return;
+		}
+
+		SIMD_TARGET_AVX512 static inline void dot4_avx512(const float* const* x, const float* y, const std::size_t n, float* result)
+		{
+			auto s0 = _mm512_setzero_ps();
+			auto s1 = _mm512_setzero_ps();
+			auto s2 = _mm512_setzero_ps();
+			auto s3 = _mm512_setzero_ps();
+
+			for (std::size_t i = 0; i < n; i += 16)
+			{
+				const auto mask = tail_mask16(n - i);
+				const auto v = _mm512_maskz_loadu_ps(mask, y + i);
+				s0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x[0] + i), v, s0);
+				s1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x[1] + i), v, s1);
+				s2 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x[2] + i), v, s2);
+				s3 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x[3] + i), v, s3);
+			}
+
+			result[0] = sum_lanes_avx512(s0);
+			result[1] = sum_lanes_avx512(s1);
+			result[2] = sum_lanes_avx512(s2);
+			result[3] = sum_lanes_avx512(s3);
+			return;
+		}
+
+		SIMD_TARGET_AVX512 static inline void axpy4_avx512(const float* alpha, const float* const* x, float* y, const std::size_t n)
+		{
+			const auto a0 = _mm512_set1_ps(alpha[0]);
+			const auto a1 = _mm512_set1_ps(alpha[1]);
+			const auto a2 = _mm512_set1_ps(alpha[2]);
+			const auto a3 = _mm512_set1_ps(alpha[3]);
+
+			for (std::size_t i = 0; i < n; i += 16)
+			{
+				const auto mask = tail_mask16(n - i);
+				auto v = _mm512_maskz_loadu_ps(mask, y + i);
+				v = _mm512_fmadd_ps(a0, _mm512_maskz_loadu_ps(mask, x[0] + i), v);
+				v = _mm512_fmadd_ps(a1, _mm512_maskz_loadu_ps(mask, x[1] + i), v);
+				v = _mm512_fmadd_ps(a2, _mm512_maskz_loadu_ps(mask, x[2] + i), v);
+				v = _mm512_fmadd_ps(a3, _mm512_maskz_loadu_ps(mask, x[3] + i), v);
+				_mm512_mask_storeu_ps(y + i, mask, v);
+			}
+
+			return;
+		}
+
+		SIMD_TARGET_AVX2 static inline void tanh_avx2(double* x, const std::size_t n)
+		{
+			const auto upper = _mm256_set1_pd(tanh_limit);
+			const auto lower = _mm256_set1_pd(-tanh_limit);
+			std::size_t i = 0;
+
+			for (; i + 4 <= n; i += 4)
+			{
+				const auto v = _mm256_max_pd(lower, _mm256_min_pd(_mm256_loadu_pd(x + i), upper));
+				const auto v2 = _mm256_mul_pd(v, v);
+				auto p = _mm256_set1_pd(tanh_numerator[0]);
+				auto q = _mm256_set1_pd(tanh_denominator[0]);
+
+				for (std::size_t k = 1; k < 7; ++k) p = _mm256_fmadd_pd(p, v2, _mm256_set1_pd(tanh_numerator[k]));
+				for (std::size_t k = 1; k < 4; ++k) q = _mm256_fmadd_pd(q, v2, _mm256_set1_pd(tanh_denominator[k]));
+				_mm256_storeu_pd(x + i, _mm256_div_pd(_mm256_mul_pd(v, p), q));
+			}
+
+			for (; i < n; ++i) x[i] = tanh_rational(x[i]);
+			return;
+		}
+
+		SIMD_TARGET_AVX2 static inline void tanh_avx2(float* x, const std::size_t n)
+		{
+			const auto upper = _mm256_set1_ps(static_cast<float>(tanh_limit));
+			const auto lower = _mm256_set1_ps(static_cast<float>(-tanh_limit));
+			std::size_t i = 0;
+
+			for (; i + 8 <= n; i += 8)
+			{
+				const auto v = _mm256_max_ps(lower, _mm256_min_ps(_mm256_loadu_ps(x + i), upper));
+				const auto v2 = _mm256_mul_ps(v, v);
+				auto p = _mm256_set1_ps(static_cast<float>(tanh_numerator[0]));
+				auto q = _mm256_set1_ps(static_cast<float>(tanh_denominator[0]));
+
+				for (std::size_t k = 1; k < 7; ++k) p = _mm256_fmadd_ps(p, v2, _mm256_set1_ps(static_cast<float>(tanh_numerator[k])));
+				for (std::size_t k = 1; k < 4; ++k) q = _mm256_fmadd_ps(q, v2, _mm256_set1_ps(static_cast<float>(tanh_denominator[k])));
+				_mm256_storeu_ps(x + i, _mm256_div_ps(_mm256_mul_ps(v, p), q));
+			}
+
+			for (; i < n; ++i) x[i] = tanh_rational(x[i]);
+			return;
+		}
+
+		SIMD_TARGET_AVX512 static inline void tanh_avx512(double* x, const std::size_t n)
+		{
+			const auto upper = _mm512_set1_pd(tanh_limit);
+			const auto lower = _mm512_set1_pd(-tanh_limit);
+
+			for (std::size_t i = 0; i < n; i += 8)
+			{
+				const auto mask = static_cast<__mmask8>(n - i >= 8 ? 0xFF : (1u << (n - i)) - 1);
+				const auto v = _mm512_maskz_max_pd(0xFF, lower, _mm512_maskz_min_pd(0xFF, _mm512_maskz_loadu_pd(mask, x + i), upper));
+				const auto v2 = _mm512_mul_pd(v, v);
+				auto p = _mm512_set1_pd(tanh_numerator[0]);
+				auto q = _mm512_set1_pd(tanh_denominator[0]);
+
+				for (std::size_t k = 1; k < 7; ++k) p = _mm512_fmadd_pd(p, v2, _mm512_set1_pd(tanh_numerator[k]));
+				for (std::size_t k = 1; k < 4; ++k) q = _mm512_fmadd_pd(q, v2, _mm512_set1_pd(tanh_denominator[k]));
+				_mm512_mask_storeu_pd(x + i, mask, _mm512_div_pd(_mm512_mul_pd(v, p), q));
+			}
+
+			return;
+		}
+
+		SIMD_TARGET_AVX512 static inline void tanh_avx512(float* x, const std::size_t n)
+		{
+			const auto upper = _mm512_set1_ps(static_cast<float>(tanh_limit));
+			const auto lower = _mm512_set1_ps(static_cast<float>(-tanh_limit));
+
+			for (std::size_t i = 0; i < n; i += 16)
+			{
+				const auto mask = tail_mask16(n - i);
+				const auto v = _mm512_maskz_max_ps(0xFFFF, lower, _mm512_maskz_min_ps(0xFFFF, _mm512_maskz_loadu_ps(mask, x + i), upper));
+				const auto v2 = _mm512_mul_ps(v, v);
+				auto p = _mm512_set1_ps(static_cast<float>(tanh_numerator[0]));
+				auto q = _mm512_set1_ps(static_cast<float>(tanh_denominator[0]));
+
+				for (std::size_t k = 1; k < 7; ++k) p = _mm512_fmadd_ps(p, v2, _mm512_set1_ps(static_cast<float>(tanh_numerator[k])));
+				for (std::size_t k = 1; k < 4; ++k) q = _mm512_fmadd_ps(q, v2, _mm512_set1_ps(static_cast<float>(tanh_denominator[k])));
+				_mm512_mask_storeu_ps(x + i, mask, _mm512_div_ps(_mm512_mul_ps(v, p), q));
+			}
+
+			return;
+		}
+
+		/********************************************************************************
+		* cpu_supports: Kontrollerar via CPUID ifall processorn och operativsystemet
+		*               stöder angiven instruktionsnivå.
+		********************************************************************************/
+		static inline bool cpu_supports(const isa level)
+		{
+#if defined(_MSC_VER)
+			int regs[4];
+			__cpuid(regs, 0);
+			const auto max_leaf = regs[0];
+			__cpuid(regs, 1);
+			const auto has_fma = (regs[2] & (1 << 12)) != 0;
+			const auto has_osxsave = (regs[2] & (1 << 27)) != 0;
+			if (level == isa::sse2) return (regs[3] & (1 << 26)) != 0;
+			if (!has_osxsave || max_leaf < 7) return false;
+
+			const auto xcr0 = _xgetbv(0);
+			__cpuidex(regs, 7, 0);
+
+			if (level == isa::avx2)
+			{
+				return has_fma && (xcr0 & 0x6) == 0x6 && (regs[1] & (1 << 5)) != 0;
+			}
+
+			if (level == isa::avx512)
+			{
+				return has_fma && (xcr0 & 0xE6) == 0xE6 && (regs[1] & (1 << 16)) != 0;
+			}
+
+			return level == isa::scalar;
+#else
+			__builtin_cpu_init();
+			if (level == isa::sse2) return __builtin_cpu_supports("sse2");
+			if (level == isa::avx2) return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+			if (level == isa::avx512) return __builtin_cpu_supports("avx512f");
+			return level == isa::scalar;
+#endif
+		}
+#else
+		static inline bool cpu_supports(const isa level)
+		{
+			return level == isa::scalar;
+		}
+#endif
+	}
+
+	/********************************************************************************
+	* kernels_for: Returnerar beräkningskärnorna för angiven instruktionsnivå och
+	*              elementtyp (double eller float). Om processorn saknar stöd
+	*              för nivån returneras skalära kärnor.
+	*
+	*              - level: Önskad instruktionsnivå.
+	********************************************************************************/
+	template <typename T = double>
+	static inline basic_kernel_table<T> kernels_for(const isa level)
+	{
+#if SIMD_X86
+		if (detail::cpu_supports(level))
+		{
+			switch (level)
+			{
+			case isa::avx512: return basic_kernel_table<T>{ isa::avx512, detail::dot_avx512, detail::axpy_avx512, detail::dot4_avx512, detail::axpy4_avx512, detail::tanh_avx512 };
+			case isa::avx2: return basic_kernel_table<T>{ isa::avx2, detail::dot_avx2, detail::axpy_avx2, detail::dot4_avx2, detail::axpy4_avx2, detail::tanh_avx2 };
+			case isa::sse2: return basic_kernel_table<T>{ isa::sse2, detail::dot_sse2, detail::axpy_sse2, detail::dot4_scalar<T>, detail::axpy4_scalar<T>, detail::tanh_scalar<T> };
+			default: break;
+			}
+		}
+#endif
+		return basic_kernel_table<T>{ isa::scalar, detail::dot_scalar<T>, detail::axpy_scalar<T>, detail::dot4_scalar<T>, detail::axpy4_scalar<T>, detail::tanh_scalar<T> };
+	}
+
+	/********************************************************************************
+	* kernels: Returnerar de snabbaste kärnorna som processorn stöder för angiven
+	*          elementtyp. Valet görs vid första anropet och återanvänds därefter.
+	********************************************************************************/
+	template <typename T = double>
+	static inline const basic_kernel_table<T>& kernels(void)
+	{
+		static const basic_kernel_table<T> table = []()
+		{
+			const isa levels[] = { isa::avx512, isa::avx2, isa::sse2 };
+
+			for (auto level : levels)
+			{
+				if (detail::cpu_supports(level)) return kernels_for<T>(level);
+			}
+
+			return kernels_for<T>(isa::scalar);
+		}();
+
+		return table;
+	}
+
+	/* Vektorer kortare än short_length beräknas direkt på plats, eftersom ett
+	   indirekt anrop då kostar mer än själva beräkningen. */
+	static constexpr std::size_t short_length = 8;
+
+	template <typename T>
+	static inline T dot(const T* x, const T* y, const std::size_t n)
+	{
+		if (n < short_length) return detail::dot_scalar(x, y, n);
+		return kernels<T>().dot(x, y, n);
+	}
+
+	template <typename T>
+	static inline void axpy(const typename detail::identity<T>::type alpha, const T* x, T* y, const std::size_t n)
+	{
+		if (n < short_length) return detail::axpy_scalar<T>(alpha, x, y, n);
+		kernels<T>().axpy(alpha, x, y, n);
+		return;
+	}
+
+	template <typename T>
+	static inline void dot4(const T* const* x, const T* y, const std::size_t n, T* result)
+	{
+		if (n < short_length) return detail::dot4_scalar(x, y, n, result);
+		kernels<T>().dot4(x, y, n, result);
+		return;
+	}
+
+	template <typename T>
+	static inline void axpy4(const T* alpha, const T* const* x, T* y, const std::size_t n)
+	{
+		if (n < short_length) return detail::axpy4_scalar(alpha, x, y, n);
+		kernels<T>().axpy4(alpha, x, y, n);
+		return;
+	}
+
+	template <typename T>
+	static inline void tanh(T* x, const std::size_t n)
+	{
+		if (n < short_length) return detail::tanh_scalar(x, n);
+		kernels<T>().tanh(x, n);
+		return;
+	}
+
+	/********************************************************************************
+	* gemv_t: Beräknar y = A^T * x, där A har a.rows rader och a.cols kolumner.
+	*         Matrisen läses rad för rad och varje rad adderas till y med axpy,
+	*         vilket ger sekventiell minnesåtkomst trots transponatet.
+	*
+	*         - a: Vy över matrisen A.
+	*         - x: Vektor med a.rows element.
+	*         - y: Vektor med a.cols element som skrivs över med resultatet.
+	********************************************************************************/
+	template <typename T>
+	static inline void gemv_t(const basic_const_matrix_view<T>& a, const T* x, T* y)
+	{
+		for (std::size_t i = 0; i < a.cols; ++i)
+		{
+			y[i] = T(0);
+		}
+
+		for (std::size_t j = 0; j < a.rows; ++j)
+		{
+			axpy(x[j], a.row(j), y, a.cols);
+		}
+
+		return;
+	}
+
+	/********************************************************************************
+	* block_rows: Returnerar antalet rader med angiven längd som ryms i ett block
+	*             på ca 128 kB, så att blocket ligger kvar i cachen medan det
+	*             återanvänds för samtliga rader i den andra operanden.
+	*
+	*             - cols: Antalet element per rad.
+	********************************************************************************/
+	static inline std::size_t block_rows(const std::size_t cols)
+	{
+		const std::size_t block_elements = 16384;
+		return cols < block_elements ? block_elements / (cols ? cols : 1) : 1;
+	}
+
+	/********************************************************************************
+	* gemm_nt: Beräknar C = A * B^T, dvs. c[r][i] = dot(a[r], b[i]). Raderna i B
+	*          behandlas blockvis så att varje block återanvänds för samtliga
+	*          rader i A innan nästa block läses in.
+	*
+	*          - a: Vy över A (r x k).
+	*          - b: Vy över B (n x k).
+	*          - c: Vy över C (r x n), som skrivs över med resultatet.
+	********************************************************************************/
+	template <typename T>
+	static inline void gemm_nt(const basic_const_matrix_view<T>& a, const basic_const_matrix_view<T>& b, const basic_matrix_view<T>& c)
+	{
+		const auto k = a.cols < b.cols ? a.cols : b.cols;
+		const auto block = block_rows(k);
+
+		for (std::size_t i0 = 0; i0 < b.rows; i0 += block)
+		{
+			const auto i1 = i0 + block < b.rows ? i0 + block : b.rows;
+
+			std::size_t r = 0;
+
+			/* Fyra rader i A behandlas samtidigt så att varje rad i B enbart
+			   läses en gång per fyra skalärprodukter: */
+			for (; r + 4 <= a.rows; r += 4)
+			{
+				const T* x[4] = { a.row(r), a.row(r + 1), a.row(r + 2), a.row(r + 3) };
+
+				for (std::size_t i = i0; i < i1; ++i)
+				{
+					T result[4];
+					dot4(x, b.row(i), k, result);
+					for (std::size_t j = 0; j < 4; ++j) c(r + j, i) = result[j];
+				}
+			}
+
+			for (; r < a.rows; ++r)
+			{
+				const auto x = a.row(r);
+				auto y = c.row(r);
+
+				for (std::size_t i = i0; i < i1; ++i)
+				{
+					y[i] = dot(x, b.row(i), k);
+				}
+			}
+		}
+
+		return;
+	}
+
+	/********************************************************************************
+	* gemm_nn: Beräknar C = A * B, där varje rad i C byggs upp som en summa av
+	*          rader i B viktade med motsvarande element i A.
+	*
+	*          - a: Vy över A (r x k).
+	*          - b: Vy över B (k x n).
+	*          - c: Vy över C (r x n), som skrivs över med resultatet.
+	********************************************************************************/
+	template <typename T>
+	static inline void gemm_nn(const basic_const_matrix_view<T>& a, const basic_const_matrix_view<T>& b, const basic_matrix_view<T>& c)
+	{
+		const auto block = block_rows(b.cols);
+
+		for (std::size_t r = 0; r < c.rows; ++r)
+		{
+			auto y = c.row(r);
+			for (std::size_t i = 0; i < c.cols; ++i) y[i] = T(0);
+		}
+
+		for (std::size_t j0 = 0; j0 < b.rows; j0 += block)
+		{
+			const auto j1 = j0 + block < b.rows ? j0 + block : b.rows;
+
+			for (std::size_t r = 0; r < a.rows; ++r)
+			{
+				const auto x = a.row(r);
+				auto y = c.row(r);
+
+				std::size_t j = j0;
+
+				for (; j + 4 <= j1; j += 4)
+				{
+					const T* rows[4] = { b.row(j), b.row(j + 1), b.row(j + 2), b.row(j + 3) };
+					axpy4(x + j, rows, y, c.cols);
+				}
+
+				for (; j < j1; ++j)
+				{
+					axpy(x[j], b.row(j), y, c.cols);
+				}
+			}
+		}
+
+		return;
+	}
+
+	/********************************************************************************
+	* gemm_tn: Adderar A^T * B till C, dvs. c[i] += sum(a[r][i] * b[r]) över
+	*          samtliga rader r. Används för att summera viktgradienter över en
+	*          hel batch, där A innehåller felen och B lagrets indata.
+	*
+	*          - a: Vy över A (r x n).
+	*          - b: Vy över B (r x k).
+	*          - c: Vy över C (n x k), som resultatet adderas till.
+	********************************************************************************/
+	template <typename T>
+	static inline void gemm_tn(const basic_const_matrix_view<T>& a, const basic_const_matrix_view<T>& b, const basic_matrix_view<T>& c)
+	{
+		const auto block = block_rows(c.cols);
+
+		for (std::size_t i0 = 0; i0 < c.rows; i0 += block)
+		{
+			const auto i1 = i0 + block < c.rows ? i0 + block : c.rows;
+
+			std::size_t r = 0;
+
+			for (; r + 4 <= a.rows; r += 4)
+			{
+				const T* x[4] = { a.row(r), a.row(r + 1), a.row(r + 2), a.row(r + 3) };
+				const T* y[4] = { b.row(r), b.row(r + 1), b.row(r + 2), b.row(r + 3) };
+
+				for (std::size_t i = i0; i < i1; ++i)
+				{
+					const T alpha[4] = { x[0][i], x[1][i], x[2][i], x[3][i] };
+					axpy4(alpha, y, c.row(i), c.cols);
+				}
+			}
+
+			for (; r < a.rows; ++r)
+			{
+				const auto x = a.row(r);
+				const auto y = b.row(r);
+
+				for (std::size_t i = i0; i < i1; ++i)
+				{
+					axpy(x[i], y, c.row(i), c.cols);
+				}
+			}
+		}
+
+		return;
+	}
+}
+
+#endif /* SIMD_KERNELS_HPP_ */
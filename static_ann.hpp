@@ -0,0 +1,233 @@
+#ifndef STATIC_ANN_HPP_
+#define STATIC_ANN_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <array>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <initializer_list>
+
+#include "ann.hpp"
+
+/********************************************************************************
+* static_layer: Dense-lager med Nodes noder och Weights vikter per nod, där
+*               storleken är känd vid kompilering. Parametrarna lagras i
+*               std::array, och summeringen för varje nod skrivs ut helt
+*               (unrolled) via indexsekvenser, så att kompilatorn ser varje
+*               multiplikation och adress som konstanter, utan loopar,
+*               storleksanrop eller gränskontroller.
+********************************************************************************/
+template <typename T, std::size_t Nodes, std::size_t Weights>
+struct static_layer
+{
+	static constexpr std::size_t num_nodes = Nodes;
+	static constexpr std::size_t num_weights = Weights;
+
+	std::array<T, Nodes> bias = {};
+	std::array<std::array<T, Weights>, Nodes> weights = {};
+	activation::type activation_type = activation::type::tanh;
+	activation::tanh_mode activation_mode = activation::tanh_mode::exact;
+
+	/********************************************************************************
+	* feedforward: Beräknar lagrets utsignaler för angiven indata.
+	*
+	*              - input : Pekare till Weights insignaler.
+	*              - output: Pekare till buffert för Nodes utsignaler.
+	********************************************************************************/
+	inline void feedforward(const T* input, T* output) const
+	{
+		this->sum_nodes(input, output, std::make_index_sequence<Nodes>());
+
+		activation::dispatch(this->activation_type, [&](auto policy)
+		{
+			typedef decltype(policy) policy_type;
+			policy_type::apply(output, Nodes, this->activation_mode);
+		});
+
+		return;
+	}
+
+	/********************************************************************************
+	* load: Kopierar parametrar och aktiveringsfunktion från ett tränat lager.
+	*       Returnerar false om lagrets storlek inte stämmer.
+	*
+	*       - layer: Referens till lagret som ska kopieras.
+	********************************************************************************/
+	template <typename U>
+	bool load(const basic_dense_layer<U>& layer)
+	{
+		if (layer.num_nodes() != Nodes || layer.num_weights() != Weights) return false;
+
+		for (std::size_t i = 0; i < Nodes; ++i)
+		{
+			const auto w = layer.weights.row(i);
+			this->bias[i] = static_cast<T>(layer.bias[i]);
+
+			for (std::size_t j = 0; j < Weights; ++j)
+			{
+				this->weights[i][j] = static_cast<T>(w[j]);
+			}
+		}
+
+		this->activation_type = layer.activation_type;
+		this->activation_mode = layer.activation_mode;
+		return true;
+	}
+
+private:
+	/* Initieringslistorna nedan garanterar att uttrycken utvärderas i ordning: */
+	template <std::size_t... I>
+	inline void sum_nodes(const T* input, T* output, std::index_sequence<I...>) const
+	{
+		(void)std::initializer_list<int>{ (output[I] = this->sum_node<I>(input, std::make_index_sequence<Weights>()), 0)... };
+	}
+
+	template <std::size_t I, std::size_t... J>
+	inline T sum_node(const T* input, std::index_sequence<J...>) const
+	{
+		auto sum = std::get<I>(this->bias);
+		(void)std::initializer_list<int>{ (sum += std::get<J>(std::get<I>(this->weights)) * input[J], 0)... };
+		return sum;
+	}
+};
+
+/********************************************************************************
+* static_layer_chain: Kedja av static_layer där varje lagers antal vikter är
+*                     föregående lagers antal noder. Mellanresultaten lagras
+*                     i std::array på stacken.
+********************************************************************************/
+template <typename T, std::size_t Inputs, std::size_t... Layers>
+struct static_layer_chain;
+
+template <typename T, std::size_t Inputs, std::size_t Nodes, std::size_t Next, std::size_t... Rest>
+struct static_layer_chain<T, Inputs, Nodes, Next, Rest...>
+{
+	typedef static_layer_chain<T, Nodes, Next, Rest...> next_type;
+	static constexpr std::size_t num_outputs = next_type::num_outputs;
+
+	static_layer<T, Nodes, Inputs> layer;
+	next_type next;
+
+	inline void predict(const T* input, T* output) const
+	{
+		std::array<T, Nodes> buffer;
+		this->layer.feedforward(input, buffer.data());
+		this->next.predict(buffer.data(), output);
+	}
+
+	template <typename U>
+	bool load(const basic_ann<U>& network, const std::size_t index)
+	{
+		return this->layer.load(network.get_hidden_layers()[index]) && this->next.load(network, index + 1);
+	}
+};
+
+template <typename T, std::size_t Inputs, std::size_t Nodes>
+struct static_layer_chain<T, Inputs, Nodes>
+{
+	static constexpr std::size_t num_outputs = Nodes;
+
+	static_layer<T, Nodes, Inputs> layer;
+
+	inline void predict(const T* input, T* output) const
+	{
+		this->layer.feedforward(input, output);
+	}
+
+	template <typename U>
+	bool load(const basic_ann<U>& network, const std::size_t)
+	{
+		return this->layer.load(network.get_output_layer());
+	}
+};
+
+/********************************************************************************
+* basic_static_ann: Nätverk med fast topologi för prediktion, där antalet
+*                   insignaler och antalet noder i varje lager anges som
+*                   mallparametrar, exempelvis static_ann<4, 4, 1> för
+*                   nätverket ann(4, 1, 4, 1) i main.cpp. Sista storleken är
+*                   utgångslagret och övriga dolda lager, i ordning.
+*
+*                   Parametrarna läses in från ett tränat nätverk eller en
+*                   modellfil med samma topologi, varefter prediktionen sker
+*                   helt utan minnesallokeringar, storleksanrop och loopar
+*                   över lager, med samtliga buffertar på stacken. Objektet
+*                   innehåller enbart parametrarna och kan placeras statiskt.
+********************************************************************************/
+template <typename T, std::size_t Inputs, std::size_t... Layers>
+class basic_static_ann
+{
+public:
+	static_assert(sizeof...(Layers) >= 2, "basic_static_ann kräver minst ett dolt lager och ett utgångslager");
+
+	typedef T value_type;
+	typedef static_layer_chain<T, Inputs, Layers...> chain_type;
+
+	static constexpr std::size_t num_inputs = Inputs;
+	static constexpr std::size_t num_outputs = chain_type::num_outputs;
+	static constexpr std::size_t num_layers = sizeof...(Layers);
+
+	basic_static_ann(void) { }
+
+	/********************************************************************************
+	* load: Kopierar parametrar och aktiveringsfunktioner från ett tränat
+	*       nätverk. Returnerar false om nätverkets topologi inte stämmer med
+	*       mallparametrarna, varvid objektet kan vara delvis inläst.
+	*
+	*       - network: Referens till nätverket som ska kopieras.
+	********************************************************************************/
+	template <typename U>
+	bool load(const basic_ann<U>& network)
+	{
+		if (network.get_hidden_layers().size() + 1 != num_layers) return false;
+		return this->layers.load(network, 0);
+	}
+
+	/********************************************************************************
+	* load: Läser in parametrarna från en modellfil som sparats via
+	*       basic_ann<T>::save. Returnerar false om filen inte kan läsas eller
+	*       om topologin inte stämmer.
+	*
+	*       - path: Sökväg till modellfilen.
+	********************************************************************************/
+	bool load(const std::string& path)
+	{
+		const std::size_t sizes[] = { Layers... };
+		network_builder topology(Inputs);
+
+		for (std::size_t i = 0; i + 1 < num_layers; ++i)
+		{
+			topology.hidden(sizes[i]);
+		}
+
+		basic_ann<T> network(topology.output(sizes[num_layers - 1]));
+		return network.load(path, true) && this->load(network);
+	}
+
+	/********************************************************************************
+	* predict: Beräknar utsignalerna för angiven indata.
+	*
+	*          - input : Pekare till num_inputs insignaler.
+	*          - output: Pekare till buffert för num_outputs utsignaler.
+	********************************************************************************/
+	inline void predict(const T* input, T* output) const
+	{
+		this->layers.predict(input, output);
+	}
+
+	inline std::array<T, num_outputs> predict(const std::array<T, Inputs>& input) const
+	{
+		std::array<T, num_outputs> output;
+		this->layers.predict(input.data(), output.data());
+		return output;
+	}
+
+private:
+	chain_type layers;
+};
+
+template <std::size_t Inputs, std::size_t... Layers>
+using static_ann = basic_static_ann<double, Inputs, Layers...>;
+
+#endif /* STATIC_ANN_HPP_ */
@@ -0,0 +1,136 @@
+/********************************************************************************
+* activation_test.cpp: Kontrollerar den approximativa tanh i activation.hpp
+*                      mot std::tanh, med det största absoluta fel som anges
+*                      för tanh_mode::fast (ca 4e-7), på samtliga
+*                      instruktionsnivåer som processorn stöder. Kontrollerar
+*                      även att delta_tanh ger derivatan av tanh uttryckt i
+*                      utsignalen, dvs. 1 - y^2 och inte 1 - tanh(y)^2.
+********************************************************************************/
+#include "check.hpp"
+#include "activation.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	/* Största absoluta fel för tanh_mode::fast enligt activation.hpp: */
+	const double fast_tanh_bound = 4e-7;
+
+	const double range = 20.0;
+	const double step = 1e-4;
+
+	/***
+	* Funktionen test_fast_tanh: Beräknar tanh för samtliga punkter i
+	* [-range, range] med angivet steg, dels element för element via
+	* activation::tanh_fast, dels rad för rad via varje nivås kärna och
+	* apply_tanh, och kontrollerar största felet mot std::tanh.
+	**/
+	template <typename T>
+	void test_fast_tanh(const char* type_name)
+	{
+		const auto n = static_cast<std::size_t>(2.0 * range / step) + 1;
+		std::vector<T> inputs(n);
+
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			inputs[i] = static_cast<T>(-range + static_cast<double>(i) * step);
+		}
+
+		double max_error = 0.0;
+
+		for (const auto x : inputs)
+		{
+			const auto error = std::fabs(static_cast<double>(activation::tanh_fast(x)) - std::tanh(static_cast<double>(x)));
+			if (error > max_error) max_error = error;
+		}
+
+		std::printf("  %-6s %-10s max error %.3g\n", type_name, "tanh_fast", max_error);
+		CHECK_CLOSE(max_error, 0.0, fast_tanh_bound, "tanh_fast");
+
+		const simd::isa levels[] = { simd::isa::scalar, simd::isa::sse2, simd::isa::avx2, simd::isa::avx512 };
+		const char* const level_names[] = { "scalar", "sse2", "avx2", "avx512" };
+
+		for (const auto level : levels)
+		{
+			if (level != simd::isa::scalar && !simd::detail::cpu_supports(level)) continue;
+
+			auto outputs = inputs;
+			simd::kernels_for<T>(level).tanh(outputs.data(), n);
+			max_error = 0.0;
+
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				const auto error = std::fabs(static_cast<double>(outputs[i]) - std::tanh(static_cast<double>(inputs[i])));
+				if (error > max_error) max_error = error;
+			}
+
+			std::printf("  %-6s %-10s max error %.3g\n", type_name, level_names[static_cast<int>(level)], max_error);
+			CHECK_CLOSE(max_error, 0.0, fast_tanh_bound, "kernel tanh");
+		}
+
+		/* apply_tanh väljer kärnan efter läget: */
+		auto fast = inputs;
+		auto exact = inputs;
+		activation::apply_tanh(fast.data(), n, activation::tanh_mode::fast);
+		activation::apply_tanh(exact.data(), n, activation::tanh_mode::exact);
+		double fast_error = 0.0;
+		bool exact_matches = true;
+
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			const auto error = std::fabs(static_cast<double>(fast[i]) - std::tanh(static_cast<double>(inputs[i])));
+			if (error > fast_error) fast_error = error;
+			if (exact[i] != std::tanh(inputs[i])) exact_matches = false;
+		}
+
+		CHECK_CLOSE(fast_error, 0.0, fast_tanh_bound, "apply_tanh (fast)");
+		CHECK(exact_matches);
+	}
+
+	/***
+	* Funktionen test_delta_tanh: Jämför delta_tanh(tanh(x)) med en central
+	* differens av std::tanh. Den tidigare felaktiga 1 - tanh(y)^2 avviker
+	* kraftigt för stora |x|, exempelvis 0.42 i stället för 0.0099 vid x = 3.
+	**/
+	void test_delta_tanh(void)
+	{
+		const double h = 1e-5;
+		double max_error = 0.0;
+
+		for (double x = -6.0; x <= 6.0; x += 1e-3)
+		{
+			const auto y = std::tanh(x);
+			const auto expected = (std::tanh(x + h) - std::tanh(x - h)) / (2.0 * h);
+			const auto error = std::fabs(activation::delta_tanh(y) - expected);
+			if (error > max_error) max_error = error;
+		}
+
+		std::printf("  delta_tanh max error %.3g\n", max_error);
+		CHECK_CLOSE(max_error, 0.0, 1e-9, "delta_tanh");
+
+		const auto y = std::tanh(3.0);
+		CHECK_CLOSE(activation::delta_tanh(y), 1.0 - y * y, 1e-15, "delta_tanh(tanh(3))");
+		CHECK(activation::delta_tanh(y) < 0.01);
+		CHECK(activation::tanh_policy::derivative(y) == activation::delta_tanh(y));
+
+		/* Samma derivata via multiply_derivative, som används vid backpropagering: */
+		const double outputs[] = { -0.9, -0.5, 0.0, 0.5, 0.9 };
+		double errors[] = { 1.0, 1.0, 1.0, 1.0, 1.0 };
+		activation::multiply_derivative(activation::type::tanh, outputs, errors, 5);
+
+		for (std::size_t i = 0; i < 5; ++i)
+		{
+			CHECK_CLOSE(errors[i], 1.0 - outputs[i] * outputs[i], 1e-15, "multiply_derivative (tanh)");
+		}
+	}
+}
+
+void activation_tests(void)
+{
+	test_fast_tanh<double>("double");
+	test_fast_tanh<float>("float");
+	test_delta_tanh();
+	return;
+}
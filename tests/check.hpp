@@ -0,0 +1,54 @@
+#ifndef CHECK_HPP_
+#define CHECK_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+
+/********************************************************************************
+* test: Minimala hjälpfunktioner för testerna i tests/. Ett misslyckat villkor
+*       skrivs ut med fil och rad och räknas, varefter testet fortsätter, så
+*       att samtliga fel i en körning syns på en gång. Testprogrammet
+*       returnerar 1 om minst ett villkor har misslyckats.
+********************************************************************************/
+namespace test
+{
+	inline std::size_t& failures(void)
+	{
+		static std::size_t count = 0;
+		return count;
+	}
+
+	inline bool check(const bool condition, const char* expression, const char* file, const int line)
+	{
+		if (!condition)
+		{
+			std::printf("%s:%d: check failed: %s\n", file, line, expression);
+			failures()++;
+		}
+
+		return condition;
+	}
+
+	/********************************************************************************
+	* check_close: Kontrollerar att |actual - expected| <= tolerance och skriver
+	*              annars ut värdena samt angiven beskrivning.
+	********************************************************************************/
+	inline bool check_close(const double actual, const double expected, const double tolerance,
+		const char* what, const char* file, const int line)
+	{
+		const auto error = std::fabs(actual - expected);
+		if (error <= tolerance) return true;
+
+		std::printf("%s:%d: %s: got %.17g, expected %.17g (error %.3g > %.3g)\n",
+			file, line, what, actual, expected, error, tolerance);
+		failures()++;
+		return false;
+	}
+}
+
+#define CHECK(condition) test::check((condition), #condition, __FILE__, __LINE__)
+#define CHECK_CLOSE(actual, expected, tolerance, what) test::check_close((actual), (expected), (tolerance), (what), __FILE__, __LINE__)
+
+#endif /* CHECK_HPP_ */
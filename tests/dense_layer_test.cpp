@@ -0,0 +1,178 @@
+/********************************************************************************
+* dense_layer_test.cpp: Jämför bakåtpropageringen och viktuppdateringen i
+*                       dense_layer med en referens som lagrar vikterna
+*                       som vector<vector<double>> och går igenom nästa
+*                       lagers vikter kolumn för kolumn, som den ursprungliga
+*                       implementeringen. Eftersom felen ackumuleras rad för
+*                       rad i samma summeringsordning ska resultatet vara
+*                       bitidentiskt när beräkningskärnorna inte använder
+*                       FMA, vilket gäller för vektorer kortare än
+*                       simd::short_length samt på nivåerna scalar och sse2.
+*                       Med FMA skiljer sig enbart avrundningen, vilket
+*                       kontrolleras med en tolerans. Kontrollerar även att
+*                       vikterna ligger radvis i en justerad buffert.
+********************************************************************************/
+#include "check.hpp"
+#include "dense_layer.hpp"
+#include "prng.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace
+{
+	typedef std::vector<std::vector<double>> nested;
+
+	/***
+	* Funktionen copy_weights: Returnerar angivet lagers vikter som
+	* vector<vector<double>>, en vektor per nod.
+	**/
+	nested copy_weights(const dense_layer& layer)
+	{
+		nested weights(layer.num_nodes(), std::vector<double>(layer.num_weights()));
+
+		for (std::size_t i = 0; i < layer.num_nodes(); ++i)
+		{
+			for (std::size_t j = 0; j < layer.num_weights(); ++j)
+			{
+				weights[i][j] = layer.weights[i][j];
+			}
+		}
+
+		return weights;
+	}
+
+	/***
+	* Funktionen is_exact: Indikerar ifall axpy med vektorer av angiven längd
+	* beräknas utan FMA, dvs. med samma avrundning som den skalära referensen.
+	**/
+	bool is_exact(const std::size_t n)
+	{
+		const auto level = simd::kernels<double>().level;
+		return n < simd::short_length || level == simd::isa::scalar || level == simd::isa::sse2;
+	}
+
+	/***
+	* Funktionen check_equal: Kontrollerar att actual är exakt lika med expected
+	* om exact är satt, annars inom avrundningsfelet för en summa av num_terms
+	* termer med angiven absolutsumma.
+	**/
+	void check_equal(const double actual, const double expected, const bool exact,
+		const std::size_t num_terms, const double magnitude, const char* what)
+	{
+		if (exact)
+		{
+			CHECK_CLOSE(actual, expected, 0.0, what);
+		}
+		else
+		{
+			CHECK_CLOSE(actual, expected, 2.0 * (num_terms + 1) * std::numeric_limits<double>::epsilon() * magnitude, what);
+		}
+
+		return;
+	}
+
+	/***
+	* Funktionen test_backpropagate: Jämför felen i ett dolt lager med width
+	* noder, beräknade från ett efterföljande lager med num_next noder, med
+	* den ursprungliga kolumnvisa summeringen.
+	**/
+	void test_backpropagate(const std::size_t width, const std::size_t num_next, prng::generator& rng)
+	{
+		dense_layer layer(width, 3, rng);
+		dense_layer next_layer(num_next, width, rng);
+		dense_layer::state_type state, next_state;
+		state.resize(width);
+		next_state.resize(num_next);
+
+		for (auto& value : state.output) value = rng.uniform(-1.0, 1.0);
+		for (auto& value : next_state.error) value = rng.uniform(-1.0, 1.0);
+
+		const auto weights = copy_weights(next_layer);
+		layer.backpropagate(next_layer, next_state, state);
+
+		for (std::size_t i = 0; i < width; ++i)
+		{
+			auto dev = 0.0;
+			auto magnitude = 0.0;
+
+			for (std::size_t j = 0; j < num_next; ++j)
+			{
+				dev += next_state.error[j] * weights[j][i];
+				magnitude += std::fabs(next_state.error[j] * weights[j][i]);
+			}
+
+			const auto output = state.output[i];
+			check_equal(state.error[i], dev * (1 - output * output), is_exact(width), num_next, magnitude, "error");
+		}
+
+		return;
+	}
+
+	/***
+	* Funktionen test_optimize: Jämför en viktuppdatering med den ursprungliga
+	* uppdateringen weights[i][j] += error[i] * learning_rate * input[j].
+	**/
+	void test_optimize(const std::size_t width, const std::size_t num_weights, prng::generator& rng)
+	{
+		const double learning_rate = 0.03;
+		dense_layer layer(width, num_weights, rng);
+		dense_layer::state_type state;
+		state.resize(width);
+		std::vector<double> input(num_weights);
+
+		for (auto& value : state.error) value = rng.uniform(-1.0, 1.0);
+		for (auto& value : input) value = rng.uniform(-1.0, 1.0);
+
+		auto weights = copy_weights(layer);
+		std::vector<double> bias(layer.bias.data(), layer.bias.data() + width);
+		layer.optimize(input, state, learning_rate);
+
+		for (std::size_t i = 0; i < width; ++i)
+		{
+			bias[i] += state.error[i] * learning_rate;
+			CHECK_CLOSE(layer.bias[i], bias[i], 0.0, "bias");
+
+			for (std::size_t j = 0; j < num_weights; ++j)
+			{
+				const auto step = state.error[i] * learning_rate * input[j];
+				weights[i][j] += step;
+				check_equal(layer.weights[i][j], weights[i][j], is_exact(num_weights), 1, std::fabs(weights[i][j]) + std::fabs(step), "weight");
+			}
+		}
+
+		return;
+	}
+}
+
+void dense_layer_tests(void)
+{
+	prng::generator rng(11);
+	const std::size_t widths[] = { 1, 3, 7, 8, 13, 64, 100 };
+
+	for (const auto width : widths)
+	{
+		for (const auto other : widths)
+		{
+			test_backpropagate(width, other, rng);
+			test_optimize(width, other, rng);
+		}
+	}
+
+	/* Vikterna ligger i en justerad buffert med raderna utfyllda till hela
+	   cache-rader, och weights[i][j] adresserar samma element som row(i)[j]: */
+	for (const auto width : widths)
+	{
+		const dense_layer layer(3, width, rng);
+		const auto stride = layer.weights.row(1) - layer.weights.row(0);
+
+		CHECK(reinterpret_cast<std::uintptr_t>(layer.weights.row(0)) % 64 == 0);
+		CHECK(stride >= static_cast<std::ptrdiff_t>(width) && stride * sizeof(double) % 64 == 0);
+		CHECK(&layer.weights[2][width - 1] == layer.weights.row(2) + width - 1);
+	}
+
+	return;
+}
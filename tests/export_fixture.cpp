@@ -0,0 +1,67 @@
+/********************************************************************************
+* export_fixture.cpp: Tränar två små nätverk med fasta startvärden och skriver
+*                     för vart och ett en modellfil samt den header som
+*                     basic_ann::export_source genererar. Körs av CMake innan
+*                     testerna kompileras, så att export_test.cpp kan
+*                     inkludera headrarna och jämföra dem med ann::predict.
+*
+*                     - neu_network_model: Samma topologi som i main.cpp,
+*                                          4-4-1 med exakt tanh.
+*                     - mixed_model      : relu, sigmoid, tanh och linjär
+*                                          utgång med tanh_mode::fast.
+*
+*                     Användning: neu_network_export_fixture <katalog>
+********************************************************************************/
+#include "ann.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+	/***
+	* Funktionen write_model: Tränar nätverket kort och sparar modellfilen
+	* <katalog>/<namn>.model samt headern <katalog>/<namn>.hpp.
+	**/
+	bool write_model(ann& network, const std::string& directory, const std::string& name)
+	{
+		std::vector<std::vector<double>> inputs;
+		std::vector<std::vector<double>> outputs;
+
+		for (unsigned value = 0; value < 16; ++value)
+		{
+			inputs.push_back({ double(value >> 3 & 1), double(value >> 2 & 1), double(value >> 1 & 1), double(value & 1) });
+			outputs.push_back({ double((value ^ value >> 1 ^ value >> 2 ^ value >> 3) & 1) });
+		}
+
+		network.set_training_data(inputs, outputs);
+		network.seed(1);
+		network.train(500, 0.01);
+
+		const auto path = directory + "/" + name;
+		return network.save(path + ".model") && network.export_source(path + ".hpp", name);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::fprintf(stderr, "Usage: neu_network_export_fixture <directory>\n");
+		return 1;
+	}
+
+	ann simple(4, 1, 4, 1);
+	ann mixed(network_builder(4).hidden(6, activation::type::relu).hidden(5, activation::type::sigmoid)
+		.hidden(3, activation::type::tanh).output(1, activation::type::linear));
+	mixed.set_tanh_mode(activation::tanh_mode::fast);
+
+	if (!write_model(simple, argv[1], "neu_network_model") || !write_model(mixed, argv[1], "mixed_model"))
+	{
+		std::fprintf(stderr, "Could not write the models to %s\n", argv[1]);
+		return 1;
+	}
+
+	return 0;
+}
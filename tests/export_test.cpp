@@ -0,0 +1,69 @@
+/********************************************************************************
+* export_test.cpp: Kompilerar headrarna som basic_ann::export_source har
+*                  genererat (se export_fixture.cpp) och jämför deras predict
+*                  med ann::predict för samma modellfil, för samtliga 16
+*                  kombinationer av fyra binära insignaler.
+********************************************************************************/
+#include "check.hpp"
+#include "ann.hpp"
+
+#include "neu_network_model.hpp"
+#include "mixed_model.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+	/* Headern summerar i annan ordning än SIMD-kärnorna, därav en liten marginal: */
+	const double tolerance = 1e-12;
+
+	/***
+	* Funktionen test_model: Läser in modellfilen med angivet tanh-läge och
+	* jämför samtliga utsignaler med den genererade funktionen predict.
+	**/
+	template <typename Predict>
+	void test_model(const char* name, const activation::tanh_mode mode, const std::size_t num_inputs,
+		const std::size_t num_outputs, Predict generated)
+	{
+		ann network(4, 1, 4, 1);
+		network.set_tanh_mode(mode);
+
+		if (!CHECK(network.load(std::string(NEU_NETWORK_EXPORT_DIR "/") + name + ".model"))) return;
+
+		CHECK(num_inputs == 4);
+		CHECK(num_outputs == network.get_output_layer().num_nodes());
+
+		inference_context context;
+		double max_error = 0.0;
+
+		for (unsigned value = 0; value < 16; ++value)
+		{
+			const std::vector<double> input = { double(value >> 3 & 1), double(value >> 2 & 1), double(value >> 1 & 1), double(value & 1) };
+			const auto& expected = network.predict(input, context);
+			std::vector<double> output(num_outputs);
+
+			generated(input.data(), output.data());
+
+			for (std::size_t i = 0; i < num_outputs; ++i)
+			{
+				CHECK(std::isfinite(expected[i]));
+				CHECK_CLOSE(output[i], expected[i], tolerance, name);
+				if (std::fabs(output[i] - expected[i]) > max_error) max_error = std::fabs(output[i] - expected[i]);
+			}
+		}
+
+		std::printf("  %-18s max error %.3g\n", name, max_error);
+	}
+}
+
+void export_tests(void)
+{
+	test_model("neu_network_model", activation::tanh_mode::exact, neu_network_model::num_inputs,
+		neu_network_model::num_outputs, neu_network_model::predict);
+	test_model("mixed_model", activation::tanh_mode::fast, mixed_model::num_inputs,
+		mixed_model::num_outputs, mixed_model::predict);
+	return;
+}
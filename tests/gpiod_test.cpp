@@ -0,0 +1,90 @@
+/********************************************************************************
+* gpiod_test.cpp: Kontrollerar den händelsestyrda väntan i gpiod_line.hpp mot
+*                 dummyfilerna. En annan tråd växlar en insignal via
+*                 gpiod_sim_line_set_value med kontaktstudsar, som ett
+*                 knapptryck. Kontrollerar att gpiod_line_wait_edges
+*                 returnerar, att tiden för den första flanken anges, att
+*                 flera studsar räknas som en händelse och att
+*                 gpiod_line_debounce väntar ut samtliga studsar.
+********************************************************************************/
+#include "check.hpp"
+#include "gpiod_line.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace
+{
+	typedef std::chrono::steady_clock clock;
+
+	/***
+	* Funktionen bounce: Växlar angiven linje num_bounces gånger med
+	* interval_ms millisekunder emellan och slutar på nivån 1. Tiden
+	* före och efter den första flanken samt efter den sista flanken
+	* skrivs till angivna variabler.
+	**/
+	void bounce(struct gpiod_line* line, const int num_bounces, const int interval_ms,
+		clock::time_point& before_first, clock::time_point& after_first, std::atomic<clock::rep>& last)
+	{
+		for (int i = 0; i < num_bounces; ++i)
+		{
+			if (i == 0) before_first = clock::now();
+			gpiod_sim_line_set_value(line, (num_bounces - i) & 1);
+			if (i == 0) after_first = clock::now();
+			last = clock::now().time_since_epoch().count();
+			std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+		}
+
+		return;
+	}
+}
+
+void gpiod_tests(void)
+{
+	struct gpiod_line* button = gpiod_line_new(20, GPIO_DIRECTION_IN_EDGES, "button");
+	if (!CHECK(gpiod_line_event_get_fd(button) >= 0)) return;
+
+	/* Studsar som inträffat före anropet läses ut som en enda händelse: */
+	for (int i = 0; i < 5; ++i)
+	{
+		gpiod_sim_line_set_value(button, (5 - i) & 1);
+	}
+
+	CHECK(gpiod_line_wait_edges(&button, 1, 100) == 1);
+	CHECK(gpiod_line_wait_edges(&button, 1, 0) == 0);
+	CHECK(gpiod_line_get_value(button) == 1);
+
+	/* Knapptryck med studsar från en annan tråd medan huvudtråden väntar: */
+	gpiod_sim_line_set_value(button, 0);
+	gpiod_line_debounce(&button, 1, 0);
+
+	const int num_bounces = 7;
+	const int interval_ms = 5;
+	const int quiet_ms = 30;
+	clock::time_point before_first, after_first;
+	std::atomic<clock::rep> last{ 0 };
+	auto first_edge = clock::time_point::min();
+
+	std::thread presser([&]()
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		bounce(button, num_bounces, interval_ms, before_first, after_first, last);
+	});
+
+	const auto num_changed = gpiod_line_wait_edges(&button, 1, 2000, &first_edge);
+	gpiod_line_debounce(&button, 1, quiet_ms);
+	const auto settled = clock::now();
+	presser.join();
+
+	CHECK(num_changed == 1);
+	CHECK(first_edge != clock::time_point::min());
+	CHECK(first_edge >= before_first && first_edge <= after_first);
+
+	/* Debouncingen återvänder först när linjen har varit stilla i quiet_ms efter
+	   den sista studsen, varefter inga händelser återstår och nivån är stabil: */
+	CHECK(settled - clock::time_point(clock::duration(last.load())) >= std::chrono::milliseconds(quiet_ms));
+	CHECK(gpiod_line_wait_edges(&button, 1, 0) == 0);
+	CHECK(gpiod_line_get_value(button) == 1);
+	return;
+}
@@ -0,0 +1,62 @@
+/********************************************************************************
+* main.cpp (tests): Kör angivna testsviter, eller samtliga om inga anges.
+*                   Varje svit registreras även som ett eget test i CMake,
+*                   så att ctest visar vilken svit som misslyckades.
+*
+*                   Användning: neu_network_tests [svit ...]
+********************************************************************************/
+#include "check.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+void simd_kernel_tests(void);
+void activation_tests(void);
+void export_tests(void);
+void online_learner_tests(void);
+void train_parallel_tests(void);
+void gpiod_tests(void);
+void truth_table_tests(void);
+void dense_layer_tests(void);
+
+namespace
+{
+	struct suite
+	{
+		const char* name;
+		void (*run)(void);
+	};
+
+	const suite suites[] =
+	{
+		{ "simd_kernels", simd_kernel_tests },
+		{ "activation", activation_tests },
+		{ "export", export_tests },
+		{ "online_learner", online_learner_tests },
+		{ "train_parallel", train_parallel_tests },
+		{ "gpiod", gpiod_tests },
+		{ "truth_table", truth_table_tests },
+		{ "dense_layer", dense_layer_tests },
+	};
+}
+
+int main(int argc, char** argv)
+{
+	for (const auto& entry : suites)
+	{
+		bool selected = argc < 2;
+
+		for (int i = 1; i < argc; ++i)
+		{
+			if (std::strcmp(argv[i], entry.name) == 0) selected = true;
+		}
+
+		if (!selected) continue;
+
+		std::printf("%s\n", entry.name);
+		entry.run();
+	}
+
+	std::printf("%s\n", test::failures() ? "FAILED" : "All tests passed");
+	return test::failures() ? 1 : 0;
+}
@@ -0,0 +1,125 @@
+/********************************************************************************
+* online_learner_test.cpp: Tränar ett nätverk på pariteten av fyra knappar,
+*                          utan kombinationen 0110, och lär det sedan via
+*                          basic_online_learner att tända lysdioden även för
+*                          0110, medan en annan tråd predikterar som
+*                          styrloopen. Kontrollerar att läsaren aldrig ser
+*                          vikter som håller på att skrivas, att den nya
+*                          kombinationen lärs in och att tidigare inlärda
+*                          kombinationer behålls.
+********************************************************************************/
+#include "check.hpp"
+#include "online_learner.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	/***
+	* Funktionen parity_table: Returnerar samtliga kombinationer av fyra
+	* binära insignaler och deras paritet, utom angiven kombination.
+	**/
+	void parity_table(const unsigned excluded, std::vector<std::vector<double>>& inputs,
+		std::vector<std::vector<double>>& outputs)
+	{
+		for (unsigned value = 0; value < 16; ++value)
+		{
+			if (value == excluded) continue;
+			inputs.push_back({ double(value >> 3 & 1), double(value >> 2 & 1), double(value >> 1 & 1), double(value & 1) });
+			outputs.push_back({ double((value ^ value >> 1 ^ value >> 2 ^ value >> 3) & 1) });
+		}
+
+		return;
+	}
+}
+
+void online_learner_tests(void)
+{
+	std::vector<std::vector<double>> inputs, outputs;
+	parity_table(6, inputs, outputs);
+
+	ann network(4, 1, 8, 1);
+	network.set_training_data(inputs, outputs);
+	network.set_optimizer(optimizer::type::nesterov);
+	network.seed(1);
+	network.train(3000, 0.03);
+	network.compile_truth_table();
+
+	inference_context context;
+
+	for (std::size_t i = 0; i < inputs.size(); ++i)
+	{
+		CHECK(network.predict_thresholded(inputs[i], context) == static_cast<std::uint64_t>(outputs[i][0]));
+	}
+
+	const std::vector<double> added = { 0, 1, 1, 0 };
+	const std::vector<double> reference = { 1 };
+	std::vector<double> original, first;
+	network.snapshot(original);
+
+	online_learner::settings options;
+	options.epochs_per_update = 200;
+	online_learner learner(network, options);
+
+	/* Före första uppdateringen publiceras det ursprungliga nätverket: */
+	learner.acquire().snapshot(first);
+	CHECK(first == original);
+	CHECK(learner.num_updates() == 0);
+
+	std::atomic<bool> done{ false };
+	std::size_t num_reads = 0, num_torn = 0, num_swaps = 0;
+
+	/* Läsaren kontrollerar att vikterna är oförändrade under prediktionen: */
+	std::thread reader([&]()
+	{
+		inference_context context;
+		const ann* previous = nullptr;
+		std::vector<double> before, after;
+
+		while (!done.load())
+		{
+			const ann& current = learner.acquire();
+			if (&current != previous) num_swaps++;
+			previous = &current;
+
+			current.snapshot(before);
+			current.predict_thresholded(added, context);
+			current.snapshot(after);
+			if (before != after) num_torn++;
+			num_reads++;
+		}
+	});
+
+	for (std::size_t i = 0; i < 20; ++i)
+	{
+		learner.add_sample(added, reference);
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	}
+
+	learner.wait();
+	done.store(true);
+	reader.join();
+
+	std::printf("  updates %zu, reads %zu, swaps %zu, torn reads %zu\n",
+		learner.num_updates(), num_reads, num_swaps, num_torn);
+	CHECK(learner.num_updates() > 0);
+	CHECK(num_reads > 0);
+	CHECK(num_torn == 0);
+
+	/* Det senast publicerade nätverket har lärt sig den nya kombinationen och
+	   behåller, tack vare ursprungliga träningsdata, övriga kombinationer: */
+	const ann& trained = learner.acquire();
+	CHECK(trained.has_truth_table());
+	CHECK(trained.predict_thresholded(added, context) == 1);
+
+	for (std::size_t i = 0; i < inputs.size(); ++i)
+	{
+		CHECK(trained.predict_thresholded(inputs[i], context) == static_cast<std::uint64_t>(outputs[i][0]));
+	}
+
+	return;
+}
@@ -0,0 +1,287 @@
+/********************************************************************************
+* simd_kernels_test.cpp: Jämför beräkningskärnorna i simd_kernels.hpp på
+*                        samtliga instruktionsnivåer som processorn stöder
+*                        med en skalär referens i long double, för float och
+*                        double och samtliga längder 0..max_length, så att
+*                        varje kombination av hela vektorer och svans testas.
+*                        Vektorerna läses även från ojusterade adresser.
+********************************************************************************/
+#include "check.hpp"
+#include "simd_kernels.hpp"
+#include "prng.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+namespace
+{
+	const std::size_t max_length = 67;
+	const std::size_t max_rows = 9;
+
+	const char* isa_name(const simd::isa level)
+	{
+		switch (level)
+		{
+		case simd::isa::avx512: return "avx512";
+		case simd::isa::avx2: return "avx2";
+		case simd::isa::sse2: return "sse2";
+		default: return "scalar";
+		}
+	}
+
+	template <typename T>
+	std::vector<T> random_vector(prng::generator& rng, const std::size_t n, const double low = -1.0, const double high = 1.0)
+	{
+		std::vector<T> data(n);
+		for (auto& value : data) value = static_cast<T>(rng.uniform(low, high));
+		return data;
+	}
+
+	/***
+	* Funktionen dot_tolerance: Övre gräns för avrundningsfelet i en summa av n
+	* produkter, oavsett summeringsordning och om FMA används.
+	**/
+	template <typename T>
+	double dot_tolerance(const T* x, const T* y, const std::size_t n)
+	{
+		long double sum = 0;
+		for (std::size_t i = 0; i < n; ++i) sum += std::fabs(static_cast<long double>(x[i]) * y[i]);
+		return 2.0 * (n + 1) * std::numeric_limits<T>::epsilon() * static_cast<double>(sum) + std::numeric_limits<T>::min();
+	}
+
+	template <typename T>
+	void test_dot(const simd::basic_kernel_table<T>& table, prng::generator& rng, const std::size_t offset)
+	{
+		for (std::size_t n = 0; n <= max_length; ++n)
+		{
+			const auto x = random_vector<T>(rng, n + offset);
+			const auto y = random_vector<T>(rng, n + offset);
+			long double expected = 0;
+
+			for (std::size_t i = 0; i < n; ++i) expected += static_cast<long double>(x[offset + i]) * y[offset + i];
+
+			CHECK_CLOSE(table.dot(x.data() + offset, y.data() + offset, n), static_cast<double>(expected),
+				dot_tolerance(x.data() + offset, y.data() + offset, n), "dot");
+		}
+	}
+
+	template <typename T>
+	void test_dot4(const simd::basic_kernel_table<T>& table, prng::generator& rng, const std::size_t offset)
+	{
+		for (std::size_t n = 0; n <= max_length; ++n)
+		{
+			std::vector<T> rows[4];
+			const T* pointers[4];
+			const auto y = random_vector<T>(rng, n + offset);
+			T result[4];
+
+			for (std::size_t k = 0; k < 4; ++k)
+			{
+				rows[k] = random_vector<T>(rng, n + offset);
+				pointers[k] = rows[k].data() + offset;
+			}
+
+			table.dot4(pointers, y.data() + offset, n, result);
+
+			for (std::size_t k = 0; k < 4; ++k)
+			{
+				long double expected = 0;
+				for (std::size_t i = 0; i < n; ++i) expected += static_cast<long double>(pointers[k][i]) * y[offset + i];
+				CHECK_CLOSE(result[k], static_cast<double>(expected), dot_tolerance(pointers[k], y.data() + offset, n), "dot4");
+			}
+		}
+	}
+
+	template <typename T>
+	void test_axpy(const simd::basic_kernel_table<T>& table, prng::generator& rng, const std::size_t offset)
+	{
+		const auto epsilon = std::numeric_limits<T>::epsilon();
+
+		for (std::size_t n = 0; n <= max_length; ++n)
+		{
+			const auto alpha = static_cast<T>(rng.uniform(-2.0, 2.0));
+			const auto x = random_vector<T>(rng, n + offset);
+			auto y = random_vector<T>(rng, n + offset + 1);
+			const auto original = y;
+
+			table.axpy(alpha, x.data() + offset, y.data() + offset, n);
+
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				const auto product = static_cast<long double>(alpha) * x[offset + i];
+				const auto expected = original[offset + i] + product;
+				const auto tolerance = 2.0 * epsilon * static_cast<double>(std::fabs(product) + std::fabs(original[offset + i]));
+				CHECK_CLOSE(y[offset + i], static_cast<double>(expected), tolerance, "axpy");
+			}
+
+			/* Elementen utanför vektorn får inte skrivas: */
+			for (std::size_t i = 0; i < offset; ++i) CHECK(y[i] == original[i]);
+			CHECK(y[offset + n] == original[offset + n]);
+		}
+	}
+
+	template <typename T>
+	void test_axpy4(const simd::basic_kernel_table<T>& table, prng::generator& rng, const std::size_t offset)
+	{
+		const auto epsilon = std::numeric_limits<T>::epsilon();
+
+		for (std::size_t n = 0; n <= max_length; ++n)
+		{
+			std::vector<T> rows[4];
+			const T* pointers[4];
+			T alpha[4];
+			auto y = random_vector<T>(rng, n + offset + 1);
+			const auto original = y;
+
+			for (std::size_t k = 0; k < 4; ++k)
+			{
+				rows[k] = random_vector<T>(rng, n + offset);
+				pointers[k] = rows[k].data() + offset;
+				alpha[k] = static_cast<T>(rng.uniform(-2.0, 2.0));
+			}
+
+			table.axpy4(alpha, pointers, y.data() + offset, n);
+
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				long double expected = original[offset + i];
+				long double magnitude = std::fabs(original[offset + i]);
+
+				for (std::size_t k = 0; k < 4; ++k)
+				{
+					expected += static_cast<long double>(alpha[k]) * pointers[k][i];
+					magnitude += std::fabs(static_cast<long double>(alpha[k]) * pointers[k][i]);
+				}
+
+				CHECK_CLOSE(y[offset + i], static_cast<double>(expected), 5.0 * epsilon * static_cast<double>(magnitude), "axpy4");
+			}
+
+			CHECK(y[offset + n] == original[offset + n]);
+		}
+	}
+
+	/***
+	* Funktionen test_tanh: Vektoriserad tanh jämförs med den skalära
+	* approximationen (samma formel), inklusive värden utanför klampgränsen.
+	**/
+	template <typename T>
+	void test_tanh(const simd::basic_kernel_table<T>& table, prng::generator& rng, const std::size_t offset)
+	{
+		const auto tolerance = 4.0 * std::numeric_limits<T>::epsilon();
+
+		for (std::size_t n = 0; n <= max_length; ++n)
+		{
+			auto x = random_vector<T>(rng, n + offset + 1, -10.0, 10.0);
+			const auto original = x;
+
+			table.tanh(x.data() + offset, n);
+
+			double max_error = 0.0;
+
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				const auto expected = simd::detail::tanh_rational(original[offset + i]);
+				const auto error = std::fabs(static_cast<double>(x[offset + i]) - static_cast<double>(expected));
+				if (error > max_error) max_error = error;
+			}
+
+			CHECK_CLOSE(max_error, 0.0, tolerance, "tanh");
+			CHECK(x[offset + n] == original[offset + n]);
+		}
+	}
+
+	/***
+	* Funktionen test_gemv_t: gemv_t adderar en rad i taget med axpy. Varje
+	* nivå testas genom samma beräkning med nivåns axpy, och den publika
+	* simd::gemv_t (med processorns bästa nivå) jämförs med referensen.
+	**/
+	template <typename T>
+	void test_gemv_t(const simd::basic_kernel_table<T>& table, prng::generator& rng)
+	{
+		const auto epsilon = std::numeric_limits<T>::epsilon();
+
+		for (std::size_t rows = 0; rows <= max_rows; ++rows)
+		{
+			for (std::size_t cols = 0; cols <= max_length; ++cols)
+			{
+				basic_matrix<T> a(rows, cols);
+				const auto x = random_vector<T>(rng, rows);
+				std::vector<T> y(cols + 1, T(7));
+				std::vector<T> y_level(cols, T(0));
+
+				for (std::size_t i = 0; i < rows; ++i)
+				{
+					for (std::size_t j = 0; j < cols; ++j) a(i, j) = static_cast<T>(rng.uniform(-1.0, 1.0));
+				}
+
+				const auto& constant = a;
+				simd::gemv_t(constant.view(), x.data(), y.data());
+
+				for (std::size_t i = 0; i < rows; ++i)
+				{
+					table.axpy(x[i], a.row(i), y_level.data(), cols);
+				}
+
+				for (std::size_t j = 0; j < cols; ++j)
+				{
+					long double expected = 0;
+					long double magnitude = 0;
+
+					for (std::size_t i = 0; i < rows; ++i)
+					{
+						expected += static_cast<long double>(a(i, j)) * x[i];
+						magnitude += std::fabs(static_cast<long double>(a(i, j)) * x[i]);
+					}
+
+					const auto tolerance = 2.0 * (rows + 1) * epsilon * static_cast<double>(magnitude);
+					CHECK_CLOSE(y[j], static_cast<double>(expected), tolerance, "gemv_t");
+					CHECK_CLOSE(y_level[j], static_cast<double>(expected), tolerance, "gemv_t (level axpy)");
+				}
+
+				CHECK(y[cols] == T(7));
+			}
+		}
+	}
+
+	template <typename T>
+	void test_type(const char* type_name)
+	{
+		const simd::isa levels[] = { simd::isa::scalar, simd::isa::sse2, simd::isa::avx2, simd::isa::avx512 };
+
+		for (const auto level : levels)
+		{
+			if (level != simd::isa::scalar && !simd::detail::cpu_supports(level))
+			{
+				std::printf("  %-6s %-6s skipped (not supported by this processor)\n", type_name, isa_name(level));
+				continue;
+			}
+
+			const auto table = simd::kernels_for<T>(level);
+			const auto failures = test::failures();
+			prng::generator rng(static_cast<std::uint64_t>(level) + 1);
+
+			CHECK(table.level == level);
+
+			for (std::size_t offset = 0; offset < 2; ++offset)
+			{
+				test_dot(table, rng, offset);
+				test_dot4(table, rng, offset);
+				test_axpy(table, rng, offset);
+				test_axpy4(table, rng, offset);
+				test_tanh(table, rng, offset);
+			}
+
+			test_gemv_t(table, rng);
+			std::printf("  %-6s %-6s %s\n", type_name, isa_name(level), test::failures() == failures ? "ok" : "FAILED");
+		}
+	}
+}
+
+void simd_kernel_tests(void)
+{
+	test_type<double>("double");
+	test_type<float>("float");
+	return;
+}
@@ -0,0 +1,79 @@
+/********************************************************************************
+* train_parallel_test.cpp: Kontrollerar att train_parallel ger samma vikter
+*                          och samma fel som train med samma batchstorlek,
+*                          bortsett från avrundningsskillnader till följd av
+*                          summeringsordningen, för ett till fyra trådar samt
+*                          för batchstorlekar som inte är jämnt delbara med
+*                          antalet trådar.
+********************************************************************************/
+#include "check.hpp"
+#include "ann.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace
+{
+	/***
+	* Funktionen reference_network: Returnerar ett nätverk med fem insignaler,
+	* två dolda lager och två utsignaler samt 37 deterministiskt genererade
+	* träningsuppsättningar. Varje anrop ger identiska startvärden.
+	**/
+	ann reference_network(void)
+	{
+		std::vector<std::vector<double>> inputs, outputs;
+
+		for (unsigned i = 0; i < 37; ++i)
+		{
+			std::vector<double> input;
+
+			for (unsigned j = 0; j < 5; ++j)
+			{
+				input.push_back(std::sin(1.7 * i + 0.9 * j));
+			}
+
+			inputs.push_back(input);
+			outputs.push_back({ input[0] * input[1] > 0 ? 1.0 : 0.0, 0.5 + 0.5 * std::cos(input[2] + input[3]) });
+		}
+
+		ann network(5, 2, 6, 2);
+		network.set_training_data(inputs, outputs);
+		network.seed(7);
+		return network;
+	}
+}
+
+void train_parallel_tests(void)
+{
+	const std::size_t num_epochs = 40;
+	const double learning_rate = 0.1;
+
+	for (const std::size_t batch_size : { 4, 7, 16 })
+	{
+		auto serial = reference_network();
+		const auto expected = serial.train(num_epochs, learning_rate, batch_size);
+		std::vector<double> reference;
+		serial.snapshot(reference);
+
+		for (std::size_t num_threads = 1; num_threads <= 4; ++num_threads)
+		{
+			auto parallel = reference_network();
+			thread_pool pool(num_threads);
+			const auto result = parallel.train_parallel(pool, num_epochs, learning_rate, batch_size);
+			std::vector<double> weights;
+			parallel.snapshot(weights);
+
+			CHECK(result.epochs == expected.epochs);
+			CHECK_CLOSE(result.loss, expected.loss, 1e-9, "loss");
+			if (!CHECK(weights.size() == reference.size())) continue;
+
+			for (std::size_t i = 0; i < weights.size(); ++i)
+			{
+				CHECK_CLOSE(weights[i], reference[i], 1e-9, "weight");
+			}
+		}
+	}
+
+	return;
+}
@@ -0,0 +1,108 @@
+/********************************************************************************
+* truth_table_test.cpp: Kontrollerar att uppslagningen i tabellen från
+*                       compile_truth_table ger samma tröskelvärdade
+*                       utsignaler som prediktion följd av tröskling vid 0.5,
+*                       för samtliga 2^K kombinationer av binära insignaler,
+*                       både för nätverk med en utgång och med flera utgångar.
+********************************************************************************/
+#include "check.hpp"
+#include "ann.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+	/***
+	* Funktionen threshold: Returnerar utsignalerna tröskelvärdade som i
+	* predict_thresholded, dvs. bit i är satt om utsignal i är minst 0.5.
+	**/
+	std::uint64_t threshold(const std::vector<double>& output)
+	{
+		std::uint64_t bits = 0;
+
+		for (std::size_t i = 0; i < output.size() && i < 64; ++i)
+		{
+			if (output[i] + 0.5 >= 1.0) bits |= static_cast<std::uint64_t>(1) << i;
+		}
+
+		return bits;
+	}
+
+	/***
+	* Funktionen check_table: Kompilerar sanningstabellen för angivet nätverk
+	* med num_inputs ingångar och jämför uppslagningen med predict följd av
+	* tröskling för samtliga kombinationer. Returnerar antalet kombinationer
+	* där minst en utsignal är satt, så att testet kan kontrollera att
+	* tabellen inte är trivial.
+	**/
+	std::size_t check_table(ann& network, const std::size_t num_inputs)
+	{
+		if (!CHECK(network.compile_truth_table())) return 0;
+
+		inference_context table_context, predict_context;
+		std::vector<double> input(num_inputs);
+		std::size_t num_set = 0;
+
+		for (std::size_t index = 0; index < (static_cast<std::size_t>(1) << num_inputs); ++index)
+		{
+			for (std::size_t j = 0; j < num_inputs; ++j)
+			{
+				input[j] = static_cast<double>((index >> j) & 1);
+			}
+
+			const auto expected = threshold(network.predict(input, predict_context));
+			CHECK(network.predict_thresholded(input, table_context) == expected);
+			if (expected) num_set++;
+		}
+
+		return num_set;
+	}
+}
+
+void truth_table_tests(void)
+{
+	/* Pariteten av fyra knappar med en utgång, som i main.cpp: */
+	{
+		std::vector<std::vector<double>> inputs, outputs;
+
+		for (unsigned value = 0; value < 16; ++value)
+		{
+			inputs.push_back({ double(value >> 3 & 1), double(value >> 2 & 1), double(value >> 1 & 1), double(value & 1) });
+			outputs.push_back({ double((value ^ value >> 1 ^ value >> 2 ^ value >> 3) & 1) });
+		}
+
+		ann network(4, 1, 8, 1);
+		network.set_training_data(inputs, outputs);
+		network.set_optimizer(optimizer::type::nesterov);
+		network.seed(1);
+		network.train(2000, 0.03);
+		CHECK(check_table(network, 4) > 0);
+	}
+
+	/* Tre utgångar (and, or och xor av de två första av fem insignaler): */
+	{
+		std::vector<std::vector<double>> inputs, outputs;
+
+		for (unsigned value = 0; value < 32; ++value)
+		{
+			const unsigned a = value & 1, b = value >> 1 & 1;
+			inputs.push_back({ double(a), double(b), double(value >> 2 & 1), double(value >> 3 & 1), double(value >> 4 & 1) });
+			outputs.push_back({ double(a & b), double(a | b), double(a ^ b) });
+		}
+
+		ann network(5, 2, 8, 3);
+		network.set_training_data(inputs, outputs);
+		network.set_optimizer(optimizer::type::nesterov);
+		network.seed(3);
+		network.train(2000, 0.03);
+		CHECK(check_table(network, 5) > 0);
+
+		/* Fortsatt träning tömmer tabellen, som därefter kompileras om: */
+		network.train(10, 0.03);
+		CHECK(check_table(network, 5) > 0);
+	}
+
+	return;
+}
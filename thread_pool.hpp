@@ -0,0 +1,151 @@
+#ifndef THREAD_POOL_HPP_
+#define THREAD_POOL_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstddef>
+
+/********************************************************************************
+* thread_pool: Trådpool med ett fast antal trådar för fork/join-parallellism.
+*              Vid anrop av run exekveras angiven uppgift en gång per tråd,
+*              där anropande tråd själv utför uppgift 0. Anropet returnerar
+*              först när samtliga trådar är klara, vilket gör att varje anrop
+*              fungerar som en barriär.
+********************************************************************************/
+class thread_pool
+{
+public:
+	explicit thread_pool(const std::size_t num_threads = std::thread::hardware_concurrency())
+	{
+		const auto count = num_threads ? num_threads : 1;
+
+		for (std::size_t i = 1; i < count; ++i)
+		{
+			this->workers.emplace_back(&thread_pool::worker_loop, this, i);
+		}
+
+		return;
+	}
+
+	~thread_pool(void)
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->stopping = true;
+			++this->generation;
+		}
+
+		this->start_signal.notify_all();
+
+		for (auto& worker : this->workers)
+		{
+			worker.join();
+		}
+
+		return;
+	}
+
+	thread_pool(const thread_pool&) = delete;
+	thread_pool& operator=(const thread_pool&) = delete;
+
+	/********************************************************************************
+	* size: Returnerar antalet trådar i poolen, inklusive anropande tråd.
+	********************************************************************************/
+	inline std::size_t size(void) const
+	{
+		return this->workers.size() + 1;
+	}
+
+	/********************************************************************************
+	* run: Exekverar task(i) för i = 0 ... size() - 1, en gång per tråd, och
+	*      väntar tills samtliga anrop är klara.
+	*
+	*      - task: Uppgift som tar trådens index som argument.
+	********************************************************************************/
+	void run(const std::function<void(std::size_t)>& task)
+	{
+		if (this->workers.empty())
+		{
+			task(0);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->current_task = &task;
+			this->remaining = this->workers.size();
+			++this->generation;
+		}
+
+		this->start_signal.notify_all();
+		task(0);
+
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->done_signal.wait(lock, [this]() { return this->remaining == 0; });
+		this->current_task = nullptr;
+		return;
+	}
+
+	/********************************************************************************
+	* parallel_for: Delar upp intervallet [0, n) i sammanhängande delar, en per
+	*               tråd, och anropar body(first, last) för varje del.
+	*
+	*               - n   : Antalet element som ska behandlas.
+	*               - body: Funktion som behandlar elementen first ... last - 1.
+	********************************************************************************/
+	void parallel_for(const std::size_t n,
+		const std::function<void(std::size_t, std::size_t)>& body)
+	{
+		const auto num_threads = this->size();
+
+		this->run([&](const std::size_t id)
+		{
+			const auto first = n * id / num_threads;
+			const auto last = n * (id + 1) / num_threads;
+			if (first < last) body(first, last);
+		});
+
+		return;
+	}
+
+private:
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable start_signal;
+	std::condition_variable done_signal;
+	const std::function<void(std::size_t)>* current_task = nullptr;
+	std::size_t remaining = 0;
+	std::size_t generation = 0;
+	bool stopping = false;
+
+	void worker_loop(const std::size_t id)
+	{
+		std::size_t seen = 0;
+
+		while (true)
+		{
+			const std::function<void(std::size_t)>* task = nullptr;
+
+			{
+				std::unique_lock<std::mutex> lock(this->mutex);
+				this->start_signal.wait(lock, [&]() { return this->generation != seen; });
+				seen = this->generation;
+				if (this->stopping) return;
+				task = this->current_task;
+			}
+
+			(*task)(id);
+
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+				if (--this->remaining == 0) this->done_signal.notify_one();
+			}
+		}
+	}
+};
+
+#endif /* THREAD_POOL_HPP_ */
@@ -0,0 +1,421 @@
+#ifndef TRAINING_DATA_HPP_
+#define TRAINING_DATA_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <cstddef>
+#include <cstdlib>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "matrix.hpp"
+
+/********************************************************************************
+* basic_sample_view: Icke-ägande vy över träningsuppsättningar, en rad per
+*                    uppsättning med cols element vardera. Raderna kan antingen
+*                    ligga i en sammanhängande radvis buffert med angiven
+*                    stride (exempelvis en matrix eller en inläst fil) eller
+*                    vara utspridda, där en tabell med pekare anger var varje
+*                    rad börjar (exempelvis data() för varje vektor i en
+*                    vector<vector<T>>). Data kopieras aldrig, utan måste
+*                    finnas kvar så länge vyn används.
+********************************************************************************/
+template <typename T>
+struct basic_sample_view
+{
+	const T* data = nullptr;
+	const T* const* rows = nullptr;
+	std::size_t num_rows = 0;
+	std::size_t cols = 0;
+	std::size_t stride = 0;
+
+	basic_sample_view(void) { }
+
+	basic_sample_view(const T* data,
+		const std::size_t num_rows,
+		const std::size_t cols,
+		const std::size_t stride)
+		: data(data), num_rows(num_rows), cols(cols), stride(stride) { }
+
+	basic_sample_view(const basic_const_matrix_view<T>& view)
+		: data(view.data), num_rows(view.rows), cols(view.cols), stride(view.stride) { }
+
+	basic_sample_view(const basic_matrix_view<T>& view)
+		: data(view.data), num_rows(view.rows), cols(view.cols), stride(view.stride) { }
+
+	basic_sample_view(const T* const* rows,
+		const std::size_t num_rows,
+		const std::size_t cols)
+		: rows(rows), num_rows(num_rows), cols(cols) { }
+
+	inline std::size_t size(void) const { return this->num_rows; }
+	inline bool empty(void) const { return this->num_rows == 0; }
+
+	inline const T* row(const std::size_t i) const
+	{
+		return this->rows ? this->rows[i] : this->data + i * this->stride;
+	}
+
+	inline const T* operator[](const std::size_t i) const { return this->row(i); }
+};
+
+/********************************************************************************
+* basic_sample_stream: Läser träningsuppsättningar från fil i block om högst
+*                      chunk_rows uppsättningar, så att data som inte ryms i
+*                      minnet kan användas för träning. En bakgrundstråd läser
+*                      nästa block till en andra buffert medan föregående block
+*                      används (dubbelbuffring), vilket gör att träningen
+*                      normalt inte behöver vänta på disken.
+*
+*                      När filen är slut börjar tråden direkt om från början,
+*                      så att första blocket i nästa genomgång (epok) redan är
+*                      inläst. next returnerar nullptr en gång mellan varje
+*                      genomgång.
+*
+*                      Filformat:
+*                      - csv   : En uppsättning per rad med num_inputs indata
+*                                följt av num_outputs referensvärden, åtskilda
+*                                av kommatecken, semikolon eller blanksteg.
+*                                Tomma rader, kommentarer (#) och rader som
+*                                inte kan tolkas, exempelvis rubriker, hoppas
+*                                över.
+*                      - binary: Uppsättningarna lagras i följd utan huvud som
+*                                num_inputs + num_outputs värden av typen
+*                                double i värdmaskinens byteordning.
+********************************************************************************/
+template <typename T>
+class basic_sample_stream
+{
+public:
+	typedef basic_matrix<T> matrix;
+
+	enum class format { csv, binary };
+
+	/********************************************************************************
+	* chunk: Ett inläst block med rows uppsättningar i matriserna inputs och
+	*        references, vars storlek är chunk_rows rader.
+	********************************************************************************/
+	struct chunk
+	{
+		matrix inputs;
+		matrix references;
+		std::size_t rows = 0;
+		bool last = false;
+
+		basic_sample_view<T> input_view(void) const
+		{
+			return basic_sample_view<T>(this->inputs.data(), this->rows, this->inputs.cols(), this->inputs.stride());
+		}
+
+		basic_sample_view<T> reference_view(void) const
+		{
+			return basic_sample_view<T>(this->references.data(), this->rows, this->references.cols(), this->references.stride());
+		}
+	};
+
+	basic_sample_stream(void) { }
+
+	~basic_sample_stream(void)
+	{
+		this->close();
+		return;
+	}
+
+	basic_sample_stream(const basic_sample_stream&) = delete;
+	basic_sample_stream& operator=(const basic_sample_stream&) = delete;
+
+	inline bool is_open(void) const { return this->loader.joinable(); }
+	inline std::size_t num_inputs(void) const { return this->slots[0].inputs.cols(); }
+	inline std::size_t num_outputs(void) const { return this->slots[0].references.cols(); }
+	inline std::size_t chunk_rows(void) const { return this->slots[0].inputs.rows(); }
+
+	/********************************************************************************
+	* open: Öppnar angiven fil och startar inläsningen av första blocket i
+	*       bakgrunden. Eventuell tidigare öppnad fil stängs först. Returnerar
+	*       true om filen kunde öppnas.
+	*
+	*       - path       : Sökväg till filen.
+	*       - type       : Filformatet (csv eller binary).
+	*       - num_inputs : Antalet indata per uppsättning.
+	*       - num_outputs: Antalet referensvärden per uppsättning.
+	*       - chunk_rows : Högsta antalet uppsättningar per block (default = 4096).
+	********************************************************************************/
+	bool open(const std::string& path,
+		const format type,
+		const std::size_t num_inputs,
+		const std::size_t num_outputs,
+		const std::size_t chunk_rows = 4096)
+	{
+		this->close();
+		if (num_inputs == 0 || num_outputs == 0 || chunk_rows == 0) return false;
+
+		this->file.open(path, std::ios::in | std::ios::binary);
+		if (!this->file) return false;
+
+		for (auto& slot : this->slots)
+		{
+			slot.inputs.resize(chunk_rows, num_inputs);
+			slot.references.resize(chunk_rows, num_outputs);
+			slot.rows = 0;
+			slot.last = false;
+		}
+
+		this->type = type;
+		this->head = 0;
+		this->tail = 0;
+		this->queued = 0;
+		this->pass_rows = 0;
+		this->held = false;
+		this->active = true;
+		this->busy = false;
+		this->stopping = false;
+		this->exhausted = false;
+		this->loader = std::thread(&basic_sample_stream::load_loop, this);
+		return true;
+	}
+
+	void close(void)
+	{
+		if (this->loader.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+				this->stopping = true;
+			}
+
+			this->signal.notify_all();
+			this->loader.join();
+		}
+
+		this->file.close();
+		this->file.clear();
+		return;
+	}
+
+	/********************************************************************************
+	* next: Returnerar nästa inlästa block och väntar vid behov tills det är
+	*       klart. Föregående block lämnas samtidigt tillbaka för inläsning och
+	*       får inte längre användas. Returnerar nullptr efter sista blocket i
+	*       varje genomgång, eller om filen saknar uppsättningar.
+	********************************************************************************/
+	const chunk* next(void)
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+
+		if (this->held)
+		{
+			const auto last = this->slots[this->head].last;
+			this->held = false;
+			this->head ^= 1;
+			this->signal.notify_all();
+			if (last) return nullptr;
+		}
+
+		this->signal.wait(lock, [this] { return this->queued > 0 || this->exhausted; });
+		if (this->queued == 0) return nullptr;
+
+		auto& slot = this->slots[this->head];
+		this->queued--;
+
+		/* Ett tomt block markerar slutet på en genomgång vars sista block
+		   inte kunde markeras i förväg: */
+		if (slot.rows == 0)
+		{
+			this->head ^= 1;
+			this->signal.notify_all();
+			return nullptr;
+		}
+
+		this->held = true;
+		return &slot;
+	}
+
+	/********************************************************************************
+	* rewind: Börjar om från filens början, så att nästa anrop av next
+	*         returnerar första blocket. Redan inlästa block kastas.
+	********************************************************************************/
+	void rewind(void)
+	{
+		if (!this->is_open()) return;
+		std::unique_lock<std::mutex> lock(this->mutex);
+
+		this->active = false;
+		this->signal.notify_all();
+		this->signal.wait(lock, [this] { return !this->busy; });
+
+		this->file.clear();
+		this->file.seekg(0);
+		this->head = 0;
+		this->tail = 0;
+		this->queued = 0;
+		this->pass_rows = 0;
+		this->held = false;
+		this->exhausted = false;
+		this->active = true;
+		this->signal.notify_all();
+		return;
+	}
+
+private:
+	std::ifstream file;
+	format type = format::csv;
+	chunk slots[2];
+	std::vector<double> record;
+	std::string line;
+	std::thread loader;
+	std::mutex mutex;
+	std::condition_variable signal;
+	std::size_t head = 0;
+	std::size_t tail = 0;
+	std::size_t queued = 0;
+	std::size_t pass_rows = 0;
+	bool held = false;
+	bool active = false;
+	bool busy = false;
+	bool stopping = false;
+	bool exhausted = false;
+
+	/********************************************************************************
+	* load_loop: Bakgrundstrådens huvudloop. Ett block läses in så fort en
+	*            buffert är ledig, dvs. varken väntar på eller används av next.
+	*            Filen läses utan lås, medan övriga medlemmar enbart ändras med
+	*            låset taget.
+	********************************************************************************/
+	void load_loop(void)
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+
+		while (true)
+		{
+			this->signal.wait(lock, [this]
+			{
+				return this->stopping || (this->active && !this->exhausted && this->queued + (this->held ? 1 : 0) < 2);
+			});
+
+			if (this->stopping) return;
+
+			auto& slot = this->slots[this->tail];
+			this->busy = true;
+			lock.unlock();
+
+			this->read_chunk(slot);
+
+			if (slot.last)
+			{
+				this->file.clear();
+				this->file.seekg(0);
+			}
+
+			lock.lock();
+			this->busy = false;
+
+			if (this->active)
+			{
+				/* En fil utan uppsättningar (eller som inte kan läsas) skulle
+				   annars ge en ändlös följd av tomma genomgångar: */
+				if (slot.rows == 0 && this->pass_rows == 0)
+				{
+					this->exhausted = true;
+				}
+				else
+				{
+					this->tail ^= 1;
+					this->queued++;
+				}
+
+				this->pass_rows = slot.last ? 0 : this->pass_rows + slot.rows;
+			}
+
+			this->signal.notify_all();
+		}
+	}
+
+	/********************************************************************************
+	* read_chunk: Läser in upp till chunk_rows uppsättningar till angiven
+	*             buffert och markerar blocket som sist om filen tog slut.
+	********************************************************************************/
+	void read_chunk(chunk& slot)
+	{
+		const auto num_inputs = slot.inputs.cols();
+		const auto num_outputs = slot.references.cols();
+		const auto width = num_inputs + num_outputs;
+
+		this->record.resize(width);
+		slot.rows = 0;
+		slot.last = false;
+
+		while (slot.rows < slot.inputs.rows())
+		{
+			if (!this->read_record(width))
+			{
+				slot.last = true;
+				return;
+			}
+
+			auto input = slot.inputs.row(slot.rows);
+			auto reference = slot.references.row(slot.rows);
+
+			for (std::size_t j = 0; j < num_inputs; ++j)
+			{
+				input[j] = static_cast<T>(this->record[j]);
+			}
+
+			for (std::size_t j = 0; j < num_outputs; ++j)
+			{
+				reference[j] = static_cast<T>(this->record[num_inputs + j]);
+			}
+
+			slot.rows++;
+		}
+
+		slot.last = this->file.peek() == std::char_traits<char>::eof();
+		return;
+	}
+
+	/********************************************************************************
+	* read_record: Läser nästa uppsättning till record. Returnerar false när
+	*              filen är slut.
+	********************************************************************************/
+	bool read_record(const std::size_t width)
+	{
+		if (this->type == format::binary)
+		{
+			const auto size = static_cast<std::streamsize>(width * sizeof(double));
+			this->file.read(reinterpret_cast<char*>(this->record.data()), size);
+			return this->file.gcount() == size;
+		}
+
+		while (std::getline(this->file, this->line))
+		{
+			if (this->parse_line(width)) return true;
+		}
+
+		return false;
+	}
+
+	bool parse_line(const std::size_t width)
+	{
+		const char* position = this->line.c_str();
+
+		for (std::size_t j = 0; j < width; ++j)
+		{
+			while (*position == ' ' || *position == '\t' || *position == ',' || *position == ';') position++;
+			if (*position == '\0' || *position == '#') return false;
+
+			char* end = nullptr;
+			this->record[j] = std::strtod(position, &end);
+			if (end == position) return false;
+			position = end;
+		}
+
+		return true;
+	}
+};
+
+typedef basic_sample_view<double> sample_view;
+typedef basic_sample_stream<double> sample_stream;
+
+#endif /* TRAINING_DATA_HPP_ */
@@ -0,0 +1,155 @@
+#ifndef TRAINING_MONITOR_HPP_
+#define TRAINING_MONITOR_HPP_
+
+/* Inkluderingsdirektiv: */
+#include <cstddef>
+#include <functional>
+#include <limits>
+
+#include "profiling.hpp"
+
+/********************************************************************************
+* training: Uppföljning av träningen. Medelkvadratfelet (MSE) beräknas utifrån
+*           de utsignaler som ändå tas fram vid träningen, dvs. innan vikterna
+*           uppdateras för respektive träningsuppsättning. Det kostar enbart
+*           en subtraktion och en multiplikation per utsignal, men innebär att
+*           felet släpar något efter nätverkets faktiska fel efter epoken.
+********************************************************************************/
+namespace training
+{
+	/********************************************************************************
+	* stopping: Villkor för att avbryta träningen i förtid.
+	*
+	*           - interval   : Antalet epoker mellan varje utvärdering av felet
+	*                          (och anrop av eventuell callback).
+	*           - target_loss: Träningen avbryts när felet understiger detta
+	*                          värde, 0 = inaktiverat.
+	*           - patience   : Träningen avbryts när felet inte har minskat med
+	*                          minst min_delta under så många utvärderingar i
+	*                          följd, 0 = inaktiverat.
+	*           - min_delta  : Minsta minskning som räknas som en förbättring.
+	********************************************************************************/
+	struct stopping
+	{
+		std::size_t interval = 1;
+		double target_loss = 0.0;
+		std::size_t patience = 0;
+		double min_delta = 0.0;
+	};
+
+	/********************************************************************************
+	* stop_reason: Anger varför träningen avslutades.
+	********************************************************************************/
+	enum class stop_reason { completed, target_reached, plateau, callback };
+
+	/********************************************************************************
+	* progress: Skickas till eventuell callback vid varje utvärdering.
+	*
+	*           - epoch        : Antalet genomförda epoker.
+	*           - num_epochs   : Högsta antalet epoker.
+	*           - loss         : Medelkvadratfelet under senaste epoken.
+	*           - best_loss    : Lägsta felet hittills.
+	*           - learning_rate: Lärhastigheten under senaste epoken.
+	********************************************************************************/
+	struct progress
+	{
+		std::size_t epoch;
+		std::size_t num_epochs;
+		double loss;
+		double best_loss;
+		double learning_rate;
+	};
+
+	/********************************************************************************
+	* result: Returneras av ann::train.
+	*
+	*         - epochs: Antalet genomförda epoker.
+	*         - loss  : Medelkvadratfelet vid senaste utvärderingen.
+	*         - reason: Anledningen till att träningen avslutades.
+	********************************************************************************/
+	struct result
+	{
+		std::size_t epochs = 0;
+		double loss = std::numeric_limits<double>::quiet_NaN();
+		stop_reason reason = stop_reason::completed;
+	};
+
+	/* Anropas vid varje utvärdering. Returnerar false för att avbryta träningen. */
+	typedef std::function<bool(const progress&)> callback;
+
+	/********************************************************************************
+	* monitor: Utvärderar villkoren för att avbryta träningen efter varje epok.
+	********************************************************************************/
+	class monitor
+	{
+	public:
+		monitor(const stopping& criteria,
+			const callback& function,
+			const std::size_t num_epochs)
+			: criteria(criteria), function(function), num_epochs(num_epochs) { }
+
+		/********************************************************************************
+		* update: Anropas efter varje epok. Felet utvärderas var interval:e epok
+		*         samt efter sista epoken. Returnerar false om träningen ska
+		*         avbrytas.
+		*
+		*         - epoch        : Index för epoken som just genomförts, från noll.
+		*         - loss         : Medelkvadratfelet under epoken.
+		*         - learning_rate: Lärhastigheten under epoken.
+		********************************************************************************/
+		bool update(const std::size_t epoch, const double loss, const double learning_rate)
+		{
+			this->timer.lap(epoch, loss);
+			const auto completed = epoch + 1;
+			const auto interval = this->criteria.interval ? this->criteria.interval : 1;
+
+			this->outcome.epochs = completed;
+			if (completed % interval != 0 && completed != this->num_epochs) return true;
+
+			this->outcome.loss = loss;
+
+			if (loss < this->best_loss - this->criteria.min_delta)
+			{
+				this->best_loss = loss;
+				this->stale_evaluations = 0;
+			}
+			else
+			{
+				this->stale_evaluations++;
+			}
+
+			if (this->function && !this->function(progress{ completed, this->num_epochs, loss, this->best_loss, learning_rate }))
+			{
+				this->outcome.reason = stop_reason::callback;
+				return false;
+			}
+
+			if (loss < this->criteria.target_loss)
+			{
+				this->outcome.reason = stop_reason::target_reached;
+				return false;
+			}
+
+			if (this->criteria.patience && this->stale_evaluations >= this->criteria.patience)
+			{
+				this->outcome.reason = stop_reason::plateau;
+				return false;
+			}
+
+			return true;
+		}
+
+		inline const result& get_result(void) const { return this->outcome; }
+
+	private:
+		stopping criteria;
+		const callback& function;
+		std::size_t num_epochs;
+		double best_loss = std::numeric_limits<double>::infinity();
+		std::size_t stale_evaluations = 0;
+		result outcome;
+		profiling::epoch_timer timer;
+	};
+}
+
+#endif /* TRAINING_MONITOR_HPP_ */